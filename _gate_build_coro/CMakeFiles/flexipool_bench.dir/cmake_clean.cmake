@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/flexipool_bench.dir/bench/flexipool_bench.cpp.o"
+  "CMakeFiles/flexipool_bench.dir/bench/flexipool_bench.cpp.o.d"
+  "bin/flexipool_bench"
+  "bin/flexipool_bench.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/flexipool_bench.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
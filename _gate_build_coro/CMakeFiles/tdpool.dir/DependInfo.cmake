@@ -0,0 +1,33 @@
+
+# Consider dependencies only in project.
+set(CMAKE_DEPENDS_IN_PROJECT_ONLY OFF)
+
+# The set of languages for which implicit dependencies are needed:
+set(CMAKE_DEPENDS_LANGUAGES
+  )
+
+# The set of dependency files which are needed:
+set(CMAKE_DEPENDS_DEPENDENCY_FILES
+  "/root/repo/src/completion.cpp" "CMakeFiles/tdpool.dir/src/completion.cpp.o" "gcc" "CMakeFiles/tdpool.dir/src/completion.cpp.o.d"
+  "/root/repo/src/cputopology.cpp" "CMakeFiles/tdpool.dir/src/cputopology.cpp.o" "gcc" "CMakeFiles/tdpool.dir/src/cputopology.cpp.o.d"
+  "/root/repo/src/elasticity.cpp" "CMakeFiles/tdpool.dir/src/elasticity.cpp.o" "gcc" "CMakeFiles/tdpool.dir/src/elasticity.cpp.o.d"
+  "/root/repo/src/executorgroup.cpp" "CMakeFiles/tdpool.dir/src/executorgroup.cpp.o" "gcc" "CMakeFiles/tdpool.dir/src/executorgroup.cpp.o.d"
+  "/root/repo/src/logger.cpp" "CMakeFiles/tdpool.dir/src/logger.cpp.o" "gcc" "CMakeFiles/tdpool.dir/src/logger.cpp.o.d"
+  "/root/repo/src/pipeline.cpp" "CMakeFiles/tdpool.dir/src/pipeline.cpp.o" "gcc" "CMakeFiles/tdpool.dir/src/pipeline.cpp.o.d"
+  "/root/repo/src/poolstats.cpp" "CMakeFiles/tdpool.dir/src/poolstats.cpp.o" "gcc" "CMakeFiles/tdpool.dir/src/poolstats.cpp.o.d"
+  "/root/repo/src/resultset.cpp" "CMakeFiles/tdpool.dir/src/resultset.cpp.o" "gcc" "CMakeFiles/tdpool.dir/src/resultset.cpp.o.d"
+  "/root/repo/src/strand.cpp" "CMakeFiles/tdpool.dir/src/strand.cpp.o" "gcc" "CMakeFiles/tdpool.dir/src/strand.cpp.o.d"
+  "/root/repo/src/taskallocator.cpp" "CMakeFiles/tdpool.dir/src/taskallocator.cpp.o" "gcc" "CMakeFiles/tdpool.dir/src/taskallocator.cpp.o.d"
+  "/root/repo/src/taskgraph.cpp" "CMakeFiles/tdpool.dir/src/taskgraph.cpp.o" "gcc" "CMakeFiles/tdpool.dir/src/taskgraph.cpp.o.d"
+  "/root/repo/src/taskgroup.cpp" "CMakeFiles/tdpool.dir/src/taskgroup.cpp.o" "gcc" "CMakeFiles/tdpool.dir/src/taskgroup.cpp.o.d"
+  "/root/repo/src/threadpool.cpp" "CMakeFiles/tdpool.dir/src/threadpool.cpp.o" "gcc" "CMakeFiles/tdpool.dir/src/threadpool.cpp.o.d"
+  "/root/repo/src/timerqueue.cpp" "CMakeFiles/tdpool.dir/src/timerqueue.cpp.o" "gcc" "CMakeFiles/tdpool.dir/src/timerqueue.cpp.o.d"
+  "/root/repo/src/tracer.cpp" "CMakeFiles/tdpool.dir/src/tracer.cpp.o" "gcc" "CMakeFiles/tdpool.dir/src/tracer.cpp.o.d"
+  )
+
+# Targets to which this target links.
+set(CMAKE_TARGET_LINKED_INFO_FILES
+  )
+
+# Fortran module output directory.
+set(CMAKE_Fortran_TARGET_MODULE_DIR "")
@@ -0,0 +1,39 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/tdpool.dir/src/completion.cpp.o"
+  "CMakeFiles/tdpool.dir/src/completion.cpp.o.d"
+  "CMakeFiles/tdpool.dir/src/cputopology.cpp.o"
+  "CMakeFiles/tdpool.dir/src/cputopology.cpp.o.d"
+  "CMakeFiles/tdpool.dir/src/elasticity.cpp.o"
+  "CMakeFiles/tdpool.dir/src/elasticity.cpp.o.d"
+  "CMakeFiles/tdpool.dir/src/executorgroup.cpp.o"
+  "CMakeFiles/tdpool.dir/src/executorgroup.cpp.o.d"
+  "CMakeFiles/tdpool.dir/src/logger.cpp.o"
+  "CMakeFiles/tdpool.dir/src/logger.cpp.o.d"
+  "CMakeFiles/tdpool.dir/src/pipeline.cpp.o"
+  "CMakeFiles/tdpool.dir/src/pipeline.cpp.o.d"
+  "CMakeFiles/tdpool.dir/src/poolstats.cpp.o"
+  "CMakeFiles/tdpool.dir/src/poolstats.cpp.o.d"
+  "CMakeFiles/tdpool.dir/src/resultset.cpp.o"
+  "CMakeFiles/tdpool.dir/src/resultset.cpp.o.d"
+  "CMakeFiles/tdpool.dir/src/strand.cpp.o"
+  "CMakeFiles/tdpool.dir/src/strand.cpp.o.d"
+  "CMakeFiles/tdpool.dir/src/taskallocator.cpp.o"
+  "CMakeFiles/tdpool.dir/src/taskallocator.cpp.o.d"
+  "CMakeFiles/tdpool.dir/src/taskgraph.cpp.o"
+  "CMakeFiles/tdpool.dir/src/taskgraph.cpp.o.d"
+  "CMakeFiles/tdpool.dir/src/taskgroup.cpp.o"
+  "CMakeFiles/tdpool.dir/src/taskgroup.cpp.o.d"
+  "CMakeFiles/tdpool.dir/src/threadpool.cpp.o"
+  "CMakeFiles/tdpool.dir/src/threadpool.cpp.o.d"
+  "CMakeFiles/tdpool.dir/src/timerqueue.cpp.o"
+  "CMakeFiles/tdpool.dir/src/timerqueue.cpp.o.d"
+  "CMakeFiles/tdpool.dir/src/tracer.cpp.o"
+  "CMakeFiles/tdpool.dir/src/tracer.cpp.o.d"
+  "lib/libtdpool.pdb"
+  "lib/libtdpool.so"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/tdpool.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
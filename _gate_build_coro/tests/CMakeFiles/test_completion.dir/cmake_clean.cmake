@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "../bin/test_completion"
+  "../bin/test_completion.pdb"
+  "CMakeFiles/test_completion.dir/test_completion.cpp.o"
+  "CMakeFiles/test_completion.dir/test_completion.cpp.o.d"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/test_completion.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "../bin/test_coroutine"
+  "../bin/test_coroutine.pdb"
+  "CMakeFiles/test_coroutine.dir/test_coroutine.cpp.o"
+  "CMakeFiles/test_coroutine.dir/test_coroutine.cpp.o.d"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/test_coroutine.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "../bin/test_executorgroup"
+  "../bin/test_executorgroup.pdb"
+  "CMakeFiles/test_executorgroup.dir/test_executorgroup.cpp.o"
+  "CMakeFiles/test_executorgroup.dir/test_executorgroup.cpp.o.d"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/test_executorgroup.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
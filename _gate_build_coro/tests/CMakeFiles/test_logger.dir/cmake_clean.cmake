@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "../bin/test_logger"
+  "../bin/test_logger.pdb"
+  "CMakeFiles/test_logger.dir/test_logger.cpp.o"
+  "CMakeFiles/test_logger.dir/test_logger.cpp.o.d"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/test_logger.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "../bin/test_mpmcqueue"
+  "../bin/test_mpmcqueue.pdb"
+  "CMakeFiles/test_mpmcqueue.dir/test_mpmcqueue.cpp.o"
+  "CMakeFiles/test_mpmcqueue.dir/test_mpmcqueue.cpp.o.d"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/test_mpmcqueue.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
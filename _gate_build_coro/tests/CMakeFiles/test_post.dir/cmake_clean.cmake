@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "../bin/test_post"
+  "../bin/test_post.pdb"
+  "CMakeFiles/test_post.dir/test_post.cpp.o"
+  "CMakeFiles/test_post.dir/test_post.cpp.o.d"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/test_post.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
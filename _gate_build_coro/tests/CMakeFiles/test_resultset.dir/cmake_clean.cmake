@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "../bin/test_resultset"
+  "../bin/test_resultset.pdb"
+  "CMakeFiles/test_resultset.dir/test_resultset.cpp.o"
+  "CMakeFiles/test_resultset.dir/test_resultset.cpp.o.d"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/test_resultset.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
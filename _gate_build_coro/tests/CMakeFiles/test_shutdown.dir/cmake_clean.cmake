@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "../bin/test_shutdown"
+  "../bin/test_shutdown.pdb"
+  "CMakeFiles/test_shutdown.dir/test_shutdown.cpp.o"
+  "CMakeFiles/test_shutdown.dir/test_shutdown.cpp.o.d"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/test_shutdown.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "../bin/test_strand"
+  "../bin/test_strand.pdb"
+  "CMakeFiles/test_strand.dir/test_strand.cpp.o"
+  "CMakeFiles/test_strand.dir/test_strand.cpp.o.d"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/test_strand.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
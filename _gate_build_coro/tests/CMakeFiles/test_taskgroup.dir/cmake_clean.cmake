@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "../bin/test_taskgroup"
+  "../bin/test_taskgroup.pdb"
+  "CMakeFiles/test_taskgroup.dir/test_taskgroup.cpp.o"
+  "CMakeFiles/test_taskgroup.dir/test_taskgroup.cpp.o.d"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/test_taskgroup.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
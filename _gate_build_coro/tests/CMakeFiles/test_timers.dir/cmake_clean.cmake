@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "../bin/test_timers"
+  "../bin/test_timers.pdb"
+  "CMakeFiles/test_timers.dir/test_timers.cpp.o"
+  "CMakeFiles/test_timers.dir/test_timers.cpp.o.d"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/test_timers.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
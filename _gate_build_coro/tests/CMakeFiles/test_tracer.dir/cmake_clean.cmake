@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "../bin/test_tracer"
+  "../bin/test_tracer.pdb"
+  "CMakeFiles/test_tracer.dir/test_tracer.cpp.o"
+  "CMakeFiles/test_tracer.dir/test_tracer.cpp.o.d"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/test_tracer.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
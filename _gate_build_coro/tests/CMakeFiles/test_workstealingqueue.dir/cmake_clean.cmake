@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "../bin/test_workstealingqueue"
+  "../bin/test_workstealingqueue.pdb"
+  "CMakeFiles/test_workstealingqueue.dir/test_workstealingqueue.cpp.o"
+  "CMakeFiles/test_workstealingqueue.dir/test_workstealingqueue.cpp.o.d"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/test_workstealingqueue.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,34 @@
+# CMake generated Testfile for 
+# Source directory: /root/repo/tests
+# Build directory: /root/repo/_gate_build_coro/tests
+# 
+# This file includes the relevant testing commands required for 
+# testing this directory and lists subdirectories to be tested as well.
+add_test(workstealingqueue "/root/repo/_gate_build_coro/bin/test_workstealingqueue")
+set_tests_properties(workstealingqueue PROPERTIES  TIMEOUT "120" _BACKTRACE_TRIPLES "/root/repo/tests/CMakeLists.txt;34;add_test;/root/repo/tests/CMakeLists.txt;0;")
+add_test(mpmcqueue "/root/repo/_gate_build_coro/bin/test_mpmcqueue")
+set_tests_properties(mpmcqueue PROPERTIES  TIMEOUT "120" _BACKTRACE_TRIPLES "/root/repo/tests/CMakeLists.txt;34;add_test;/root/repo/tests/CMakeLists.txt;0;")
+add_test(completion "/root/repo/_gate_build_coro/bin/test_completion")
+set_tests_properties(completion PROPERTIES  TIMEOUT "120" _BACKTRACE_TRIPLES "/root/repo/tests/CMakeLists.txt;34;add_test;/root/repo/tests/CMakeLists.txt;0;")
+add_test(strand "/root/repo/_gate_build_coro/bin/test_strand")
+set_tests_properties(strand PROPERTIES  TIMEOUT "120" _BACKTRACE_TRIPLES "/root/repo/tests/CMakeLists.txt;34;add_test;/root/repo/tests/CMakeLists.txt;0;")
+add_test(taskgroup "/root/repo/_gate_build_coro/bin/test_taskgroup")
+set_tests_properties(taskgroup PROPERTIES  TIMEOUT "120" _BACKTRACE_TRIPLES "/root/repo/tests/CMakeLists.txt;34;add_test;/root/repo/tests/CMakeLists.txt;0;")
+add_test(pipeline "/root/repo/_gate_build_coro/bin/test_pipeline")
+set_tests_properties(pipeline PROPERTIES  TIMEOUT "120" _BACKTRACE_TRIPLES "/root/repo/tests/CMakeLists.txt;34;add_test;/root/repo/tests/CMakeLists.txt;0;")
+add_test(shutdown "/root/repo/_gate_build_coro/bin/test_shutdown")
+set_tests_properties(shutdown PROPERTIES  TIMEOUT "120" _BACKTRACE_TRIPLES "/root/repo/tests/CMakeLists.txt;34;add_test;/root/repo/tests/CMakeLists.txt;0;")
+add_test(timers "/root/repo/_gate_build_coro/bin/test_timers")
+set_tests_properties(timers PROPERTIES  TIMEOUT "120" _BACKTRACE_TRIPLES "/root/repo/tests/CMakeLists.txt;34;add_test;/root/repo/tests/CMakeLists.txt;0;")
+add_test(logger "/root/repo/_gate_build_coro/bin/test_logger")
+set_tests_properties(logger PROPERTIES  TIMEOUT "120" _BACKTRACE_TRIPLES "/root/repo/tests/CMakeLists.txt;34;add_test;/root/repo/tests/CMakeLists.txt;0;")
+add_test(tracer "/root/repo/_gate_build_coro/bin/test_tracer")
+set_tests_properties(tracer PROPERTIES  TIMEOUT "120" _BACKTRACE_TRIPLES "/root/repo/tests/CMakeLists.txt;34;add_test;/root/repo/tests/CMakeLists.txt;0;")
+add_test(resultset "/root/repo/_gate_build_coro/bin/test_resultset")
+set_tests_properties(resultset PROPERTIES  TIMEOUT "120" _BACKTRACE_TRIPLES "/root/repo/tests/CMakeLists.txt;34;add_test;/root/repo/tests/CMakeLists.txt;0;")
+add_test(executorgroup "/root/repo/_gate_build_coro/bin/test_executorgroup")
+set_tests_properties(executorgroup PROPERTIES  TIMEOUT "120" _BACKTRACE_TRIPLES "/root/repo/tests/CMakeLists.txt;34;add_test;/root/repo/tests/CMakeLists.txt;0;")
+add_test(post "/root/repo/_gate_build_coro/bin/test_post")
+set_tests_properties(post PROPERTIES  TIMEOUT "120" _BACKTRACE_TRIPLES "/root/repo/tests/CMakeLists.txt;34;add_test;/root/repo/tests/CMakeLists.txt;0;")
+add_test(coroutine "/root/repo/_gate_build_coro/bin/test_coroutine")
+set_tests_properties(coroutine PROPERTIES  TIMEOUT "120" _BACKTRACE_TRIPLES "/root/repo/tests/CMakeLists.txt;34;add_test;/root/repo/tests/CMakeLists.txt;0;")
@@ -0,0 +1,362 @@
+/*
+线程池基准测试，结果以JSON格式输出到标准输出，便于在CI中跟踪和对比不同版本
+用法：flexipool_bench [--quick] [--tasks N] [--threads N]
+- throughput：空任务吞吐量，提交者数量从1到N
+- latency：提交到开始执行的延迟分位数
+- round_trip：提交一个任务并get()的往返开销，和std::async对比
+- burst：突发负载下FIXED与CACHED模式的对比
+- scaling：线程数量从1到hardware_concurrency()的扩展曲线
+- hot_counter：多个线程同时累加一个原子计数器与按线程分散累加的对比（线程池的忙碌计数使用后者）
+- trace_record：多个线程同时记录跟踪事件的开销，开启和关闭跟踪两种情况
+*/
+#include "threadpool.h"
+#include <future>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+using Clock = std::chrono::steady_clock;
+
+static int64_t nowNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count();
+}
+
+// 空任务：完成时门闩计数减一
+class EmptyTask : public Task
+{
+public:
+    explicit EmptyTask(CountDownLatch &latch) : latch_(latch) {}
+    Any run()
+    {
+        latch_.countDown();
+        return Any();
+    }
+
+private:
+    CountDownLatch &latch_;
+};
+
+// 记录开始执行时间的任务
+class StampTask : public Task
+{
+public:
+    StampTask(int64_t &start, CountDownLatch &latch) : start_(start), latch_(latch) {}
+    Any run()
+    {
+        start_ = nowNs();
+        latch_.countDown();
+        return Any();
+    }
+
+private:
+    int64_t &start_;
+    CountDownLatch &latch_;
+};
+
+// 固定计算量的任务，用于扩展曲线
+static uint64_t spinWork(size_t iterations)
+{
+    volatile uint64_t x = 0;
+    for (size_t i = 0; i < iterations; i++)
+    {
+        x = x + i;
+    }
+    return x;
+}
+
+struct Options
+{
+    size_t tasks = 200000;
+    size_t maxThreads = std::max(1u, std::thread::hardware_concurrency());
+    size_t latencySamples = 20000;
+    size_t roundTrips = 20000;
+    size_t bursts = 20;
+    size_t burstSize = 2000;
+};
+
+static double perSecond(size_t n, int64_t ns)
+{
+    return ns > 0 ? n * 1e9 / ns : 0.0;
+}
+
+static uint64_t percentileOf(std::vector<int64_t> &samples, double q)
+{
+    if (samples.empty())
+        return 0;
+    size_t i = std::min(samples.size() - 1, static_cast<size_t>(q * samples.size()));
+    std::nth_element(samples.begin(), samples.begin() + i, samples.end());
+    return static_cast<uint64_t>(std::max<int64_t>(0, samples[i]));
+}
+
+// 1、空任务吞吐量：producers个线程一起提交tasks个任务，直到全部执行完
+static double poolThroughput(size_t threads, size_t producers, size_t tasks)
+{
+    ThreadPool pool;
+    pool.start(threads);
+    CountDownLatch latch(tasks);
+    size_t each = tasks / producers;
+    int64_t begin = nowNs();
+    std::vector<std::thread> ps;
+    for (size_t p = 0; p < producers; p++)
+    {
+        size_t n = p + 1 == producers ? tasks - each * p : each;
+        ps.emplace_back([&pool, &latch, n]()
+                        {
+            for (size_t i = 0; i < n; i++)
+            {
+                pool.submitTask(makeTask<EmptyTask>(latch));
+            } });
+    }
+    for (auto &t : ps)
+        t.join();
+    latch.wait();
+    return perSecond(tasks, nowNs() - begin);
+}
+
+static double asyncThroughput(size_t tasks)
+{
+    int64_t begin = nowNs();
+    std::vector<std::future<void>> fs;
+    fs.reserve(tasks);
+    for (size_t i = 0; i < tasks; i++)
+    {
+        fs.push_back(std::async(std::launch::async, []() {}));
+    }
+    for (auto &f : fs)
+        f.get();
+    return perSecond(tasks, nowNs() - begin);
+}
+
+// 2、提交到开始执行的延迟：每次提交后等待任务开始，线程池处于空闲状态
+static void latency(std::ostringstream &os, const Options &opt)
+{
+    ThreadPool pool;
+    pool.start(opt.maxThreads);
+    std::vector<int64_t> samples;
+    samples.reserve(opt.latencySamples);
+    for (size_t i = 0; i < opt.latencySamples; i++)
+    {
+        CountDownLatch latch(1);
+        int64_t start = 0;
+        int64_t submit = nowNs();
+        pool.submitTask(makeTask<StampTask>(start, latch));
+        latch.wait();
+        samples.push_back(start - submit);
+    }
+    os << "\"latency_ns\":{\"samples\":" << samples.size()
+       << ",\"p50\":" << percentileOf(samples, 0.5)
+       << ",\"p90\":" << percentileOf(samples, 0.9)
+       << ",\"p99\":" << percentileOf(samples, 0.99)
+       << ",\"p999\":" << percentileOf(samples, 0.999)
+       << ",\"max\":" << percentileOf(samples, 1.0) << "}";
+}
+
+// 3、往返开销：提交一个任务并立即取结果
+static void roundTrip(std::ostringstream &os, const Options &opt)
+{
+    ThreadPool pool;
+    pool.start(opt.maxThreads);
+    size_t n = opt.roundTrips;
+
+    int64_t begin = nowNs();
+    for (size_t i = 0; i < n; i++)
+    {
+        CountDownLatch latch(1);
+        Result res = pool.submitTask(makeTask<EmptyTask>(latch));
+        res.get();
+    }
+    int64_t resultNs = (nowNs() - begin) / static_cast<int64_t>(n);
+
+    begin = nowNs();
+    for (size_t i = 0; i < n; i++)
+    {
+        pool.submit([]() { return 1; }).get();
+    }
+    int64_t typedNs = (nowNs() - begin) / static_cast<int64_t>(n);
+
+    begin = nowNs();
+    for (size_t i = 0; i < n; i++)
+    {
+        std::async(std::launch::async, []() { return 1; }).get();
+    }
+    int64_t asyncNs = (nowNs() - begin) / static_cast<int64_t>(n);
+
+    os << "\"round_trip_ns\":{\"result_get\":" << resultNs
+       << ",\"typed_get\":" << typedNs
+       << ",\"std_async\":" << asyncNs << "}";
+}
+
+// 4、突发负载：一批任务之后空闲一段时间，对比两种模式的总耗时和线程数量变化
+static void burstMode(std::ostringstream &os, const Options &opt, PoolMode mode, const char *name)
+{
+    ThreadPool pool;
+    pool.setPoolMode(mode);
+    pool.start(std::max<size_t>(1, opt.maxThreads / 2));
+    int64_t busyNs = 0;
+    for (size_t b = 0; b < opt.bursts; b++)
+    {
+        int64_t begin = nowNs();
+        std::vector<std::function<uint64_t()>> funcs(opt.burstSize, []() { return spinWork(2000); });
+        TypedBatchResult<uint64_t> batch = pool.submitBatch(funcs.begin(), funcs.end());
+        batch.wait();
+        busyNs += nowNs() - begin;
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    PoolStats s = pool.stats();
+    os << "\"" << name << "\":{\"tasks_per_sec\":" << perSecond(opt.bursts * opt.burstSize, busyNs)
+       << ",\"queue_wait_p99_ns\":" << s.queueWait.percentile(0.99)
+       << ",\"threads_created\":" << s.threadsCreated
+       << ",\"threads_reaped\":" << s.threadsReaped << "}";
+}
+
+// 5、扩展曲线：固定计算量的任务，线程数量从1到maxThreads
+static double scaling(size_t threads, size_t tasks)
+{
+    ThreadPool pool;
+    pool.start(threads);
+    std::vector<std::function<uint64_t()>> funcs(tasks, []() { return spinWork(10000); });
+    int64_t begin = nowNs();
+    TypedBatchResult<uint64_t> batch = pool.submitBatch(funcs.begin(), funcs.end());
+    batch.wait();
+    return perSecond(tasks, nowNs() - begin);
+}
+
+// 6、计数器伪共享：threads个线程同时累加计数器，返回每次累加的平均耗时
+struct SharedCounter
+{
+    SharedCounter() : value(0) {}
+    void add()
+    {
+        value.fetch_add(1, std::memory_order_relaxed);
+    }
+    std::atomic<uint64_t> value;
+};
+
+template <typename Counter>
+static double counterNsPerOp(size_t threads, size_t ops)
+{
+    Counter counter;
+    CountDownLatch go(1);
+    std::vector<std::thread> ts;
+    for (size_t t = 0; t < threads; t++)
+    {
+        ts.emplace_back([&counter, &go, ops]()
+                        {
+            go.wait();
+            for (size_t i = 0; i < ops; i++)
+            {
+                counter.add();
+            } });
+    }
+    int64_t begin = nowNs();
+    go.countDown();
+    for (auto &t : ts)
+        t.join();
+    return static_cast<double>(nowNs() - begin) / (threads * ops);
+}
+
+// threads个线程同时记录跟踪事件，每个事件的平均耗时（纳秒）
+static double traceNsPerOp(size_t threads, size_t ops, bool enabled)
+{
+    Tracer tracer;
+    if (enabled)
+        tracer.enable();
+    CountDownLatch go(1);
+    std::vector<std::thread> ts;
+    for (size_t t = 0; t < threads; t++)
+    {
+        ts.emplace_back([&tracer, &go, ops]()
+                        {
+            go.wait();
+            for (size_t i = 0; i < ops; i++)
+            {
+                tracer.record(TraceEvent::TRACE_SUBMIT, &tracer);
+            } });
+    }
+    int64_t begin = nowNs();
+    go.countDown();
+    for (auto &t : ts)
+        t.join();
+    return static_cast<double>(nowNs() - begin) / (threads * ops);
+}
+
+static std::vector<size_t> powersUpTo(size_t n)
+{
+    std::vector<size_t> v;
+    for (size_t i = 1; i < n; i *= 2)
+    {
+        v.push_back(i);
+    }
+    v.push_back(n);
+    return v;
+}
+
+int main(int argc, char **argv)
+{
+    Options opt;
+    for (int i = 1; i < argc; i++)
+    {
+        if (std::strcmp(argv[i], "--quick") == 0)
+        {
+            opt.tasks = 20000;
+            opt.latencySamples = 2000;
+            opt.roundTrips = 2000;
+            opt.bursts = 5;
+            opt.burstSize = 500;
+        }
+        else if (std::strcmp(argv[i], "--tasks") == 0 && i + 1 < argc)
+        {
+            opt.tasks = std::strtoul(argv[++i], nullptr, 10);
+        }
+        else if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+        {
+            opt.maxThreads = std::max<size_t>(1, std::strtoul(argv[++i], nullptr, 10));
+        }
+    }
+
+    std::ostringstream os;
+    os << "{\"hardware_concurrency\":" << std::thread::hardware_concurrency()
+       << ",\"threads\":" << opt.maxThreads << ",\"tasks\":" << opt.tasks << ",";
+
+    os << "\"throughput_tasks_per_sec\":{\"pool\":[";
+    std::vector<size_t> producers = powersUpTo(opt.maxThreads);
+    for (size_t i = 0; i < producers.size(); i++)
+    {
+        os << (i ? "," : "") << "{\"producers\":" << producers[i]
+           << ",\"value\":" << poolThroughput(opt.maxThreads, producers[i], opt.tasks) << "}";
+    }
+    // std::async每个任务创建一个线程，只用十分之一的任务数量
+    os << "],\"std_async\":" << asyncThroughput(std::max<size_t>(1, opt.tasks / 10)) << "},";
+
+    latency(os, opt);
+    os << ",";
+    roundTrip(os, opt);
+    os << ",\"burst\":{";
+    burstMode(os, opt, PoolMode::MODE_FIXED, "fixed");
+    os << ",";
+    burstMode(os, opt, PoolMode::MODE_CACHED, "cached");
+    os << "},";
+
+    os << "\"scaling_tasks_per_sec\":[";
+    std::vector<size_t> threads = powersUpTo(opt.maxThreads);
+    for (size_t i = 0; i < threads.size(); i++)
+    {
+        os << (i ? "," : "") << "{\"threads\":" << threads[i]
+           << ",\"value\":" << scaling(threads[i], std::max<size_t>(1, opt.tasks / 10)) << "}";
+    }
+    os << "],";
+
+    size_t ops = std::max<size_t>(1, opt.tasks * 10);
+    os << "\"hot_counter_ns_per_op\":{\"threads\":" << opt.maxThreads
+       << ",\"shared\":" << counterNsPerOp<SharedCounter>(opt.maxThreads, ops)
+       << ",\"striped\":" << counterNsPerOp<StripedCounter>(opt.maxThreads, ops) << "},";
+    os << "\"trace_record_ns_per_op\":{\"threads\":" << opt.maxThreads
+       << ",\"enabled\":" << traceNsPerOp(opt.maxThreads, ops, true)
+       << ",\"disabled\":" << traceNsPerOp(opt.maxThreads, ops, false) << "}}";
+    std::cout << os.str() << std::endl;
+    return 0;
+}
@@ -0,0 +1,47 @@
+#ifndef CANCELLATION_H
+#define CANCELLATION_H
+#include <atomic>
+#include <memory>
+#include <stdexcept>
+
+/*
+协作式取消令牌：拷贝共享同一个取消标志，提交时附加到任务上
+- 还没有开始执行的任务被工作线程跳过，结果以取消完成
+- 正在执行的任务通过isCancelled()自己决定何时结束（只是一次原子读）
+example:
+CancellationToken token;
+TypedResult<int> res = pool.submit(token, []() { ... });
+token.cancel(); // 例如RPC超时
+*/
+class CancellationToken
+{
+public:
+    CancellationToken() : state_(std::make_shared<State>()) {}
+
+    // 请求取消，之后所有持有这个令牌的任务都能看到
+    void cancel()
+    {
+        state_->cancelled.store(true, std::memory_order_release);
+    }
+    bool isCancelled() const
+    {
+        return state_->cancelled.load(std::memory_order_acquire);
+    }
+
+private:
+    friend class Task; // 任务只保存共享的取消标志
+    struct State
+    {
+        State() : cancelled(false) {}
+        std::atomic_bool cancelled;
+    };
+    std::shared_ptr<State> state_;
+};
+
+// 任务被取消或者超过截止时间而没有执行时，带类型结果的get()抛出的异常
+class TaskCancelled : public std::runtime_error
+{
+public:
+    TaskCancelled() : std::runtime_error("task was cancelled before running.") {}
+};
+#endif
@@ -0,0 +1,75 @@
+#ifndef COMPLETION_H
+#define COMPLETION_H
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include "parker.h"
+#include "flexipoolexport.h"
+
+/*
+一次性完成事件：整个状态只有一个32位原子字（EMPTY -> WAITING -> SET）
+- set()只是一次原子交换，只有等待者已经挂起（状态为WAITING）时才进入内核唤醒
+- wait()已经完成时直接返回；可以先自旋若干次，仍未完成才把状态改为WAITING并挂起
+- Linux上挂起和唤醒使用futex，其他平台按地址散列到一组全局的锁和条件变量上
+*/
+class FLEXIPOOL_API Completion
+{
+public:
+    Completion() : state_(EMPTY) {}
+    Completion(const Completion &) = delete;
+    Completion &operator=(const Completion &) = delete;
+
+    // 是否已经完成
+    bool isSet() const
+    {
+        return state_.load(std::memory_order_acquire) == SET;
+    }
+
+    // 标记完成并唤醒所有等待者，reset()之前重复调用没有作用
+    void set()
+    {
+        if (state_.exchange(SET, std::memory_order_acq_rel) == WAITING)
+            wakeAll(&state_);
+    }
+
+    // 重新置为未完成，可以再次使用；调用者保证此时没有线程在等待
+    void reset()
+    {
+        state_.store(EMPTY, std::memory_order_relaxed);
+    }
+
+    // 阻塞直到完成，spin为挂起之前自旋检查的次数
+    void wait(size_t spin = 0)
+    {
+        for (size_t i = 0; i < spin; ++i)
+        {
+            if (isSet())
+                return;
+            cpuRelax();
+        }
+        uint32_t state = state_.load(std::memory_order_acquire);
+        while (state != SET)
+        {
+            // 第一个挂起的等待者负责登记，set()看到WAITING才会唤醒
+            if (state == EMPTY && !state_.compare_exchange_weak(state, WAITING, std::memory_order_acquire))
+                continue;
+            waitWhile(&state_, WAITING);
+            state = state_.load(std::memory_order_acquire);
+        }
+    }
+
+private:
+    enum : uint32_t
+    {
+        EMPTY,
+        WAITING,
+        SET
+    };
+    // 状态仍然是value时挂起，允许虚假返回，由调用者重新检查
+    static void waitWhile(std::atomic<uint32_t> *word, uint32_t value);
+    // 唤醒所有挂起在word上的线程
+    static void wakeAll(std::atomic<uint32_t> *word);
+
+    std::atomic<uint32_t> state_;
+};
+#endif
@@ -0,0 +1,379 @@
+#ifndef COROUTINE_H
+#define COROUTINE_H
+#include "threadpool.h"
+
+/*
+C++20协程支持（CMake选项 -DFLEXIPOOL_COROUTINES=ON，库和使用者都按照C++20编译）
+- co_await pool.schedule()：挂起当前协程，由工作线程继续执行，协程不占用线程等待
+- co_await result：TypedResult可以直接等待，任务完成后在完成它的工作线程中继续执行
+- CoTask<T>：惰性启动的协程，被co_await或者syncWait时开始执行，完成时对称转移到等待者
+- syncWait(task)：在普通线程中阻塞等待一个协程或者TypedResult完成
+example:
+CoTask<int> handle(ThreadPool &pool, Request req)
+{
+    co_await pool.schedule();                       // 之后在工作线程中执行
+    Data data = co_await pool.submit(load, req);    // 等待期间不占用线程
+    co_return parse(data);
+}
+int n = syncWait(handle(pool, req));
+*/
+#if defined(FLEXIPOOL_COROUTINES)
+#if !defined(__cpp_impl_coroutine)
+#error "FLEXIPOOL_COROUTINES requires a C++20 compiler with coroutine support."
+#endif
+#include <coroutine>
+#include <optional>
+
+// 在工作线程中继续执行协程的任务
+class ResumeTask : public Task
+{
+public:
+    explicit ResumeTask(std::coroutine_handle<> handle) : handle_(handle) {}
+    Any run()
+    {
+        handle_.resume();
+        return Any();
+    }
+
+protected:
+    // 线程池关闭时被取消：仍然在当前线程继续执行，协程可以正常结束
+    void onDiscard()
+    {
+        handle_.resume();
+    }
+
+private:
+    std::coroutine_handle<> handle_;
+};
+
+// co_await pool.schedule()的等待体
+class ScheduleAwaiter
+{
+public:
+    explicit ScheduleAwaiter(ThreadPool &pool) : pool_(pool) {}
+    bool await_ready() const noexcept
+    {
+        return false;
+    }
+    /*
+    放入任务队列失败（队列满、线程池已经关闭）时不挂起，在当前线程继续执行
+    不使用线程池的提交策略：POLICY_CALLER_RUNS会在await_suspend中直接恢复协程，
+    循环co_await schedule()时栈无限增长；POLICY_BLOCK也没有必要阻塞当前线程
+    */
+    bool await_suspend(std::coroutine_handle<> handle)
+    {
+        return !pool_.isShutdown_ && pool_.enqueueTask(makeTask<ResumeTask>(handle), SubmitPolicy::POLICY_FAIL_FAST);
+    }
+    void await_resume() const noexcept {}
+
+private:
+    ThreadPool &pool_;
+};
+
+inline ScheduleAwaiter ThreadPool::schedule()
+{
+    return ScheduleAwaiter(*this);
+}
+
+/*
+co_await TypedResult的等待体：任务完成的回调中直接恢复协程
+await_ready之后、onReady之前任务可能已经完成，onReady会在await_suspend中直接调用回调；
+回调和await_suspend谁后到谁负责继续：回调先到时await_suspend返回false，不在onReady里面恢复协程
+*/
+template <typename R>
+class ResultAwaiter
+{
+public:
+    explicit ResultAwaiter(TypedResult<R> result) : result_(std::move(result)), arrived_(false) {}
+    bool await_ready() const
+    {
+        return result_.ready();
+    }
+    bool await_suspend(std::coroutine_handle<> handle)
+    {
+        result_.onReady([this, handle]()
+                        {
+                            if (arrived_.exchange(true, std::memory_order_acq_rel))
+                                handle.resume(); // await_suspend已经返回true，协程已经挂起
+                        });
+        // 返回true之后不能再访问成员：协程可能已经在完成任务的线程中恢复并销毁了等待体
+        return !arrived_.exchange(true, std::memory_order_acq_rel);
+    }
+    R await_resume()
+    {
+        return result_.get();
+    }
+
+private:
+    TypedResult<R> result_;
+    std::atomic<bool> arrived_; // 回调和await_suspend都会置位，第二个置位的一方继续执行协程
+};
+
+template <typename R>
+ResultAwaiter<R> operator co_await(TypedResult<R> result)
+{
+    return ResultAwaiter<R>(std::move(result));
+}
+
+template <typename T>
+class CoTask;
+
+// 协程的返回值或者异常，void单独处理
+template <typename T>
+class CoTaskValue
+{
+public:
+    void return_value(T value)
+    {
+        value_.emplace(std::move(value));
+    }
+    T take()
+    {
+        return std::move(*value_);
+    }
+
+private:
+    std::optional<T> value_;
+};
+
+template <>
+class CoTaskValue<void>
+{
+public:
+    void return_void() {}
+    void take() {}
+};
+
+template <typename T>
+class CoTaskPromise : public CoTaskValue<T>
+{
+public:
+    CoTask<T> get_return_object();
+    // 惰性启动：被等待时才开始执行
+    std::suspend_always initial_suspend() noexcept
+    {
+        return {};
+    }
+    // 完成时转移到等待者，没有等待者时停在这里，由CoTask销毁协程帧
+    struct FinalAwaiter
+    {
+        bool await_ready() noexcept
+        {
+            return false;
+        }
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<CoTaskPromise> handle) noexcept
+        {
+            std::coroutine_handle<> next = handle.promise().continuation_;
+            return next ? next : std::noop_coroutine();
+        }
+        void await_resume() noexcept {}
+    };
+    FinalAwaiter final_suspend() noexcept
+    {
+        return {};
+    }
+    void unhandled_exception()
+    {
+        error_ = std::current_exception();
+    }
+    T result()
+    {
+        if (error_)
+        {
+            std::rethrow_exception(error_);
+        }
+        return this->take();
+    }
+
+private:
+    template <typename U>
+    friend class CoTask;
+    std::coroutine_handle<> continuation_; // 等待这个协程的协程
+    std::exception_ptr error_;
+};
+
+// 惰性启动的协程，只能被等待一次
+template <typename T>
+class CoTask
+{
+public:
+    using promise_type = CoTaskPromise<T>;
+
+    CoTask(CoTask &&other) noexcept : handle_(other.handle_)
+    {
+        other.handle_ = nullptr;
+    }
+    CoTask &operator=(CoTask &&other) noexcept
+    {
+        if (this != &other)
+        {
+            if (handle_)
+                handle_.destroy();
+            handle_ = other.handle_;
+            other.handle_ = nullptr;
+        }
+        return *this;
+    }
+    CoTask(const CoTask &) = delete;
+    CoTask &operator=(const CoTask &) = delete;
+    ~CoTask()
+    {
+        if (handle_)
+            handle_.destroy();
+    }
+
+    // 被co_await时启动协程（对称转移，不增加调用栈深度），完成后恢复等待者
+    struct Awaiter
+    {
+        std::coroutine_handle<promise_type> handle;
+        bool await_ready() const noexcept
+        {
+            return !handle || handle.done();
+        }
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<> waiter) noexcept
+        {
+            handle.promise().continuation_ = waiter;
+            return handle;
+        }
+        T await_resume()
+        {
+            return handle.promise().result();
+        }
+    };
+    Awaiter operator co_await() const &&noexcept
+    {
+        return Awaiter{handle_};
+    }
+    Awaiter operator co_await() const &noexcept
+    {
+        return Awaiter{handle_};
+    }
+
+private:
+    friend class CoTaskPromise<T>;
+    explicit CoTask(std::coroutine_handle<promise_type> handle) : handle_(handle) {}
+    std::coroutine_handle<promise_type> handle_;
+};
+
+template <typename T>
+CoTask<T> CoTaskPromise<T>::get_return_object()
+{
+    return CoTask<T>(std::coroutine_handle<CoTaskPromise>::from_promise(*this));
+}
+
+// syncWait使用的门闩协程：立即开始执行，完成时唤醒阻塞的线程
+class SyncWaitTask
+{
+public:
+    struct promise_type
+    {
+        CountDownLatch *latch = nullptr;
+        SyncWaitTask get_return_object()
+        {
+            return SyncWaitTask(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+        std::suspend_always initial_suspend() noexcept
+        {
+            return {};
+        }
+        // 先停在最终挂起点再唤醒等待者，等待者返回时才销毁协程帧
+        struct FinalAwaiter
+        {
+            bool await_ready() noexcept
+            {
+                return false;
+            }
+            void await_suspend(std::coroutine_handle<promise_type> handle) noexcept
+            {
+                handle.promise().latch->countDown();
+            }
+            void await_resume() noexcept {}
+        };
+        FinalAwaiter final_suspend() noexcept
+        {
+            return {};
+        }
+        void return_void() {}
+        void unhandled_exception()
+        {
+            std::terminate(); // 异常已经在syncWaitBody中捕获
+        }
+    };
+
+    explicit SyncWaitTask(std::coroutine_handle<promise_type> handle) : handle_(handle) {}
+    SyncWaitTask(SyncWaitTask &&other) noexcept : handle_(other.handle_)
+    {
+        other.handle_ = nullptr;
+    }
+    ~SyncWaitTask()
+    {
+        if (handle_)
+            handle_.destroy();
+    }
+    // 在当前线程启动协程并阻塞到它完成
+    void run()
+    {
+        CountDownLatch latch(1);
+        handle_.promise().latch = &latch;
+        handle_.resume();
+        latch.wait();
+    }
+
+private:
+    std::coroutine_handle<promise_type> handle_;
+};
+
+template <typename Awaitable, typename T>
+SyncWaitTask syncWaitBody(Awaitable &awaitable, std::optional<T> &value, std::exception_ptr &error)
+{
+    try
+    {
+        value.emplace(co_await std::move(awaitable));
+    }
+    catch (...)
+    {
+        error = std::current_exception();
+    }
+}
+
+template <typename Awaitable>
+SyncWaitTask syncWaitVoidBody(Awaitable &awaitable, std::exception_ptr &error)
+{
+    try
+    {
+        co_await std::move(awaitable);
+    }
+    catch (...)
+    {
+        error = std::current_exception();
+    }
+}
+
+// 阻塞当前线程直到协程完成，返回协程的返回值，协程中的异常在这里重新抛出；不能在协程中调用
+template <typename T>
+T syncWait(CoTask<T> task)
+{
+    std::exception_ptr error;
+    if constexpr (std::is_void<T>::value)
+    {
+        syncWaitVoidBody(task, error).run();
+        if (error)
+            std::rethrow_exception(error);
+    }
+    else
+    {
+        std::optional<T> value;
+        syncWaitBody(task, value, error).run();
+        if (error)
+            std::rethrow_exception(error);
+        return std::move(*value);
+    }
+}
+
+template <typename R>
+R syncWait(TypedResult<R> result)
+{
+    return result.get();
+}
+#endif
+#endif
@@ -0,0 +1,41 @@
+#ifndef CPUTOPOLOGY_H
+#define CPUTOPOLOGY_H
+#include <vector>
+#include <string>
+#include <cstddef>
+#include "flexipoolexport.h"
+
+/*
+CPU拓扑：每个NUMA节点包含的逻辑CPU编号
+- Linux下读取/sys/devices/system/node，并且只保留当前进程允许使用的CPU（taskset、cgroup）
+- 其他平台或者读取失败时，所有CPU属于同一个节点
+*/
+class FLEXIPOOL_API CpuTopology
+{
+public:
+    CpuTopology() = default;
+    // 自定义拓扑：nodes[i]为第i个节点的CPU编号，空节点会被忽略
+    explicit CpuTopology(std::vector<std::vector<int>> nodes);
+
+    // 检测当前机器的拓扑
+    static CpuTopology detect();
+    // 解析"0-3,8,10-11"格式的CPU列表
+    static std::vector<int> parseCpuList(const std::string &list);
+    // 把当前线程绑定到cpus中的CPU上，失败或者平台不支持时返回false
+    static bool pinCurrentThread(const std::vector<int> &cpus);
+
+    size_t nodeCount() const
+    {
+        return nodes_.size();
+    }
+    const std::vector<int> &nodeCpus(size_t node) const
+    {
+        return nodes_[node];
+    }
+    // 所有节点的CPU总数
+    size_t cpuCount() const;
+
+private:
+    std::vector<std::vector<int>> nodes_;
+};
+#endif
@@ -0,0 +1,69 @@
+#ifndef ELASTICITY_H
+#define ELASTICITY_H
+#include <cstddef>
+#include <cstdint>
+#include <chrono>
+#include "flexipoolexport.h"
+
+// 监督线程每个采样周期得到的数据（计数为本周期内的增量）
+struct ElasticSample
+{
+    double intervalSec = 0; // 距离上次采样的时间（秒）
+    uint64_t arrived = 0;   // 提交成功的任务数量
+    uint64_t waitCount = 0; // 开始执行的任务数量
+    uint64_t waitSumNs = 0; // 这些任务的排队时间之和
+    uint64_t execCount = 0; // 执行完成的任务数量
+    uint64_t execSumNs = 0; // 这些任务的执行时间之和
+    size_t queued = 0;      // 采样时排队的任务数量
+    size_t threads = 0;     // 采样时的线程数量
+    size_t idle = 0;        // 采样时的空闲线程数量
+};
+
+/*
+cached模式的弹性控制器：根据到达率和排队时间的EWMA计算目标线程数
+- 需要的线程数 = 到达率 × 平均执行时间（Little定律）× 1.25的余量 + 空闲线程处理不了的积压任务；
+  排队时间的EWMA超过目标值时至少再增加一个线程。负载上升时在队列积压之前提前创建线程
+- 目标线程数上升时立即生效；下降需要负载持续低于目标一个空闲超时，每次只回收差值的一半（滞回），
+  突发流量之间的短暂空闲不会导致线程反复创建和销毁
+- 只在监督线程中使用，不需要同步
+*/
+class FLEXIPOOL_API ElasticController
+{
+public:
+    ElasticController(size_t minThreads, size_t maxThreads, std::chrono::milliseconds idleTimeout);
+
+    // 加入一次采样，返回新的目标线程数（在[minThreads, maxThreads]之间）
+    size_t update(const ElasticSample &sample);
+
+    size_t target() const
+    {
+        return target_;
+    }
+    // 任务到达率（个/秒）的EWMA
+    double arrivalRate() const
+    {
+        return arrivalEwma_;
+    }
+    // 排队时间（纳秒）的EWMA
+    double queueWaitNs() const
+    {
+        return waitEwma_;
+    }
+    // 执行时间（纳秒）的EWMA
+    double serviceNs() const
+    {
+        return serviceEwma_;
+    }
+
+private:
+    size_t minThreads_;
+    size_t maxThreads_;
+    double idleTimeoutSec_;
+    size_t target_;
+    bool sampled_;        // 是否已经有过采样，第一次采样直接作为EWMA的初值
+    double arrivalEwma_;
+    double waitEwma_;
+    double serviceEwma_;
+    double belowSec_;     // 需要的线程数持续低于目标线程数的时间
+};
+#endif
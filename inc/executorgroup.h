@@ -0,0 +1,129 @@
+#ifndef EXECUTORGROUP_H
+#define EXECUTORGROUP_H
+#include <string>
+#include "threadpool.h"
+
+/*
+执行器组：多个逻辑执行器共享同一组工作线程，每个执行器有独立的任务队列、优先级和权重
+- 每提交一个任务，组内的线程池就多一个调度令牌；令牌被工作线程执行时才决定运行哪个执行器的任务，
+  所以执行器之间不会互相占用队列，线程总数仍然是组的线程数
+- 选择任务：先取优先级最高的非空执行器，同一优先级内按照权重做步长调度（stride scheduling），
+  权重为2的执行器得到的执行次数是权重为1的两倍；空闲过的执行器不会积累额度
+- 每个执行器可以单独设置排队上限，一个租户的积压不会占满整个组
+example:
+ExecutorGroup group(8);
+Executor &online = group.createExecutor("online", 4, Priority::PRIORITY_HIGH);
+Executor &batch = group.createExecutor("batch", 1, Priority::PRIORITY_LOW);
+TypedResult<Reply> res = online.submit(handle, request);
+batch.submit([]() { compact(); });
+*/
+class ExecutorGroup;
+
+// 执行器组中的一个逻辑执行器，由ExecutorGroup创建，生命周期和组相同
+class FLEXIPOOL_API Executor
+{
+public:
+    Executor(const Executor &) = delete;
+    Executor &operator=(const Executor &) = delete;
+
+    // 提交任务，排队的任务超过上限或者组已经关闭时Result无效
+    Result submitTask(std::shared_ptr<Task> sp);
+
+    // 提交任意可调用对象，提交失败时get()抛出std::runtime_error
+    template <typename Func, typename... Args>
+    auto submit(Func &&func, Args &&...args) -> TypedResult<decltype(func(args...))>
+    {
+        using RType = decltype(func(args...));
+        using BindType = decltype(std::bind(std::forward<Func>(func), std::forward<Args>(args)...));
+        std::shared_ptr<FuncTask<RType, BindType>> task =
+            makeTask<FuncTask<RType, BindType>>(std::bind(std::forward<Func>(func), std::forward<Args>(args)...));
+        if (!enqueue(task))
+        {
+            task->setError(std::make_exception_ptr(std::runtime_error("executor queue is full, submit task failed.")));
+        }
+        return TypedResult<RType>(task);
+    }
+
+    // 设置这个执行器排队任务的上限（不包括正在执行的任务）
+    void setTaskQueMaxThreshHold(size_t threshhold);
+
+    const std::string &name() const
+    {
+        return name_;
+    }
+    size_t weight() const
+    {
+        return weight_;
+    }
+    Priority priority() const
+    {
+        return priority_;
+    }
+    // 排队中的任务数量
+    size_t pending() const;
+    // 已经完成（执行、跳过或者丢弃）的任务数量
+    uint64_t completed() const
+    {
+        return completed_.load(std::memory_order_relaxed);
+    }
+
+private:
+    friend class ExecutorGroup;
+    Executor(ExecutorGroup &group, std::string name, size_t weight, Priority priority);
+    // 由组放入执行器的队列并给线程池一个调度令牌，失败返回false
+    bool enqueue(std::shared_ptr<Task> sp);
+
+    ExecutorGroup &group_;
+    std::string name_;
+    size_t weight_;
+    Priority priority_;
+    uint64_t stride_;   // 每执行一个任务虚拟时间前进的步长，与权重成反比
+    // 以下由group_的mtx_保护
+    size_t maxQueued_;
+    std::deque<std::shared_ptr<Task>> queue_;
+    uint64_t pass_;     // 虚拟时间，同一优先级中最小的先执行
+    std::atomic<uint64_t> completed_;
+};
+
+class FLEXIPOOL_API ExecutorGroup
+{
+public:
+    // 创建threads个工作线程（固定模式）
+    explicit ExecutorGroup(size_t threads = std::thread::hardware_concurrency());
+    // 执行完所有排队的任务后回收线程
+    ~ExecutorGroup();
+    ExecutorGroup(const ExecutorGroup &) = delete;
+    ExecutorGroup &operator=(const ExecutorGroup &) = delete;
+
+    // 创建一个执行器，weight至少为1；返回的引用在组析构之前一直有效
+    Executor &createExecutor(const std::string &name, size_t weight = 1, Priority priority = Priority::PRIORITY_NORMAL);
+    // 按照名字查找执行器，不存在时返回nullptr
+    Executor *executor(const std::string &name);
+    size_t executorCount() const;
+
+    // 关闭组：和ThreadPool::shutdown相同，被取消的任务按照丢弃处理
+    bool shutdown(ShutdownMode mode = ShutdownMode::SHUTDOWN_DRAIN, std::chrono::milliseconds timeout = std::chrono::milliseconds::max());
+    // 所有执行器共享的线程池的统计快照（执行器中的任务和调度令牌都计入任务数量）
+    PoolStats stats();
+
+private:
+    friend class Executor;
+    class DispatchTask; // 调度令牌
+
+    // 任务放入executor的队列，再给线程池一个调度令牌
+    bool enqueue(Executor &executor, std::shared_ptr<Task> sp);
+    // 选择下一个要执行的任务，没有排队的任务时返回空
+    std::shared_ptr<Task> next(Executor *&from);
+    // 令牌被执行：运行选中的任务
+    void runNext();
+    // 令牌被丢弃：丢弃选中的任务，令牌和任务的数量保持一致
+    void discardNext();
+    // 令牌没有放进线程池：取回刚放入的任务，已经被其他令牌取走时丢弃另一个任务
+    void revoke(Executor &executor, const std::shared_ptr<Task> &sp);
+
+    mutable std::mutex mtx_;
+    std::vector<std::unique_ptr<Executor>> executors_;
+    uint64_t virtualTime_[PRIORITY_LEVELS]; // 各优先级最近一次选中的虚拟时间，重新变为非空的执行器从所在优先级的这里开始
+    ThreadPool pool_;
+};
+#endif
@@ -0,0 +1,24 @@
+#ifndef FLEXIPOOLEXPORT_H
+#define FLEXIPOOLEXPORT_H
+
+/*
+动态库导出的符号：动态库使用-fvisibility=hidden编译，只有标记了FLEXIPOOL_API的类和函数对外可见，
+其余符号在库内部直接调用，不经过PLT，可以被内联和链接时优化
+- FLEXIPOOL_SHARED：构建或者使用动态库时定义（CMake通过tdpool传递给使用者）
+- FLEXIPOOL_EXPORTS：只在构建动态库时定义（Windows上区分dllexport和dllimport）
+静态库中FLEXIPOOL_API为空
+*/
+#if defined(FLEXIPOOL_SHARED)
+#if defined(_WIN32)
+#if defined(FLEXIPOOL_EXPORTS)
+#define FLEXIPOOL_API __declspec(dllexport)
+#else
+#define FLEXIPOOL_API __declspec(dllimport)
+#endif
+#else
+#define FLEXIPOOL_API __attribute__((visibility("default")))
+#endif
+#else
+#define FLEXIPOOL_API
+#endif
+#endif
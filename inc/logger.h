@@ -0,0 +1,167 @@
+#ifndef LOGGER_H
+#define LOGGER_H
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <thread>
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+#include "flexipoolexport.h"
+
+/*
+日志级别（编译期）：低于FLEXIPOOL_LOG_LEVEL的日志语句会被预处理器整体删除，参数也不会求值
+CMake选项 -DFLEXIPOOL_LOG_LEVEL=TRACE|DEBUG|INFO|WARN|ERROR|OFF，默认WARN
+*/
+#define FLEXIPOOL_LOG_LEVEL_TRACE 0
+#define FLEXIPOOL_LOG_LEVEL_DEBUG 1
+#define FLEXIPOOL_LOG_LEVEL_INFO 2
+#define FLEXIPOOL_LOG_LEVEL_WARN 3
+#define FLEXIPOOL_LOG_LEVEL_ERROR 4
+#define FLEXIPOOL_LOG_LEVEL_OFF 5
+
+#ifndef FLEXIPOOL_LOG_LEVEL
+#define FLEXIPOOL_LOG_LEVEL FLEXIPOOL_LOG_LEVEL_WARN
+#endif
+
+const size_t LOG_MSG_SIZE = 128;       // 单条日志消息的最大长度（超出截断）
+const size_t LOG_BUFFER_SIZE = 256;    // 每个线程日志缓冲区的记录条数（2的幂），写满后丢弃新日志
+const size_t LOG_FLUSH_INTERVAL = 10;  // 单位：毫秒，有新日志之后后台线程最多等待这么久再输出（积攒一批一起输出）
+
+// 日志级别（运行期）
+enum class LogLevel
+{
+    LEVEL_TRACE = FLEXIPOOL_LOG_LEVEL_TRACE,
+    LEVEL_DEBUG = FLEXIPOOL_LOG_LEVEL_DEBUG,
+    LEVEL_INFO = FLEXIPOOL_LOG_LEVEL_INFO,
+    LEVEL_WARN = FLEXIPOOL_LOG_LEVEL_WARN,
+    LEVEL_ERROR = FLEXIPOOL_LOG_LEVEL_ERROR,
+};
+
+// 一条日志记录：在写日志的线程中格式化好，由后台线程交给输出函数
+struct LogRecord
+{
+    LogLevel level;
+    int64_t timestamp;  // steady_clock 纳秒
+    std::thread::id tid; // 写日志的线程
+    char msg[LOG_MSG_SIZE];
+};
+
+// 日志输出函数（由后台线程调用，不会和写日志的线程并发）
+using LogSink = std::function<void(const LogRecord &)>;
+
+/*
+异步日志：
+- 每个线程第一次写日志时注册一个单生产者单消费者的无锁环形缓冲区，之后写日志不加锁、不做IO
+- 后台线程把所有缓冲区的记录交给输出函数，默认输出到std::cout/std::cerr；
+  没有日志时后台线程一直挂起，第一条日志唤醒它，最多LOG_FLUSH_INTERVAL之后输出
+- 进程退出时停止后台线程，之后写的日志（例如静态对象的析构函数中）由写日志的线程直接输出；
+  线程局部的缓冲区析构之后（后析构的线程局部变量中）写的日志同样直接输出
+- 缓冲区写满时丢弃新日志并计数，不会阻塞写日志的线程
+*/
+class FLEXIPOOL_API Logger
+{
+public:
+    // 全局唯一的日志对象（不析构，进程退出时输出剩余的日志）
+    static Logger &instance();
+
+    // 写一条printf格式的日志
+    void log(LogLevel level, const char *fmt, ...)
+#if defined(__GNUC__)
+        __attribute__((format(printf, 3, 4)))
+#endif
+        ;
+
+    // 替换输出函数（传入空函数恢复默认输出）
+    void setSink(LogSink sink);
+    // 运行期的最低日志级别（只能比编译期的级别更严格）
+    void setLevel(LogLevel level);
+    LogLevel level() const;
+    // 立即输出所有缓冲区中的日志
+    void flush();
+    // 因为缓冲区写满而丢弃的日志数量
+    size_t dropped() const;
+
+private:
+    Logger();
+    ~Logger() = default;
+    Logger(const Logger &) = delete;
+    Logger &operator=(const Logger &) = delete;
+
+    // 单个线程的日志缓冲区：写日志的线程是唯一的生产者，flush是唯一的消费者
+    struct Buffer
+    {
+        Buffer() : head(0), tail(0), retired(false) {}
+        LogRecord records[LOG_BUFFER_SIZE];
+        std::atomic<size_t> head;  // 消费者读取的位置
+        char pad[64 - sizeof(std::atomic<size_t>)];
+        std::atomic<size_t> tail;  // 生产者写入的位置
+        std::atomic<bool> retired; // 所属线程已经退出，输出完剩余记录后释放
+    };
+
+    Buffer *localBuffer(); // 线程局部的缓冲区已经析构时返回nullptr，日志同步输出
+    void flushLocked(); // 需要持有flushMtx_
+    void flushLoop();
+    bool hasPending(); // 有缓冲区中还有没有输出的记录
+
+    std::atomic<int> level_;
+    std::atomic<size_t> dropped_;
+
+    std::mutex registryMtx_; // 保护buffers_的增删（每个线程只在注册时加锁一次）
+    std::vector<Buffer *> buffers_;
+
+    std::mutex flushMtx_; // 保证同一时刻只有一个消费者，同时保护sink_
+    LogSink sink_;
+
+    std::mutex stopMtx_;
+    std::condition_variable stopCond_; // 后台线程在这里等待新日志或者停止
+    bool stop_;
+    bool wakeup_;                      // 写日志的线程唤醒了挂起的后台线程，由stopMtx_保护
+    std::atomic<bool> sleeping_;       // 后台线程没有日志可以输出，正在挂起（写日志的线程负责唤醒）
+    std::atomic<bool> stopped_;        // 后台线程已经停止，写日志的线程自己输出
+    std::thread flusher_;              // 后台输出线程
+
+    static void stopAtExit(); // 进程退出时停止后台线程并输出剩余的日志
+
+    friend struct LocalBufferHandle;
+};
+
+#define FLEXIPOOL_LOG_WRITE(lvl, ...)                                               \
+    do                                                                              \
+    {                                                                               \
+        if (static_cast<int>(lvl) >= static_cast<int>(Logger::instance().level())) \
+            Logger::instance().log(lvl, __VA_ARGS__);                               \
+    } while (0)
+
+#if FLEXIPOOL_LOG_LEVEL <= FLEXIPOOL_LOG_LEVEL_TRACE
+#define FLEXIPOOL_LOG_TRACE(...) FLEXIPOOL_LOG_WRITE(LogLevel::LEVEL_TRACE, __VA_ARGS__)
+#else
+#define FLEXIPOOL_LOG_TRACE(...) ((void)0)
+#endif
+
+#if FLEXIPOOL_LOG_LEVEL <= FLEXIPOOL_LOG_LEVEL_DEBUG
+#define FLEXIPOOL_LOG_DEBUG(...) FLEXIPOOL_LOG_WRITE(LogLevel::LEVEL_DEBUG, __VA_ARGS__)
+#else
+#define FLEXIPOOL_LOG_DEBUG(...) ((void)0)
+#endif
+
+#if FLEXIPOOL_LOG_LEVEL <= FLEXIPOOL_LOG_LEVEL_INFO
+#define FLEXIPOOL_LOG_INFO(...) FLEXIPOOL_LOG_WRITE(LogLevel::LEVEL_INFO, __VA_ARGS__)
+#else
+#define FLEXIPOOL_LOG_INFO(...) ((void)0)
+#endif
+
+#if FLEXIPOOL_LOG_LEVEL <= FLEXIPOOL_LOG_LEVEL_WARN
+#define FLEXIPOOL_LOG_WARN(...) FLEXIPOOL_LOG_WRITE(LogLevel::LEVEL_WARN, __VA_ARGS__)
+#else
+#define FLEXIPOOL_LOG_WARN(...) ((void)0)
+#endif
+
+#if FLEXIPOOL_LOG_LEVEL <= FLEXIPOOL_LOG_LEVEL_ERROR
+#define FLEXIPOOL_LOG_ERROR(...) FLEXIPOOL_LOG_WRITE(LogLevel::LEVEL_ERROR, __VA_ARGS__)
+#else
+#define FLEXIPOOL_LOG_ERROR(...) ((void)0)
+#endif
+#endif
@@ -0,0 +1,188 @@
+#ifndef MPMCQUEUE_H
+#define MPMCQUEUE_H
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+// 缓存行大小，用于隔开生产者和消费者频繁修改的变量，避免伪共享
+const size_t CACHE_LINE_SIZE = 64;
+
+/*
+Vyukov 有界多生产者多消费者无锁队列
+- 容量向上取整为2的幂，下标通过掩码取模
+- 每个槽位带一个序号：序号==pos表示可写，序号==pos+1表示可读
+- push/pop 在队列满/空时立即返回false，不会阻塞
+*/
+template <typename T>
+class MpmcQueue
+{
+public:
+    explicit MpmcQueue(size_t capacity)
+        : capacity_(roundUp(capacity)), mask_(capacity_ - 1), buffer_(new Cell[capacity_])
+    {
+        for (size_t i = 0; i < capacity_; i++)
+        {
+            buffer_[i].seq.store(i, std::memory_order_relaxed);
+        }
+        enqueuePos_.store(0, std::memory_order_relaxed);
+        dequeuePos_.store(0, std::memory_order_relaxed);
+    }
+    ~MpmcQueue()
+    {
+        T item;
+        while (pop(item))
+        {
+        }
+        delete[] buffer_;
+    }
+    MpmcQueue(const MpmcQueue &) = delete;
+    MpmcQueue &operator=(const MpmcQueue &) = delete;
+
+    // 入队，队列满返回false（此时item保持不变）
+    bool push(T &&item)
+    {
+        Cell *cell;
+        size_t pos = enqueuePos_.load(std::memory_order_relaxed);
+        for (;;)
+        {
+            cell = &buffer_[pos & mask_];
+            size_t seq = cell->seq.load(std::memory_order_acquire);
+            intptr_t dif = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+            if (dif == 0)
+            {
+                if (enqueuePos_.compare_exchange_weak(pos, pos + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+                    break;
+            }
+            else if (dif < 0)
+            {
+                return false; // 队列满
+            }
+            else
+            {
+                pos = enqueuePos_.load(std::memory_order_relaxed);
+            }
+        }
+        new (&cell->storage) T(std::move(item));
+        cell->seq.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    /*
+    批量入队：一次CAS预留连续的n个（或者剩余可用的）槽位，返回入队的数量
+    成功入队的元素被移动走，items[入队数量, n)保持不变
+    */
+    size_t pushBulk(T *items, size_t n)
+    {
+        size_t pos = enqueuePos_.load(std::memory_order_relaxed);
+        size_t count;
+        for (;;)
+        {
+            // 从pos开始数出连续可写的槽位
+            count = 0;
+            while (count < n)
+            {
+                size_t seq = buffer_[(pos + count) & mask_].seq.load(std::memory_order_acquire);
+                if (seq != pos + count)
+                    break;
+                count++;
+            }
+            if (count == 0)
+            {
+                size_t seq = buffer_[pos & mask_].seq.load(std::memory_order_acquire);
+                if (static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos) < 0)
+                    return 0; // 队列满
+                pos = enqueuePos_.load(std::memory_order_relaxed);
+                continue;
+            }
+            if (enqueuePos_.compare_exchange_weak(pos, pos + count, std::memory_order_seq_cst, std::memory_order_relaxed))
+                break;
+        }
+        // 预留成功，这些槽位只属于当前线程
+        for (size_t i = 0; i < count; i++)
+        {
+            Cell *cell = &buffer_[(pos + i) & mask_];
+            new (&cell->storage) T(std::move(items[i]));
+            cell->seq.store(pos + i + 1, std::memory_order_release);
+        }
+        return count;
+    }
+
+    // 出队，队列空返回false
+    bool pop(T &item)
+    {
+        Cell *cell;
+        size_t pos = dequeuePos_.load(std::memory_order_relaxed);
+        for (;;)
+        {
+            cell = &buffer_[pos & mask_];
+            size_t seq = cell->seq.load(std::memory_order_acquire);
+            intptr_t dif = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+            if (dif == 0)
+            {
+                if (dequeuePos_.compare_exchange_weak(pos, pos + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+                    break;
+            }
+            else if (dif < 0)
+            {
+                return false; // 队列空
+            }
+            else
+            {
+                pos = dequeuePos_.load(std::memory_order_relaxed);
+            }
+        }
+        T *data = reinterpret_cast<T *>(&cell->storage);
+        item = std::move(*data);
+        data->~T();
+        cell->seq.store(pos + mask_ + 1, std::memory_order_release);
+        return true;
+    }
+
+    size_t capacity() const
+    {
+        return capacity_;
+    }
+
+    // 近似的元素个数（并发下仅供参考）
+    size_t size() const
+    {
+        size_t deq = dequeuePos_.load(std::memory_order_seq_cst);
+        size_t enq = enqueuePos_.load(std::memory_order_seq_cst);
+        return enq > deq ? enq - deq : 0;
+    }
+
+    bool full() const
+    {
+        return size() >= capacity_;
+    }
+
+private:
+    struct Cell
+    {
+        std::atomic<size_t> seq;
+        typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+    };
+
+    static size_t roundUp(size_t n)
+    {
+        size_t cap = 2;
+        while (cap < n)
+        {
+            cap <<= 1;
+        }
+        return cap;
+    }
+
+    const size_t capacity_;
+    const size_t mask_;
+    Cell *const buffer_;
+    char pad0_[CACHE_LINE_SIZE];
+    std::atomic<size_t> enqueuePos_; // 生产者竞争的位置
+    char pad1_[CACHE_LINE_SIZE - sizeof(std::atomic<size_t>)];
+    std::atomic<size_t> dequeuePos_; // 消费者竞争的位置
+    char pad2_[CACHE_LINE_SIZE - sizeof(std::atomic<size_t>)];
+};
+#endif
@@ -0,0 +1,85 @@
+#ifndef MPSCQUEUE_H
+#define MPSCQUEUE_H
+#include <atomic>
+#include <cstddef>
+#include <new>
+#include <utility>
+#include <type_traits>
+#include "mpmcqueue.h"
+#include "taskallocator.h"
+
+/*
+Vyukov 无界多生产者单消费者无锁队列
+- 生产者只做一次原子交换（把新节点换到队头）再链接到前一个节点，不会因为其他生产者失败重试
+- 消费者从哨兵节点之后取元素，取走的节点成为新的哨兵
+- 节点从内存池分配，预热后入队不调用malloc
+- 生产者交换之后、链接之前被挂起时，之后入队的元素暂时取不到，pop返回false
+*/
+template <typename T>
+class MpscQueue
+{
+public:
+    MpscQueue() : tail_(newNode())
+    {
+        head_.store(tail_, std::memory_order_relaxed);
+    }
+    ~MpscQueue()
+    {
+        T item;
+        while (pop(item))
+        {
+        }
+        deleteNode(tail_);
+    }
+    MpscQueue(const MpscQueue &) = delete;
+    MpscQueue &operator=(const MpscQueue &) = delete;
+
+    // 任意线程入队
+    void push(T &&item)
+    {
+        Node *node = newNode();
+        new (&node->storage) T(std::move(item));
+        Node *prev = head_.exchange(node, std::memory_order_acq_rel);
+        prev->next.store(node, std::memory_order_release);
+    }
+
+    // 只能由一个消费者调用，队列为空（或者下一个元素还没有链接好）返回false
+    bool pop(T &item)
+    {
+        Node *next = tail_->next.load(std::memory_order_acquire);
+        if (next == nullptr)
+        {
+            return false;
+        }
+        T *value = reinterpret_cast<T *>(&next->storage);
+        item = std::move(*value);
+        value->~T();
+        deleteNode(tail_);
+        tail_ = next;
+        return true;
+    }
+
+private:
+    struct Node
+    {
+        std::atomic<Node *> next;
+        typename std::aligned_storage<sizeof(T), alignof(T)>::type storage; // 哨兵节点中的元素已经被取走
+    };
+    static Node *newNode()
+    {
+        static_assert(alignof(Node) <= alignof(std::max_align_t), "over-aligned items cannot be allocated from SlabPool.");
+        Node *node = new (SlabPool::allocate(sizeof(Node))) Node();
+        node->next.store(nullptr, std::memory_order_relaxed);
+        return node;
+    }
+    static void deleteNode(Node *node)
+    {
+        node->~Node();
+        SlabPool::deallocate(node, sizeof(Node));
+    }
+
+    std::atomic<Node *> head_; // 最近入队的节点，生产者修改
+    char pad_[CACHE_LINE_SIZE];
+    Node *tail_;               // 哨兵节点，只有消费者访问
+};
+#endif
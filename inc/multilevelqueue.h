@@ -0,0 +1,111 @@
+#ifndef MULTILEVELQUEUE_H
+#define MULTILEVELQUEUE_H
+#include <queue>
+#include <deque>
+#include <memory>
+#include <utility>
+#include <cstddef>
+#include <cstdint>
+
+/*
+多级FIFO队列：级别0优先级最高，每个级别内部先进先出
+- 出队时按照有效优先级选择：每排队agingNs，有效优先级提升一级，低优先级任务不会饿死
+- 有效优先级相同时取排队时间长的，老化到最高级的任务按照先来先出执行
+- 不是线程安全的，由使用者加锁保护
+- Alloc为底层std::deque使用的分配器
+*/
+template <typename T, size_t Levels, typename Alloc = std::allocator<std::pair<T, int64_t>>>
+class MultiLevelQueue
+{
+public:
+    MultiLevelQueue() : size_(0) {}
+
+    // 放入level级别的队尾，now为入队时间
+    void push(T item, size_t level, int64_t now)
+    {
+        ques_[level].emplace(std::move(item), now);
+        size_++;
+    }
+
+    /*
+    选出下一个应该出队的级别，allowed[i]为false的级别不参与选择
+    返回Levels表示没有可以出队的元素，effective返回选中级别的有效优先级
+    */
+    size_t select(int64_t now, int64_t agingNs, const bool *allowed, size_t &effective) const
+    {
+        size_t best = Levels;
+        for (size_t i = 0; i < Levels; i++)
+        {
+            if (!allowed[i] || ques_[i].empty())
+                continue;
+            size_t eff = i;
+            if (agingNs > 0)
+            {
+                int64_t waited = now - ques_[i].front().second;
+                size_t boost = waited > 0 ? static_cast<size_t>(waited / agingNs) : 0;
+                eff = boost >= i ? 0 : i - boost;
+            }
+            if (best == Levels || eff < effective || (eff == effective && ques_[i].front().second < ques_[best].front().second))
+            {
+                best = i;
+                effective = eff;
+            }
+        }
+        return best;
+    }
+
+    // 只有一个级别非空时返回这个级别（出队不需要比较排队时间），否则返回Levels
+    size_t onlyLevel() const
+    {
+        size_t level = Levels;
+        for (size_t i = 0; i < Levels; i++)
+        {
+            if (ques_[i].empty())
+                continue;
+            if (level != Levels)
+                return Levels;
+            level = i;
+        }
+        return level;
+    }
+
+    // 取出level级别的队头
+    void pop(size_t level, T &item)
+    {
+        item = std::move(ques_[level].front().first);
+        ques_[level].pop();
+        size_--;
+    }
+
+    // 取出优先级最低的非空级别中最老的元素（队列满时丢弃用），返回其级别，队列为空返回Levels
+    size_t popLowest(T &item)
+    {
+        for (size_t i = Levels; i-- > 0;)
+        {
+            if (!ques_[i].empty())
+            {
+                pop(i, item);
+                return i;
+            }
+        }
+        return Levels;
+    }
+
+    size_t size() const
+    {
+        return size_;
+    }
+    size_t size(size_t level) const
+    {
+        return ques_[level].size();
+    }
+    bool empty() const
+    {
+        return size_ == 0;
+    }
+
+private:
+    std::queue<std::pair<T, int64_t>, std::deque<std::pair<T, int64_t>, Alloc>> ques_[Levels]; // 元素和入队时间
+    size_t size_;
+};
+#endif
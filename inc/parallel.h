@@ -0,0 +1,261 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+#include "threadpool.h"
+#include <deque>
+#include <iterator>
+
+/*
+建立在ThreadPool之上的并行算法：parallelFor、parallelReduce、parallelTransform
+- 惰性二分（lazy binary splitting）：执行者每处理完grain个元素检查一次，线程池中空闲线程多于
+  还没有被取走的分片时，把剩余区间的后一半拆成新的分片提交，否则继续自己处理，不预先固定分片数量
+- 调用者线程参与计算：先处理整个区间，之后取走还没有开始的分片自己执行，只等待其他线程正在执行的分片，
+  在工作线程中调用也不会死锁
+- 分片提交使用POLICY_CALLER_RUNS，任务队列满时在当前线程执行
+- grain为0时按照线程数量自动选择；执行中抛出的第一个异常在调用者线程重新抛出，其余分片尽快结束
+*/
+
+// 一次并行执行：Chunk(b, e, acc)处理[b, e)并返回新的累积值，每个分片得到一个部分结果
+template <typename Index, typename T, typename Chunk>
+class ParallelJob : public std::enable_shared_from_this<ParallelJob<Index, T, Chunk>>
+{
+public:
+    ParallelJob(ThreadPool &pool, Index grain, T identity, Chunk chunk)
+        : pool_(pool), grain_(grain), identity_(std::move(identity)), chunk_(std::move(chunk)), queued_(0), active_(0), failed_(false)
+    {
+    }
+
+    // 调用者线程：执行整个区间并等待所有分片完成，返回按照区间顺序排列的部分结果
+    std::vector<T> run(Index begin, Index end)
+    {
+        runPiece(begin, end);
+        std::unique_lock<std::mutex> lock(mtx_);
+        for (;;)
+        {
+            // 取走还没有开始的分片（先取最早拆出来的，区间最大）
+            std::shared_ptr<Piece> piece;
+            while (!pieces_.empty())
+            {
+                std::shared_ptr<Piece> front = std::move(pieces_.front());
+                pieces_.pop_front();
+                if (!front->claimed.exchange(true))
+                {
+                    piece = std::move(front);
+                    break;
+                }
+            }
+            if (piece != nullptr)
+            {
+                queued_--;
+                lock.unlock();
+                runPiece(piece->begin, piece->end);
+                lock.lock();
+                active_--;
+                continue;
+            }
+            if (active_ == 0)
+                break;
+            cond_.wait(lock); // 有新的分片或者所有分片完成时被唤醒
+        }
+        if (error_)
+        {
+            std::rethrow_exception(error_);
+        }
+        std::sort(partials_.begin(), partials_.end(), [](const std::pair<Index, T> &a, const std::pair<Index, T> &b)
+                  { return a.first < b.first; });
+        std::vector<T> results;
+        results.reserve(partials_.size());
+        for (auto &partial : partials_)
+        {
+            results.emplace_back(std::move(partial.second));
+        }
+        return results;
+    }
+
+private:
+    struct Piece
+    {
+        Piece(Index b, Index e) : begin(b), end(e), claimed(false) {}
+        Index begin;
+        Index end;
+        std::atomic_bool claimed; // 调用者和工作线程只有一方能执行
+    };
+
+    // 提交到线程池的分片任务，持有整个执行的状态
+    class PieceTask
+    {
+    public:
+        PieceTask(std::shared_ptr<ParallelJob> job, std::shared_ptr<Piece> piece)
+            : job_(std::move(job)), piece_(std::move(piece)) {}
+        void operator()()
+        {
+            if (piece_->claimed.exchange(true))
+                return; // 已经被调用者取走
+            job_->queued_--;
+            job_->runPiece(piece_->begin, piece_->end);
+            bool done;
+            {
+                std::lock_guard<std::mutex> lock(job_->mtx_);
+                done = --job_->active_ == 0;
+            }
+            if (done)
+                job_->cond_.notify_all();
+        }
+
+    private:
+        std::shared_ptr<ParallelJob> job_;
+        std::shared_ptr<Piece> piece_;
+    };
+
+    // 执行一个分片，按需把剩余区间的后一半拆出去
+    void runPiece(Index b, Index e)
+    {
+        Index key = b;
+        T acc = identity_;
+        try
+        {
+            while (e - b > grain_ && !failed_.load(std::memory_order_relaxed))
+            {
+                if (pool_.idleThreadCount() > queued_.load(std::memory_order_relaxed))
+                {
+                    Index mid = b + (e - b) / 2;
+                    spawn(mid, e);
+                    e = mid;
+                }
+                Index next = e - b > grain_ ? b + grain_ : e;
+                acc = chunk_(b, next, std::move(acc));
+                b = next;
+            }
+            if (b < e && !failed_.load(std::memory_order_relaxed))
+            {
+                acc = chunk_(b, e, std::move(acc));
+            }
+        }
+        catch (...)
+        {
+            std::lock_guard<std::mutex> lock(mtx_);
+            if (!error_)
+                error_ = std::current_exception();
+            failed_ = true;
+        }
+        std::lock_guard<std::mutex> lock(mtx_);
+        partials_.emplace_back(key, std::move(acc));
+    }
+
+    // 拆出[b, e)作为新的分片
+    void spawn(Index b, Index e)
+    {
+        std::shared_ptr<Piece> piece = std::make_shared<Piece>(b, e);
+        {
+            std::lock_guard<std::mutex> lock(mtx_);
+            pieces_.push_back(piece);
+            active_++;
+        }
+        queued_++;
+        cond_.notify_all(); // 等待中的调用者可以取走这个分片
+        pool_.submit(SubmitPolicy::POLICY_CALLER_RUNS, PieceTask(this->shared_from_this(), std::move(piece)));
+    }
+
+    ThreadPool &pool_;
+    Index grain_;
+    T identity_;
+    Chunk chunk_;
+    std::atomic_size_t queued_; // 已经拆出、还没有开始执行的分片数量
+    size_t active_;             // 已经拆出、还没有完成的分片数量，由mtx_保护
+    std::atomic_bool failed_;
+    std::exception_ptr error_;
+    std::mutex mtx_;
+    std::condition_variable cond_;
+    std::deque<std::shared_ptr<Piece>> pieces_;     // 拆出的分片，调用者从这里取走还没有开始的分片
+    std::vector<std::pair<Index, T>> partials_;     // 每个分片的起点和部分结果
+};
+
+// 没有指定grain时：每个线程大约分到8个块
+template <typename Index>
+Index parallelGrain(ThreadPool &pool, Index n, size_t grain)
+{
+    if (grain > 0)
+        return static_cast<Index>(grain);
+    Index chunks = static_cast<Index>(std::max<size_t>(1, pool.threadCount() + 1) * 8);
+    return std::max<Index>(1, n / chunks);
+}
+
+template <typename Index, typename T, typename Chunk>
+std::vector<T> parallelRun(ThreadPool &pool, Index begin, Index end, size_t grain, T identity, Chunk chunk)
+{
+    std::shared_ptr<ParallelJob<Index, T, Chunk>> job = std::allocate_shared<ParallelJob<Index, T, Chunk>>(
+        PoolAllocator<ParallelJob<Index, T, Chunk>>(), pool, parallelGrain(pool, static_cast<Index>(end - begin), grain),
+        std::move(identity), std::move(chunk));
+    return job->run(begin, end);
+}
+
+// parallelFor的分块函数：对每个下标调用func
+template <typename Index, typename F>
+class ParallelForChunk
+{
+public:
+    explicit ParallelForChunk(F &func) : func_(&func) {}
+    bool operator()(Index b, Index e, bool acc) const
+    {
+        for (Index i = b; i < e; ++i)
+        {
+            (*func_)(i);
+        }
+        return acc;
+    }
+
+private:
+    F *func_;
+};
+
+/*
+对[begin, end)中的每个下标并行调用func(i)
+example:
+parallelFor(pool, 0, n, 1024, [&](size_t i) { out[i] = in[i] * 2; });
+*/
+template <typename B, typename E, typename F>
+void parallelFor(ThreadPool &pool, B begin, E end, size_t grain, F func)
+{
+    using Index = typename std::common_type<B, E>::type;
+    if (!(static_cast<Index>(begin) < static_cast<Index>(end)))
+        return;
+    parallelRun(pool, static_cast<Index>(begin), static_cast<Index>(end), grain, false, ParallelForChunk<Index, F>(func));
+}
+
+/*
+并行归约：func(b, e, acc)把[b, e)累积到acc上并返回，combine(x, y)合并两个部分结果
+部分结果按照区间顺序合并，combine只需要满足结合律
+example:
+Ulong sum = parallelReduce(pool, 1, 300000001, 0, Ulong(0),
+    [](Ulong b, Ulong e, Ulong acc) { for (Ulong i = b; i < e; i++) acc += i; return acc; },
+    std::plus<Ulong>());
+*/
+template <typename B, typename E, typename T, typename F, typename Combine>
+T parallelReduce(ThreadPool &pool, B begin, E end, size_t grain, T identity, F func, Combine combine)
+{
+    using Index = typename std::common_type<B, E>::type;
+    if (!(static_cast<Index>(begin) < static_cast<Index>(end)))
+        return identity;
+    std::vector<T> partials = parallelRun(pool, static_cast<Index>(begin), static_cast<Index>(end), grain, identity, func);
+    T result = std::move(identity);
+    for (auto &partial : partials)
+    {
+        result = combine(std::move(result), std::move(partial));
+    }
+    return result;
+}
+
+/*
+并行变换：out[i] = func(first[i])，迭代器需要支持随机访问，返回输出区间的末尾
+example:
+parallelTransform(pool, in.begin(), in.end(), out.begin(), [](int x) { return x * x; });
+*/
+template <typename InputIt, typename OutputIt, typename F>
+OutputIt parallelTransform(ThreadPool &pool, InputIt first, InputIt last, OutputIt out, F func, size_t grain = 0)
+{
+    using Diff = typename std::iterator_traits<InputIt>::difference_type;
+    Diff n = std::distance(first, last);
+    parallelFor(pool, Diff(0), n, grain, [&](Diff i)
+                { out[i] = func(first[i]); });
+    return out + n;
+}
+#endif
@@ -0,0 +1,120 @@
+#ifndef PARKER_H
+#define PARKER_H
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <thread>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// 自旋等待时提示CPU当前处于忙等，降低功耗并让出流水线给超线程
+inline void cpuRelax()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+    __asm__ __volatile__("yield");
+#elif defined(_MSC_VER)
+    _mm_pause();
+#else
+    std::this_thread::yield();
+#endif
+}
+
+/*
+线程停车位：每个工作线程一个，只有自己会在上面park，其他线程unpark它
+- unpark先于park发生时会留下一个许可，下一次park立即返回，不会丢失唤醒
+- 只有等待的线程真正阻塞时，unpark才需要加锁和通知
+*/
+class Parker
+{
+public:
+    Parker() : inIdleStack_(false), node_(0), state_(EMPTY) {}
+    Parker(const Parker &) = delete;
+    Parker &operator=(const Parker &) = delete;
+
+    // 阻塞直到被unpark（已经有许可时立即返回）
+    void park()
+    {
+        int expected = NOTIFIED;
+        if (state_.compare_exchange_strong(expected, EMPTY))
+            return;
+        std::unique_lock<std::mutex> lock(mtx_);
+        expected = EMPTY;
+        if (!state_.compare_exchange_strong(expected, PARKED))
+        {
+            // 加锁期间被unpark了
+            state_.store(EMPTY);
+            return;
+        }
+        for (;;)
+        {
+            cond_.wait(lock);
+            expected = NOTIFIED;
+            if (state_.compare_exchange_strong(expected, EMPTY))
+                return;
+        }
+    }
+
+    // 最多阻塞timeout，被unpark返回true，超时返回false
+    bool parkFor(std::chrono::milliseconds timeout)
+    {
+        int expected = NOTIFIED;
+        if (state_.compare_exchange_strong(expected, EMPTY))
+            return true;
+        auto deadline = std::chrono::steady_clock::now() + timeout;
+        std::unique_lock<std::mutex> lock(mtx_);
+        expected = EMPTY;
+        if (!state_.compare_exchange_strong(expected, PARKED))
+        {
+            state_.store(EMPTY);
+            return true;
+        }
+        for (;;)
+        {
+            std::cv_status status = cond_.wait_until(lock, deadline);
+            expected = NOTIFIED;
+            if (state_.compare_exchange_strong(expected, EMPTY))
+                return true;
+            if (status == std::cv_status::timeout)
+            {
+                // 超时的同时可能刚好被unpark，以交换出来的状态为准
+                return state_.exchange(EMPTY) == NOTIFIED;
+            }
+        }
+    }
+
+    // 唤醒在停车位上等待的线程，或者留下一个许可
+    void unpark()
+    {
+        if (state_.exchange(NOTIFIED) == PARKED)
+        {
+            // 加锁保证等待者已经进入wait，通知不会丢失
+            std::lock_guard<std::mutex> lock(mtx_);
+            cond_.notify_one();
+        }
+    }
+
+    // 丢弃尚未消费的许可
+    void reset()
+    {
+        state_.store(EMPTY);
+    }
+
+    bool inIdleStack_; // 是否在线程池的空闲栈中，由线程池的idleMtx_保护
+    size_t node_;      // 线程所在的NUMA节点，提交到指定节点时优先唤醒该节点的线程
+
+private:
+    enum
+    {
+        EMPTY,
+        PARKED,
+        NOTIFIED
+    };
+    std::atomic<int> state_;
+    std::mutex mtx_;
+    std::condition_variable cond_;
+};
+#endif
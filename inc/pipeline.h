@@ -0,0 +1,224 @@
+#ifndef PIPELINE_H
+#define PIPELINE_H
+#include "threadpool.h"
+
+const size_t PIPELINE_TOKENS = 16; // Pipeline默认同时处理的条目数量
+
+// 流水线阶段的执行方式
+enum class StageMode
+{
+    STAGE_SERIAL_IN_ORDER, // 同一时刻只处理一个条目，按照读取输入的顺序处理
+    STAGE_PARALLEL,        // 多个条目同时处理，不保证顺序
+};
+
+template <typename T>
+class PipelineStage;
+
+/*
+流水线（类似TBB的parallel_pipeline）：source读取输入，之后的各个阶段依次处理每个条目
+- 同时处理的条目数量不超过maxTokens（令牌数量）：令牌用完时不再读取输入，在途的内存是常数
+- 一个线程读到条目后沿着后续阶段连续处理它（深度优先，数据留在当前线程的缓存中），
+  还有空闲令牌时再提交一个任务读取下一个条目，空闲的线程并行处理其他条目
+- 串行阶段按照读取顺序处理，先到的后序条目在阶段内排队，不占用线程；前一个条目处理完后交给线程池继续
+- 条目在阶段之间移动传递，不拷贝，存放在内存池中，预热后不调用malloc
+- 某个阶段抛出异常后不再读取输入，在途的条目不再调用用户函数，run()等待它们回收令牌后重新抛出第一个异常
+- 线程池关闭后不再读取输入，已经读取的条目处理完后run()抛出异常
+source和各个阶段的函数由工作线程调用，run()之前构建好流水线，run()返回后可以再次执行
+example:
+Pipeline pipe(pool, 32);
+pipe.source<std::string>([&](std::string &line) { return bool(std::getline(in, line)); })
+    .then(StageMode::STAGE_PARALLEL, [](std::string &&line) { return parse(line); })
+    .then(StageMode::STAGE_PARALLEL, [](Record &&r) { return compress(r); })
+    .then(StageMode::STAGE_SERIAL_IN_ORDER, [&](Block &&b) { out.write(b); });
+pipe.run();
+*/
+class FLEXIPOOL_API Pipeline
+{
+public:
+    explicit Pipeline(ThreadPool &pool, size_t maxTokens = PIPELINE_TOKENS);
+    Pipeline(const Pipeline &) = delete;
+    Pipeline &operator=(const Pipeline &) = delete;
+
+    // 输入阶段（串行）：func(T &item)读取下一个条目写入item，输入结束时返回false；T需要可以默认构造
+    template <typename T, typename Func>
+    PipelineStage<T> source(Func &&func)
+    {
+        if (!stages_->empty())
+        {
+            throw std::logic_error("pipeline already has a source.");
+        }
+        addStage(std::unique_ptr<Stage>(new SourceStage<T, typename std::decay<Func>::type>(std::forward<Func>(func))));
+        return PipelineStage<T>(this);
+    }
+
+    // 阻塞直到输入结束并且所有条目处理完成，重新抛出阶段中的第一个异常
+    void run();
+
+    size_t maxTokens() const
+    {
+        return maxTokens_;
+    }
+
+private:
+    template <typename T>
+    friend class PipelineStage;
+    class Run;     // 一次执行的令牌、顺序和错误，任务持有它，run()返回后仍然有效
+    class RunTask; // 读取输入或者继续处理一个条目
+    struct Token;  // 一个在途的条目
+
+    // 一个阶段：消费上一个阶段的输出，返回交给下一个阶段的输出
+    class Stage
+    {
+    public:
+        explicit Stage(StageMode mode) : mode_(mode) {}
+        virtual ~Stage() = default;
+        // 处理in（抛出异常时也会销毁in），source的in为nullptr，返回nullptr表示输入结束；最后一个阶段的输出被销毁
+        virtual void *process(void *in) = 0;
+        // 销毁这个阶段的输出（条目被取消或者已经是最后一个阶段）
+        virtual void destroy(void *out) = 0;
+
+        const StageMode mode_;
+    };
+
+    template <typename T>
+    static void *newItem(T &&value)
+    {
+        static_assert(alignof(T) <= alignof(std::max_align_t), "over-aligned pipeline items are not supported.");
+        void *p = SlabPool::allocate(sizeof(T));
+        try
+        {
+            return new (p) T(std::move(value));
+        }
+        catch (...)
+        {
+            SlabPool::deallocate(p, sizeof(T));
+            throw;
+        }
+    }
+    template <typename T>
+    static void deleteItem(void *p)
+    {
+        static_cast<T *>(p)->~T();
+        SlabPool::deallocate(p, sizeof(T));
+    }
+    // 离开作用域时销毁阶段的输入
+    template <typename T>
+    class ItemGuard
+    {
+    public:
+        explicit ItemGuard(void *p) : p_(p) {}
+        ~ItemGuard()
+        {
+            deleteItem<T>(p_);
+        }
+        ItemGuard(const ItemGuard &) = delete;
+        ItemGuard &operator=(const ItemGuard &) = delete;
+
+    private:
+        void *p_;
+    };
+
+    template <typename T, typename F>
+    class SourceStage : public Stage
+    {
+    public:
+        template <typename U>
+        explicit SourceStage(U &&func) : Stage(StageMode::STAGE_SERIAL_IN_ORDER), func_(std::forward<U>(func)) {}
+        void *process(void *)
+        {
+            T item;
+            if (!func_(item))
+                return nullptr;
+            return newItem(std::move(item));
+        }
+        void destroy(void *out)
+        {
+            deleteItem<T>(out);
+        }
+
+    private:
+        F func_;
+    };
+
+    template <typename In, typename Out, typename F>
+    class FilterStage : public Stage
+    {
+    public:
+        template <typename U>
+        FilterStage(StageMode mode, U &&func) : Stage(mode), func_(std::forward<U>(func)) {}
+        void *process(void *in)
+        {
+            ItemGuard<In> guard(in);
+            return call(*static_cast<In *>(in), std::is_void<Out>());
+        }
+        void destroy(void *out)
+        {
+            release(out, std::is_void<Out>());
+        }
+
+    private:
+        void *call(In &in, std::false_type)
+        {
+            return newItem(Out(func_(std::move(in))));
+        }
+        void *call(In &in, std::true_type)
+        {
+            func_(std::move(in));
+            return nullptr;
+        }
+        void release(void *out, std::false_type)
+        {
+            deleteItem<Out>(out);
+        }
+        void release(void *, std::true_type)
+        {
+        }
+
+        F func_;
+    };
+
+    void addStage(std::unique_ptr<Stage> stage)
+    {
+        stages_->push_back(std::move(stage));
+    }
+
+    ThreadPool &pool_;
+    const size_t maxTokens_;
+    std::shared_ptr<std::vector<std::unique_ptr<Stage>>> stages_; // stages_[0]是source
+};
+
+// 以T类型的输出结束的流水线，用来连接下一个阶段
+template <typename T>
+class PipelineStage
+{
+public:
+    // 追加一个阶段：func(T &&item)的返回值交给下一个阶段，返回void时只能是最后一个阶段
+    template <typename Func>
+    auto then(StageMode mode, Func &&func) -> PipelineStage<typename std::decay<decltype(func(std::declval<T>()))>::type>
+    {
+        using Out = typename std::decay<decltype(func(std::declval<T>()))>::type;
+        pipeline_->addStage(std::unique_ptr<Pipeline::Stage>(
+            new Pipeline::FilterStage<T, Out, typename std::decay<Func>::type>(mode, std::forward<Func>(func))));
+        return PipelineStage<Out>(pipeline_);
+    }
+
+private:
+    friend class Pipeline;
+    template <typename U>
+    friend class PipelineStage;
+    explicit PipelineStage(Pipeline *pipeline) : pipeline_(pipeline) {}
+
+    Pipeline *pipeline_;
+};
+
+// 最后一个阶段没有输出，不能再追加阶段
+template <>
+class PipelineStage<void>
+{
+private:
+    friend class Pipeline;
+    template <typename U>
+    friend class PipelineStage;
+    explicit PipelineStage(Pipeline *) {}
+};
+#endif
@@ -0,0 +1,179 @@
+#ifndef POOLSTATS_H
+#define POOLSTATS_H
+#include <atomic>
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstddef>
+#include "mpmcqueue.h"
+#include "flexipoolexport.h"
+
+// 只由一个线程写入的计数器加上n：不需要原子的读-改-写，采集线程用relaxed读取
+inline void bumpCounter(std::atomic<uint64_t> &counter, uint64_t n = 1)
+{
+    counter.store(counter.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+}
+
+/*
+HDR风格的对数-线性直方图（单位：纳秒）
+- 小于8的值每个值一个桶，之后每个2的幂区间再等分为8个桶，相对误差不超过12.5%
+- 64位取值范围共HISTOGRAM_BUCKETS个桶
+- record只能由拥有者线程调用，采集时和其他线程的直方图合并
+*/
+const size_t HISTOGRAM_SUB_BITS = 3;
+const size_t HISTOGRAM_SUB_COUNT = 1 << HISTOGRAM_SUB_BITS;
+const size_t HISTOGRAM_BUCKETS = (64 - HISTOGRAM_SUB_BITS + 1) * HISTOGRAM_SUB_COUNT;
+
+class FLEXIPOOL_API LatencyHistogram
+{
+public:
+    LatencyHistogram();
+    LatencyHistogram(const LatencyHistogram &) = delete;
+    LatencyHistogram &operator=(const LatencyHistogram &) = delete;
+
+    // 拥有者线程：记录一个值
+    void record(uint64_t value)
+    {
+        bumpCounter(counts_[bucketIndex(value)]);
+        bumpCounter(sum_, value);
+        if (value > max_.load(std::memory_order_relaxed))
+            max_.store(value, std::memory_order_relaxed);
+    }
+
+    // 值所在的桶
+    static size_t bucketIndex(uint64_t value);
+    // 桶能表示的最大值
+    static uint64_t bucketUpperBound(size_t index);
+
+private:
+    friend class HistogramSnapshot;
+    std::atomic<uint64_t> counts_[HISTOGRAM_BUCKETS];
+    std::atomic<uint64_t> sum_;
+    std::atomic<uint64_t> max_;
+};
+
+// 直方图的快照，可以合并多个线程的直方图
+class FLEXIPOOL_API HistogramSnapshot
+{
+public:
+    HistogramSnapshot();
+    // 合并一个直方图（并发写入时读到的是近似值）
+    void merge(const LatencyHistogram &histogram);
+    void merge(const HistogramSnapshot &other);
+
+    uint64_t count() const
+    {
+        return count_;
+    }
+    uint64_t sum() const
+    {
+        return sum_;
+    }
+    uint64_t max() const
+    {
+        return max_;
+    }
+    double mean() const
+    {
+        return count_ == 0 ? 0.0 : static_cast<double>(sum_) / count_;
+    }
+    // 分位数，q取值[0, 1]，返回所在桶的上界
+    uint64_t percentile(double q) const;
+    // 不大于value的记录数量（value落在桶中间时按照桶上界计算）
+    uint64_t countBelow(uint64_t value) const;
+    // 单个桶的计数
+    uint64_t bucketCount(size_t index) const
+    {
+        return counts_[index];
+    }
+
+private:
+    std::vector<uint64_t> counts_;
+    uint64_t count_;
+    uint64_t sum_;
+    uint64_t max_;
+};
+
+// 单个工作线程的计数器：只由该线程写入，前后填充避免和其他线程的计数器伪共享
+struct WorkerCounters
+{
+    explicit WorkerCounters(size_t id);
+
+    char pad0_[CACHE_LINE_SIZE];
+    size_t threadId;
+    std::atomic<uint64_t> completed; // 执行完成的任务数量（不包括取消之后跳过的任务）
+    std::atomic<uint64_t> stolen;    // 从其他线程窃取的任务数量
+    std::atomic<uint64_t> busyNs;    // 执行任务的总时间（嵌套执行的任务只计算最外层）
+    std::atomic<uint64_t> idleNs;    // 等待任务的总时间（统计到最近一次取到任务）
+    int64_t lastTransition;          // 上次开始等待任务的时间，只由该线程访问
+    uint32_t depth;                  // 正在执行的任务的嵌套层数（等待时执行其他任务、POLICY_CALLER_RUNS），只由该线程访问
+    int64_t nestedNs;                // 当前层的任务中嵌套执行其他任务的时间，只由该线程访问
+    LatencyHistogram queueWait;      // 任务从提交到开始执行的时间
+    LatencyHistogram execTime;       // 任务自身执行的时间（不包括嵌套执行的其他任务）
+    char pad1_[CACHE_LINE_SIZE];
+};
+
+/*
+分散的计数器：提交者可能是任意线程，每个线程按照自己的编号选择一个槽位累加，
+读取时求和，避免所有提交者竞争同一个缓存行
+*/
+const size_t COUNTER_STRIPES = 16;
+
+class FLEXIPOOL_API StripedCounter
+{
+public:
+    StripedCounter();
+    void add(uint64_t n = 1)
+    {
+        stripes_[stripeIndex()].value.fetch_add(n, std::memory_order_relaxed);
+    }
+    // 同一个线程的add和sub落在同一个槽位，只由add/sub配对使用时每个槽位都不会小于0
+    void sub(uint64_t n = 1)
+    {
+        stripes_[stripeIndex()].value.fetch_sub(n, std::memory_order_relaxed);
+    }
+    uint64_t load() const;
+
+private:
+    static size_t stripeIndex();
+    struct Stripe
+    {
+        std::atomic<uint64_t> value;
+        char pad[CACHE_LINE_SIZE - sizeof(std::atomic<uint64_t>)];
+    };
+    Stripe stripes_[COUNTER_STRIPES];
+};
+
+// 单个工作线程的统计快照
+struct WorkerStats
+{
+    size_t threadId;
+    uint64_t completed;
+    uint64_t stolen;
+    uint64_t busyNs;
+    uint64_t idleNs;
+};
+
+// ThreadPool::stats()返回的快照，各项计数在并发下只是近似一致
+struct FLEXIPOOL_API PoolStats
+{
+    uint64_t submitted = 0;      // 成功放入任务队列（或由提交者执行）的任务数量
+    uint64_t completed = 0;      // 执行完成的任务数量（取消之后跳过的任务只计入cancelled）
+    uint64_t callerRuns = 0;     // 其中由线程池之外的提交者线程直接执行的数量（POLICY_CALLER_RUNS）
+    uint64_t rejected = 0;       // 提交失败的任务数量
+    uint64_t dropped = 0;        // POLICY_DROP_OLDEST丢弃的任务数量
+    uint64_t cancelled = 0;      // 没有执行就被取消的任务数量（关闭线程池、取消令牌、截止时间）
+    uint64_t stolen = 0;         // 工作窃取模式下被窃取的任务数量
+    uint64_t threadsCreated = 0; // cached模式下动态创建的线程数量
+    uint64_t threadsReaped = 0;  // cached模式下空闲超时回收的线程数量
+    size_t queueDepth = 0;       // 当前排队的任务数量
+    size_t curThreads = 0;       // 当前线程数量
+    size_t idleThreads = 0;      // 当前空闲线程数量
+    HistogramSnapshot queueWait; // 排队时间（纳秒）
+    HistogramSnapshot execTime;  // 执行时间（纳秒）
+    std::vector<WorkerStats> workers; // 当前存活的工作线程
+
+    // 导出为Prometheus文本格式，prefix为指标名前缀
+    std::string toPrometheus(const std::string &prefix = "flexipool") const;
+};
+#endif
@@ -0,0 +1,106 @@
+#ifndef RESULTSET_H
+#define RESULTSET_H
+#include <iterator>
+#include <deque>
+#include "threadpool.h"
+
+/*
+一组任务的结果：所有任务共享一个完成状态，收集结果的线程只在等待的条件满足时被唤醒一次
+- waitAll()：所有任务都完成时唤醒一次，和任务的数量无关
+- waitAny()：第一个任务完成时唤醒
+- next()和范围for：按照完成的顺序取得任务的编号，先完成的先处理
+ResultSet由一个线程使用（提交、等待、取结果），任务在工作线程中完成；带类型的结果使用whenAll/whenAny
+example:
+ResultSet set(pool);
+for (auto &part : parts)
+    set.submitTask(makeTask<ParseTask>(part));
+for (size_t i : set)                  // 按照完成的顺序
+    merge(set.get(i).cast_<Doc>());
+*/
+class FLEXIPOOL_API ResultSet
+{
+public:
+    static const size_t npos = static_cast<size_t>(-1);
+
+    explicit ResultSet(ThreadPool &pool);
+    ResultSet(const ResultSet &) = delete;
+    ResultSet &operator=(const ResultSet &) = delete;
+
+    // 提交一个任务（使用线程池默认的提交策略），返回它在集合中的编号；提交失败的任务立即算作完成，结果无效
+    size_t submitTask(std::shared_ptr<Task> sp);
+    // 任务的数量
+    size_t size() const
+    {
+        return results_.size();
+    }
+    // 已经完成的任务数量（不阻塞）
+    size_t completed() const;
+
+    // 阻塞直到所有任务完成
+    void waitAll();
+    // 阻塞直到至少一个任务完成，返回最先完成的任务的编号；没有任务时返回npos
+    size_t waitAny();
+    // 按照完成的顺序返回下一个任务的编号，还没有完成时阻塞；所有任务都已经返回过时返回npos
+    size_t next();
+
+    // 第i个任务的返回值，和Result::get()相同，只能取一次
+    Any get(size_t i)
+    {
+        return results_[i].get();
+    }
+    Result &operator[](size_t i)
+    {
+        return results_[i];
+    }
+
+    // 按照完成顺序遍历编号的输入迭代器，遍历时调用next()，只能遍历一次
+    class Iterator
+    {
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = size_t;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const size_t *;
+        using reference = const size_t &;
+
+        Iterator(ResultSet *set, size_t index) : set_(set), index_(index) {}
+        const size_t &operator*() const
+        {
+            return index_;
+        }
+        Iterator &operator++()
+        {
+            index_ = set_->next();
+            return *this;
+        }
+        bool operator==(const Iterator &other) const
+        {
+            return index_ == other.index_;
+        }
+        bool operator!=(const Iterator &other) const
+        {
+            return index_ != other.index_;
+        }
+
+    private:
+        ResultSet *set_;
+        size_t index_;
+    };
+    Iterator begin()
+    {
+        return Iterator(this, next());
+    }
+    Iterator end()
+    {
+        return Iterator(this, npos);
+    }
+
+private:
+    class State; // 所有任务共享的完成状态，作为任务的观察者记录完成顺序
+
+    ThreadPool &pool_;
+    std::shared_ptr<State> state_;
+    std::deque<Result> results_; // deque追加时已有元素的地址不变，任务绑定的Result不会移动
+    size_t consumed_;            // next()已经返回的任务数量
+};
+#endif
@@ -0,0 +1,20 @@
+#ifndef STEADYCLOCK_H
+#define STEADYCLOCK_H
+#include <chrono>
+#include <cstdint>
+
+/*
+线程池内部统一使用的时间：steady_clock的纳秒数
+提交时间、截止时间、定时器的到期时间、跟踪事件和日志的时间戳都用它表示，可以直接相减和比较
+*/
+inline int64_t toSteadyNs(std::chrono::steady_clock::time_point tp)
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(tp.time_since_epoch()).count();
+}
+
+// steady_clock的当前时间（纳秒）
+inline int64_t steadyNowNs()
+{
+    return toSteadyNs(std::chrono::steady_clock::now());
+}
+#endif
@@ -0,0 +1,110 @@
+#ifndef STRAND_H
+#define STRAND_H
+#include "threadpool.h"
+#include "mpscqueue.h"
+
+const size_t STRAND_GROUP_SIZE = 64; // StrandGroup默认的strand数量
+const size_t STRAND_BATCH = 64;      // 一个strand连续执行这么多任务后重新排队，让其他任务也能得到线程
+
+/*
+串行执行器（strand）：提交到同一个strand的任务按照提交顺序逐个执行，不会同时执行，不同的strand之间并行
+- 任务放入strand自己的无锁队列；strand从空变为非空时才给线程池提交一个排空任务，
+  同一时刻最多只有一个排空任务，所以不需要锁，工作线程也不会因为其他strand的任务阻塞
+- 排空任务连续执行STRAND_BATCH个任务后把自己重新放回线程池的队尾，积压很多的strand不会独占一个线程
+- 线程池队列满时排空任务在提交者线程中执行；线程池已经关闭时提交失败
+- Strand析构时还没有执行的任务仍然会执行
+example:
+Strand strand(pool);
+strand.submit([&]() { log.append(a); });
+strand.submit([&]() { log.append(b); }); // 在a之后执行
+*/
+class FLEXIPOOL_API Strand
+{
+public:
+    explicit Strand(ThreadPool &pool);
+    Strand(const Strand &) = delete;
+    Strand &operator=(const Strand &) = delete;
+
+    // 提交任务，线程池已经关闭时Result无效
+    Result submitTask(std::shared_ptr<Task> sp);
+
+    // 提交任意可调用对象，提交失败时get()抛出std::runtime_error
+    template <typename Func, typename... Args>
+    auto submit(Func &&func, Args &&...args) -> TypedResult<decltype(func(args...))>
+    {
+        using RType = decltype(func(args...));
+        using BindType = decltype(std::bind(std::forward<Func>(func), std::forward<Args>(args)...));
+        std::shared_ptr<FuncTask<RType, BindType>> task =
+            makeTask<FuncTask<RType, BindType>>(std::bind(std::forward<Func>(func), std::forward<Args>(args)...));
+        if (!enqueue(task))
+        {
+            task->setError(std::make_exception_ptr(std::runtime_error("thread pool has been shut down, submit task failed.")));
+        }
+        return TypedResult<RType>(task);
+    }
+
+    // 还没有执行完的任务数量（包括正在执行的任务）
+    size_t pending() const;
+
+private:
+    class State;     // 任务队列和计数，排空任务持有它，Strand析构后仍然有效
+    class DrainTask; // 排空任务
+
+    // 放入队列，strand空闲时提交排空任务，失败返回false
+    bool enqueue(std::shared_ptr<Task> sp);
+    // 排空任务被执行：按顺序执行队列中的任务
+    static void drain(const std::shared_ptr<State> &state);
+    // 排空任务被丢弃（线程池关闭时取消排队的任务）：丢弃队列中的任务
+    static void discardAll(const std::shared_ptr<State> &state);
+
+    std::shared_ptr<State> state_;
+};
+
+/*
+按键串行执行：键相同的任务按照提交顺序逐个执行，键不同的任务并行执行
+- 键按照散列值分配到固定数量的strand上，内存不随键的数量增长；
+  散列到同一个strand的不同键也会串行执行，strand的数量应当明显多于线程数
+- 用来代替在任务中按照会话、分区加锁：工作线程不会阻塞在其他键的锁上
+example:
+StrandGroup sessions(pool);
+sessions.submitKeyed(sessionId, [=]() { apply(sessionId, update); });
+*/
+class FLEXIPOOL_API StrandGroup
+{
+public:
+    explicit StrandGroup(ThreadPool &pool, size_t strands = STRAND_GROUP_SIZE);
+    StrandGroup(const StrandGroup &) = delete;
+    StrandGroup &operator=(const StrandGroup &) = delete;
+
+    // 提交key对应的任务，和Strand::submitTask相同
+    template <typename Key>
+    Result submitKeyedTask(const Key &key, std::shared_ptr<Task> sp)
+    {
+        return strandFor(key).submitTask(std::move(sp));
+    }
+    // 提交key对应的可调用对象，和Strand::submit相同
+    template <typename Key, typename Func, typename... Args>
+    auto submitKeyed(const Key &key, Func &&func, Args &&...args) -> TypedResult<decltype(func(args...))>
+    {
+        return strandFor(key).submit(std::forward<Func>(func), std::forward<Args>(args)...);
+    }
+    // key对应的strand，键相同时总是同一个
+    template <typename Key>
+    Strand &strandFor(const Key &key)
+    {
+        // std::hash对整数通常是恒等映射，乘法散列后取高位，连续的键也能均匀分布
+        uint64_t h = static_cast<uint64_t>(std::hash<Key>()(key)) * 0x9E3779B97F4A7C15ull;
+        return *strands_[static_cast<size_t>(h >> 32) % strands_.size()];
+    }
+
+    size_t size() const
+    {
+        return strands_.size();
+    }
+    // 所有strand还没有执行完的任务数量
+    size_t pending() const;
+
+private:
+    std::vector<std::unique_ptr<Strand>> strands_;
+};
+#endif
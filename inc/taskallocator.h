@@ -0,0 +1,78 @@
+#ifndef TASKALLOCATOR_H
+#define TASKALLOCATOR_H
+#include <memory>
+#include <new>
+#include <cstddef>
+#include <utility>
+#include "flexipoolexport.h"
+
+/*
+任务对象的内存池：按大小分级的空闲链表
+- 每个线程缓存一部分空闲块，分配和释放都不加锁
+- 线程缓存过多或者用完时，和全局仓库整批交换（一次加锁移动SLAB_BATCH个块）
+- 仓库也没有空闲块时一次向系统申请一整批，之后不再归还，预热后提交任务不再调用malloc
+- 大于SLAB_MAX_SIZE的请求直接使用operator new
+- 块只保证std::max_align_t的对齐，对齐要求更高的类型不能从内存池分配（编译时检查）
+*/
+const size_t SLAB_MIN_SIZE = 32;   // 最小的块大小，各级依次翻倍
+const size_t SLAB_MAX_SIZE = 1024; // 最大的块大小
+const size_t SLAB_CLASSES = 6;     // 32 64 128 256 512 1024
+const size_t SLAB_BATCH = 64;      // 线程缓存和仓库之间一次交换的块数量
+
+class FLEXIPOOL_API SlabPool
+{
+public:
+    static void *allocate(size_t bytes);
+    static void deallocate(void *p, size_t bytes);
+};
+
+// 标准库分配器接口，用于std::allocate_shared和容器
+template <typename T>
+class PoolAllocator
+{
+public:
+    using value_type = T;
+    template <typename U>
+    struct rebind
+    {
+        using other = PoolAllocator<U>;
+    };
+
+    PoolAllocator() = default;
+    template <typename U>
+    PoolAllocator(const PoolAllocator<U> &) {}
+
+    T *allocate(size_t n)
+    {
+        static_assert(alignof(T) <= alignof(std::max_align_t), "over-aligned types cannot be allocated from SlabPool.");
+        return static_cast<T *>(SlabPool::allocate(n * sizeof(T)));
+    }
+    void deallocate(T *p, size_t n)
+    {
+        SlabPool::deallocate(p, n * sizeof(T));
+    }
+};
+
+template <typename T, typename U>
+bool operator==(const PoolAllocator<T> &, const PoolAllocator<U> &)
+{
+    return true;
+}
+template <typename T, typename U>
+bool operator!=(const PoolAllocator<T> &, const PoolAllocator<U> &)
+{
+    return false;
+}
+
+/*
+从内存池创建任务，控制块和任务对象一次分配
+example:
+pool.submitTask(makeTask<MyTask>(1, 100));
+*/
+template <typename T, typename... Args>
+std::shared_ptr<T> makeTask(Args &&...args)
+{
+    static_assert(alignof(T) <= alignof(std::max_align_t), "over-aligned tasks cannot be allocated from SlabPool.");
+    return std::allocate_shared<T>(PoolAllocator<T>(), std::forward<Args>(args)...);
+}
+#endif
@@ -0,0 +1,80 @@
+#ifndef TASKGRAPH_H
+#define TASKGRAPH_H
+#include "threadpool.h"
+
+/*
+任务依赖图（DAG）：节点的所有前驱完成后，由完成最后一个前驱的线程直接把节点放入线程池，
+执行过程中没有线程阻塞等待依赖
+- 某个节点抛出异常时，依赖它的节点（直接或者间接）不再执行，run()的返回值得到第一个异常
+- 图可以多次执行，执行期间不能修改
+example:
+TaskGraph graph(pool);
+TaskGraph::Node load = graph.add([]() { ... });
+TaskGraph::Node left = graph.add([]() { ... });
+TaskGraph::Node right = graph.add([]() { ... });
+TaskGraph::Node merge = graph.add([]() { ... });
+graph.precede(load, left);
+graph.precede(load, right);
+graph.precede(left, merge);
+graph.precede(right, merge);
+graph.run().then([]() { ... }); // 或者graph.wait()
+*/
+class FLEXIPOOL_API TaskGraph
+{
+public:
+    using Node = size_t;
+
+    explicit TaskGraph(ThreadPool &pool);
+    // 等待正在进行的执行完成
+    ~TaskGraph();
+    TaskGraph(const TaskGraph &) = delete;
+    TaskGraph &operator=(const TaskGraph &) = delete;
+
+    // 添加一个节点，func的返回值被忽略
+    template <typename F>
+    Node add(F func)
+    {
+        nodes_.emplace_back(new NodeState(UniqueFunction<void()>(std::move(func))));
+        return nodes_.size() - 1;
+    }
+    // before完成之后才能执行after
+    void precede(Node before, Node after);
+    // 节点数量
+    size_t size() const
+    {
+        return nodes_.size();
+    }
+
+    /*
+    执行整个图：没有前驱的节点立即提交，所有节点完成时返回值完成
+    上一次执行还没有结束时先等待它结束；图中有环时抛出std::logic_error
+    */
+    TypedResult<void> run();
+    // 阻塞直到最近一次执行完成，节点抛出的第一个异常在这里重新抛出
+    void wait();
+
+private:
+    struct NodeState
+    {
+        explicit NodeState(UniqueFunction<void()> f) : func(std::move(f)), dependencies(0), pending(0), skip(false) {}
+        UniqueFunction<void()> func;
+        std::vector<Node> successors; // 依赖当前节点的节点
+        size_t dependencies;          // 前驱的数量
+        std::atomic_size_t pending;   // 本次执行还没有完成的前驱数量
+        std::atomic_bool skip;        // 有前驱失败，本次执行跳过
+    };
+    class GraphState; // 一次执行的完成状态
+    class NodeTask;   // 执行一个节点的任务
+
+    // 执行节点（discarded为true时节点被取消，按照失败处理），然后释放它的后继
+    void runNode(Node node, const std::shared_ptr<GraphState> &state, bool discarded);
+    // 节点的一个前驱完成，最后一个前驱完成时提交节点
+    void release(Node node, bool skip, const std::shared_ptr<GraphState> &state);
+    // 检查图中是否有环
+    bool hasCycle() const;
+
+    ThreadPool &pool_;
+    std::vector<std::unique_ptr<NodeState>> nodes_;
+    std::shared_ptr<GraphState> state_; // 最近一次执行的完成状态
+};
+#endif
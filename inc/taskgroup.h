@@ -0,0 +1,98 @@
+#ifndef TASKGROUP_H
+#define TASKGROUP_H
+#include "threadpool.h"
+
+/*
+分治任务组（类似Cilk的spawn/sync）：
+- spawn(func)：在工作窃取模式的工作线程中，子任务放入当前线程本地队列的底部（后进先出）
+- sync()：等待所有子任务完成；在工作线程中等待时，先从本地队列底部取回还没有被窃取的子任务直接执行，
+  执行顺序是深度优先，工作集保持在当前线程的缓存中，只有空闲线程窃取走的子任务才在其他线程执行
+- 子任务抛出的第一个异常在sync()中重新抛出；队列满时子任务在spawn中直接执行
+spawn和sync只能由创建任务组的线程调用，子任务中需要再拆分时使用自己的任务组
+example:
+long sum(ThreadPool &pool, const int *p, size_t n)
+{
+    if (n < 1024)
+        return std::accumulate(p, p + n, 0L);
+    long left = 0;
+    TaskGroup group(pool);
+    group.spawn([&]() { left = sum(pool, p, n / 2); });
+    long right = sum(pool, p + n / 2, n - n / 2);
+    group.sync();
+    return left + right;
+}
+*/
+class FLEXIPOOL_API TaskGroup
+{
+public:
+    explicit TaskGroup(ThreadPool &pool);
+    // 等待还没有完成的子任务，不重新抛出异常
+    ~TaskGroup();
+    TaskGroup(const TaskGroup &) = delete;
+    TaskGroup &operator=(const TaskGroup &) = delete;
+
+    // 派生一个子任务，func的返回值被忽略
+    template <typename Func>
+    void spawn(Func &&func)
+    {
+        pending_.fetch_add(1, std::memory_order_relaxed);
+        schedule(makeTask<GroupTask<typename std::decay<Func>::type>>(this, std::forward<Func>(func)));
+    }
+    // 阻塞直到所有子任务完成，子任务抛出的第一个异常在这里重新抛出；之后可以继续spawn
+    void sync();
+    // 还没有完成的子任务数量
+    size_t pending() const
+    {
+        return pending_.load(std::memory_order_acquire) - 1;
+    }
+
+private:
+    template <typename F>
+    class GroupTask : public Task
+    {
+    public:
+        template <typename T>
+        GroupTask(TaskGroup *group, T &&func) : group_(group), func_(std::forward<T>(func)) {}
+        Any run()
+        {
+            try
+            {
+                func_();
+            }
+            catch (...)
+            {
+                group_->fail(std::current_exception());
+            }
+            group_->childDone();
+            return Any();
+        }
+
+    protected:
+        // 线程池关闭时被取消：按照失败处理，sync()仍然能够返回
+        void onDiscard()
+        {
+            group_->fail(std::make_exception_ptr(std::runtime_error("task was discarded before running.")));
+            group_->childDone();
+        }
+
+    private:
+        TaskGroup *group_;
+        F func_;
+    };
+
+    // 放入任务队列（工作线程中放入本地队列），队列满时直接执行
+    void schedule(std::shared_ptr<Task> task);
+    // 记录第一个异常
+    void fail(std::exception_ptr error);
+    // 一个子任务完成，最后一个完成时唤醒sync()
+    void childDone();
+    // 等待所有子任务完成
+    void waitChildren();
+
+    ThreadPool &pool_;
+    std::atomic_size_t pending_; // 没有完成的子任务数量加上等待者的一个引用
+    Completion done_;            // 最后一个引用被放弃，每轮等待之后重新置为未完成
+    std::mutex errorMtx_;
+    std::exception_ptr error_;
+};
+#endif
@@ -8,45 +8,145 @@
 #include <condition_variable>
 #include <functional>
 #include <thread>
+#include <chrono>
 #include <iostream>
 #include <unordered_map>
+#include <iterator>
+#include <cstdint>
+#include <algorithm>
+#include <exception>
+#include <stdexcept>
+#include <type_traits>
+#include <new>
+#include <deque>
+#include "workstealingqueue.h"
+#include "mpmcqueue.h"
+#include "parker.h"
+#include "logger.h"
+#include "poolstats.h"
+#include "multilevelqueue.h"
+#include "taskallocator.h"
+#include "cputopology.h"
+#include "elasticity.h"
+#include "cancellation.h"
+#include "timerqueue.h"
+#include "completion.h"
+#include "uniquefunction.h"
+#include "tracer.h"
+#include "steadyclock.h"
+#include "flexipoolexport.h"
 
 // 参数设置
 const size_t TASK_MAX_THRESHOLD = INT32_MAX;
 const size_t THREAD_MAX_THRESHHOLD = 1024;
-const size_t THREAD_IDLE_TIME = 2; // 单位：秒
+const size_t THREAD_IDLE_TIME = 2; // 单位：秒，cached模式下默认的线程空闲超时
+const size_t ELASTIC_INTERVAL = 50; // 单位：毫秒，cached模式下监督线程默认的采样周期
+const size_t ELASTIC_GROWTH_MIN = 4; // cached模式下监督线程每次最多让线程数量翻倍，线程很少时每次至少可以增加这么多
+const size_t TASK_RING_DEFAULT_SIZE = 1024; // 环形缓冲区模式下未设置任务队列上限阈值时的默认容量
+const int64_t THREAD_SPIN_MIN_NS = 1000;    // 单位：纳秒，IDLE_ADAPTIVE下空闲线程挂起前最少自旋的时间
+const int64_t THREAD_SPIN_MAX_NS = 50000;   // 单位：纳秒，IDLE_ADAPTIVE下最多自旋的时间，任务到达的间隔更长时直接挂起更省CPU
+const int64_t THREAD_SPIN_YIELD_NS = 20000; // 单位：纳秒，IDLE_SPIN_YIELD下开始让出CPU之前忙等的时间
+const size_t SUBMIT_TIMEOUT = 1000; // 单位：毫秒，POLICY_BLOCK策略下提交任务的默认最长等待时间
+const size_t TASK_AGING_TIME = 100; // 单位：毫秒，任务每排队这么久，有效优先级提升一级
+const size_t RING_DROP_RETRIES = 64; // 环形缓冲区模式下POLICY_DROP_OLDEST丢弃任务后重试入队的次数，之后按照POLICY_BLOCK等待
+const size_t RESULT_WAIT_SPIN = 256; // 工作线程中等待其他任务的返回值、又没有可以执行的任务时，挂起前自旋检查的次数
 
 // 线程池支持的模式
 enum class PoolMode // C++防止不同枚举类型，但是枚举项同名
 {
     MODE_FIXED,  // 固定数量的线程
     MODE_CACHED, // 线程数量可动态增长
+    MODE_WORK_STEALING, // 工作窃取：每个线程拥有本地无锁双端队列，空闲线程从其他线程窃取任务
 };
+
+// 任务队列的实现方式
+enum class TaskQueMode
+{
+    MODE_LOCKED,      // std::queue + 互斥锁（默认）
+    MODE_RING_BUFFER, // 无锁有界环形缓冲区，容量为不小于任务队列上限阈值的2的幂，生产者快速路径不加锁
+};
+
+// 任务队列满时的提交策略
+enum class SubmitPolicy
+{
+    POLICY_BLOCK,       // 阻塞等待队列有空余，超时后提交失败（默认）
+    POLICY_FAIL_FAST,   // 立即返回提交失败
+    POLICY_CALLER_RUNS, // 在提交任务的线程中直接执行任务
+    POLICY_DROP_OLDEST, // 丢弃队列中最老的任务（其结果立即完成），再放入新任务
+};
+// 工作线程的CPU绑定方式
+enum class AffinityMode
+{
+    AFFINITY_NONE, // 不绑定，由操作系统调度（默认）
+    AFFINITY_CORE, // 每个线程绑定到一个逻辑CPU，线程依次分配到各个NUMA节点
+    AFFINITY_NODE, // 每个线程绑定到所在NUMA节点的所有CPU，只在节点内迁移
+};
+// 空闲的工作线程如何等待新任务（延迟与CPU占用的取舍）
+enum class IdleStrategy
+{
+    IDLE_ADAPTIVE,   // 按照最近任务到达的间隔决定自旋多久，仍然没有任务再挂起（默认）
+    IDLE_BLOCK,      // 直接挂起，不自旋，CPU占用最低，适合批处理
+    IDLE_SPIN_YIELD, // 忙等一段时间后反复让出CPU，不挂起，提交者不需要唤醒
+    IDLE_BUSY_SPIN,  // 一直忙等，延迟最低，每个空闲线程占满一个核（单核机器上每次检查后让出CPU）
+};
+// 关闭线程池时如何处理排队中的任务
+enum class ShutdownMode
+{
+    SHUTDOWN_DRAIN,          // 执行完所有排队的任务再退出（默认，析构时使用）
+    SHUTDOWN_CANCEL_PENDING, // 排队的任务不再执行，其结果以“任务被丢弃”完成，只等待正在执行的任务
+};
+// 任务的优先级，数值越小越先执行
+enum class Priority
+{
+    PRIORITY_HIGH,   // 延迟敏感的任务
+    PRIORITY_NORMAL, // 默认
+    PRIORITY_LOW,    // 批量任务
+};
+const size_t PRIORITY_LEVELS = 3;
 /* 模板类需要先进行实例化才能使用,实例化的过程需要模板的定义。如果模板类定义在源文件中,使用时编译器无法访问其定义。 */
 
 // 仿C++17 Any类型：可以接受任意数据类型
+// 小对象优化：不超过ANY_INLINE_SIZE、可以无异常移动的类型直接存放在对象内部，不分配堆内存
+const size_t ANY_INLINE_SIZE = 3 * sizeof(void *);
 class Any
 {
 public:
-    Any() = default;
-    ~Any() = default;
+    Any() : base_(nullptr) {}
+    ~Any()
+    {
+        reset();
+    }
     Any(const Any &) = delete;
     Any &operator=(const Any &) = delete;
-    Any(Any &&) = default;
-    Any &operator=(Any &&) = default;
+    Any(Any &&other) : base_(nullptr)
+    {
+        moveFrom(other);
+    }
+    Any &operator=(Any &&other)
+    {
+        if (this != &other)
+        {
+            reset();
+            moveFrom(other);
+        }
+        return *this;
+    }
 
     // 这个构造函数可以让Any类型接收任意其它的数据
     template <typename T> // T:int Derive<int>
     // Any(T data) : base_(std::make_unique<Derive<T>>(data)){}; // c++14
-    Any(T data): base_(new Derive<T>(data)){}  // c++11
+    Any(T data) : base_(nullptr) // c++11
+    {
+        construct(std::move(data), std::integral_constant<bool, Derive<T>::isInline>());
+    }
     // 这个方法能把Any对象里面存储的data数据提取出来
     template <typename T>
     T cast_()
     {
         // 我们怎么从base_找到它所指向的Derive对象，从他里面取出data成员变量
         // 基类指针 =》派生类指针 RTTI类型识别
-        Derive<T> *pd = dynamic_cast<Derive<T> *>(base_.get()); // 取出裸指针
-        if (pd == nullptr)                                      // 如 T:int 但是用户传入了非int
+        Derive<T> *pd = dynamic_cast<Derive<T> *>(base_); // 取出裸指针
+        if (pd == nullptr)                                 // 如 T:int 但是用户传入了非int
         {
             throw "type is unmatch!";
         }
@@ -59,65 +159,137 @@ private:
     public:
         /* 如果不将基类析构函数设为虚函数,那么删除派生类对象时,只会调用基类的析构函数,导致内存泄露和未定义行为。 */
         virtual ~Base() = default; // 如果是默认实现，建议使用default会得到编译器优化
+        // 把自己移动构造到另一个Any的内部缓冲区
+        virtual Base *moveTo(void *buffer) = 0;
+        virtual bool isInlineStored() const = 0;
     };
     template <typename T>
     class Derive : public Base
     {
     public:
-        Derive(T data) : data_(data) {}
+        static const bool isInline = sizeof(T) <= ANY_INLINE_SIZE && alignof(T) <= alignof(void *) &&
+                                     std::is_nothrow_move_constructible<T>::value;
+        Derive(T data) : data_(std::move(data)) {}
+        Base *moveTo(void *buffer)
+        {
+            return new (buffer) Derive<T>(std::move(data_));
+        }
+        bool isInlineStored() const
+        {
+            return isInline;
+        }
         T data_; // 保存了任意其他类型
     };
 
+    // 小对象直接构造在内部缓冲区
+    template <typename T>
+    void construct(T data, std::true_type)
+    {
+        base_ = new (&buffer_) Derive<T>(std::move(data));
+    }
+    template <typename T>
+    void construct(T data, std::false_type)
+    {
+        base_ = new Derive<T>(std::move(data));
+    }
+    void reset()
+    {
+        if (base_ == nullptr)
+            return;
+        if (base_->isInlineStored())
+            base_->~Base();
+        else
+            delete base_;
+        base_ = nullptr;
+    }
+    void moveFrom(Any &other)
+    {
+        if (other.base_ == nullptr)
+            return;
+        if (other.base_->isInlineStored())
+        {
+            base_ = other.base_->moveTo(&buffer_);
+            other.reset();
+        }
+        else
+        {
+            base_ = other.base_;
+            other.base_ = nullptr;
+        }
+    }
+
 private:
-    // 定义一个基类指针
-    std::unique_ptr<Base> base_;
+    // 定义一个基类指针，指向buffer_或者堆上的对象
+    Base *base_;
+    // 内部缓冲区：Derive对象包含虚表指针，所以多留一个指针的空间
+    typename std::aligned_storage<ANY_INLINE_SIZE + sizeof(void *), alignof(void *)>::type buffer_;
 };
 
-// 实现一个信号量
-class Semaphore
+// 任务完成（执行、丢弃或者跳过，Result已经写入）时的通知，批量提交的门闩和ResultSet使用
+class TaskObserver
 {
 public:
-    Semaphore(size_t limit = 0) : resLimit_(limit), isExit_(false) {}
-    ~Semaphore()
+    virtual ~TaskObserver() = default;
+    // index为任务附加观察者时指定的编号
+    virtual void taskDone(size_t index) = 0;
+};
+
+// 倒计数门闩：一组任务全部完成时只唤醒一次等待者
+class CountDownLatch : public TaskObserver
+{
+public:
+    explicit CountDownLatch(size_t count) : count_(count), done_(count == 0) {}
+    // 计数减一，减到0时唤醒所有等待者
+    void countDown()
     {
-        isExit_ = true;
+        if (count_.fetch_sub(1, std::memory_order_acq_rel) != 1)
+            return; // 不是最后一次，之后不再访问门闩
+        // 最后一次在锁内标记完成：等待者看到done_时这里已经不再访问门闩，门闩可以放在栈上
+        std::lock_guard<std::mutex> lock(mtx_);
+        done_ = true;
+        cond_.notify_all();
     }
-    // 获取一个信号量资源
+    // 阻塞直到计数为0
     void wait()
     {
-        if (isExit_)
-            return;
         std::unique_lock<std::mutex> lock(mtx_);
-        // 等待信号量有资源，没有资源的话，会阻塞当前线程
         cond_.wait(lock, [&]() -> bool
-                   { return resLimit_ > 0; });
-        resLimit_--;
+                   { return done_; });
     }
-
-    // 增加一个信号量资源
-    void post()
+    // 剩余的计数
+    size_t count() const
     {
-        if (isExit_)
-            return;
-        std::unique_lock<std::mutex> lock(mtx_);
-        resLimit_++;
-        cond_.notify_all();
+        return count_.load(std::memory_order_acquire);
+    }
+    // 作为任务的观察者：每个任务完成时计数减一
+    void taskDone(size_t)
+    {
+        countDown();
     }
 
 private:
-    size_t resLimit_;
-    std::atomic_bool isExit_; // 为了Linux环境下的Result析构能够正常
+    std::atomic_size_t count_;
+    bool done_; // 计数已经减到0，由mtx_保护
     std::mutex mtx_;
     std::condition_variable cond_;
 };
 
 // Task类型的前置声明
 class Task;
-class Result
+class ThreadPool;
+/*
+等待一个任务完成（Result::get和带类型结果的get使用）
+- 在工作线程的任务中等待时，不阻塞工作线程，而是继续执行排队的任务直到等待的任务完成，
+  固定模式下递归拆分的任务不会因为所有线程都在等待子任务而死锁
+- 没有可以执行的任务时（等待的任务正在其他线程中执行），短暂自旋后挂起
+*/
+FLEXIPOOL_API void waitCompletion(Completion &completion);
+class FLEXIPOOL_API Result
 {
 public:
     Result(std::shared_ptr<Task> task, bool isValid = true);
-    ~Result() = default;
+    // 析构时和任务解除绑定，任务线程正在写入返回值时等它写完
+    ~Result();
     Result(const Result &) = delete;
     Result &operator=(const Result &) = delete;
     Result(Result &&other);
@@ -129,28 +301,423 @@ public:
     Any get();
 
 private:
+    friend class ThreadPool; // 提交失败时由线程池把Result置为无效
+    friend class Executor;   // 执行器组的执行器同样在提交失败时置为无效
+    friend class ResultSet;  // 结果集合中提交失败的任务
+    friend class Strand;     // 线程池已经关闭时提交失败
+
     Any any_;                    // 存储任务的返回值，已经初始化了
-    Semaphore sem_;              // 线程通信信号量，已经初始化了
+    Completion completion_;      // 返回值已经写入，get()在这里等待
     std::shared_ptr<Task> task_; // 指向对应获取返回值的任务对象
     std::atomic_bool isValid_;   // 判断返回值是否有效
+    std::atomic_bool done_;      // 任务线程已经写完返回值，之后不再访问这个Result
 };
 
 // 任务抽象基类
-class Task
+class FLEXIPOOL_API Task
 {
 public:
     Task();
     ~Task() = default;
     void exec();
+    // 任务没有执行就被丢弃时调用，让等待结果的用户不会永久阻塞
+    void discard();
     void setResult(Result *res);
+    // 任务完成（执行或者丢弃）后对门闩计数减一，批量提交时使用
+    void setLatch(std::shared_ptr<CountDownLatch> latch);
+    // 任务完成后通知observer（提交之前调用），index原样传给observer；和setLatch互相覆盖
+    void setObserver(std::shared_ptr<TaskObserver> observer, size_t index);
+    // 任务提交到的线程池，还没有提交时为空
+    ThreadPool *pool() const
+    {
+        return pool_;
+    }
+    // 附加取消令牌（提交之前调用）
+    void setCancellationToken(const CancellationToken &token);
+    // 设置截止时间（提交之前调用）：开始执行时已经超过截止时间的任务被跳过
+    void setDeadline(std::chrono::steady_clock::time_point deadline);
+    // 令牌已经取消或者已经超过截止时间，正在执行的任务可以据此提前结束
+    bool isCancelled() const;
+    // 当前线程正在执行的任务，不在任务中时为空
+    static Task *current();
     virtual Any run() = 0;
 
+protected:
+    // 丢弃任务时如何完成结果，默认让Result得到空的Any
+    virtual void onDiscard();
+    // 任务因为取消或者超过截止时间被跳过时如何完成结果，默认和丢弃相同
+    virtual void onCancel();
+    // 不经过提交的任务（例如whenAll的汇合状态）指定后续任务使用的线程池
+    void setPool(ThreadPool *pool)
+    {
+        pool_ = pool;
+    }
+
 private:
-    Result *result_; // Result对象的生命周期>Task对象
+    friend class ThreadPool; // 线程池在提交时记录提交时间和优先级
+    friend class Result;     // Result移动和析构时重新绑定
+
+    // 取走绑定的Result，任务线程和Result析构只有一方能取到
+    Result *takeResult();
+    // 开始执行时已经取消或者超过截止时间（now为steady_clock纳秒）
+    bool expired(int64_t now) const;
+    // 跳过已经取消的任务：完成结果，对门闩计数减一
+    void skip();
+
+    std::atomic<Result *> result_;          // 绑定的Result，Result先析构时置空
+    std::shared_ptr<TaskObserver> observer_; // 完成时通知的观察者（所属批次的门闩、ResultSet），没有时为空
+    size_t observerIndex_;                   // 通知观察者时带上的编号
+    int64_t submitTime_;                    // 放入任务队列的时间（steady_clock纳秒），用于统计排队时间
+    Priority priority_;                     // 提交时指定的优先级
+    bool holdsSlot_;                        // 执行时是否占用了所属优先级的并发名额
+    ThreadPool *pool_;                      // 提交到的线程池，then的后续任务放入同一个线程池
+    std::shared_ptr<CancellationToken::State> cancelState_; // 取消令牌的共享标志，没有附加令牌时为空
+    int64_t deadline_;                      // 截止时间（steady_clock纳秒），0表示没有截止时间
+};
+
+/*
+带类型返回值的任务：ThreadPool::submit(func, args...)使用
+任务对象本身就是任务与提交者之间唯一的共享状态（从内存池一次分配），
+返回值内联存放在共享状态里，不经过Any的堆分配和dynamic_cast
+*/
+// 共享状态中与返回值类型无关的部分：完成标志、等待、异常
+class TypedStateBase : public Task
+{
+public:
+    TypedStateBase() {}
+    // 任务是否已经完成
+    bool ready() const
+    {
+        return ready_.isSet();
+    }
+    // 阻塞直到任务完成
+    void wait()
+    {
+        waitCompletion(ready_);
+    }
+    // 任务以异常结束（包括提交失败）
+    void setError(std::exception_ptr error)
+    {
+        error_ = error;
+        setReady();
+    }
+    // 任务完成（包括失败）后在完成它的线程中调用callback，已经完成时立即在当前线程调用
+    void onReady(UniqueFunction<void()> callback)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mtx_);
+            if (!ready_.isSet())
+            {
+                callbacks_.emplace_back(std::move(callback));
+                return;
+            }
+        }
+        callback();
+    }
+protected:
+    // 任务没有执行就被丢弃
+    void onDiscard()
+    {
+        setError(std::make_exception_ptr(std::runtime_error("task was discarded before running.")));
+    }
+    // 任务因为取消或者超过截止时间被跳过
+    void onCancel()
+    {
+        setError(std::make_exception_ptr(TaskCancelled()));
+    }
+
+    void setReady()
+    {
+        std::vector<UniqueFunction<void()>> callbacks;
+        {
+            std::lock_guard<std::mutex> lock(mtx_);
+            ready_.set();
+            callbacks.swap(callbacks_);
+        }
+        // 在锁外调用，回调中可以继续注册或者提交任务
+        for (auto &callback : callbacks)
+        {
+            callback();
+        }
+    }
+    void rethrowIfError()
+    {
+        if (error_)
+            std::rethrow_exception(error_);
+    }
+
+private:
+    Completion ready_; // 任务已经完成（包括失败），等待者在这里挂起
+    std::exception_ptr error_;
+    std::mutex mtx_;   // 只保护回调列表，等待完成不需要加锁
+    std::vector<UniqueFunction<void()>> callbacks_; // 完成时要调用的回调（then、whenAll注册），由mtx_保护
+};
+
+template <typename R>
+class TypedState : public TypedStateBase
+{
+    static_assert(!std::is_reference<R>::value, "submit() does not support reference return types");
+
+public:
+    TypedState() : hasValue_(false) {}
+    ~TypedState()
+    {
+        if (hasValue_)
+            value()->~R();
+    }
+    // 执行可调用对象，把返回值直接构造在共享状态中
+    template <typename F>
+    void invoke(F &func)
+    {
+        try
+        {
+            new (&storage_) R(func());
+            hasValue_ = true;
+        }
+        catch (...)
+        {
+            setError(std::current_exception());
+            return;
+        }
+        setReady();
+    }
+    // 等待任务完成并把返回值移动给调用者，任务抛出的异常在这里重新抛出
+    R take()
+    {
+        wait();
+        rethrowIfError();
+        return std::move(*value());
+    }
+
+private:
+    R *value()
+    {
+        return reinterpret_cast<R *>(&storage_);
+    }
+    typename std::aligned_storage<sizeof(R), alignof(R)>::type storage_;
+    bool hasValue_;
+};
+
+template <>
+class TypedState<void> : public TypedStateBase
+{
+public:
+    template <typename F>
+    void invoke(F &func)
+    {
+        try
+        {
+            func();
+        }
+        catch (...)
+        {
+            setError(std::current_exception());
+            return;
+        }
+        setReady();
+    }
+    void take()
+    {
+        wait();
+        rethrowIfError();
+    }
+};
+
+// 保存可调用对象的任务，F为std::bind绑定参数后的类型
+template <typename R, typename F>
+class FuncTask : public TypedState<R>
+{
+public:
+    explicit FuncTask(F func) : func_(std::move(func)) {}
+    // 返回值已经写入共享状态，这里返回空的Any（不分配内存）
+    Any run()
+    {
+        this->invoke(func_);
+        return Any();
+    }
+
+private:
+    F func_;
+};
+
+/*
+任务队列的槽位（只能移动），多级队列、环形缓冲区、节点队列和工作窃取的本地队列都存放这个类型
+- post提交的可调用对象直接保存在func中：不超过FUNCTION_INLINE_SIZE、可以无异常移动的lambda就存放在槽位里，
+  从提交到执行一路移动，不分配任务对象，出队时也不修改引用计数
+- 其他提交方式保存std::shared_ptr<Task>（适配器）：结果、取消、截止时间和观察者仍然由Task实现
+*/
+struct QueuedTask
+{
+    QueuedTask() : submitTime(0), priority(Priority::PRIORITY_NORMAL), holdsSlot(false) {}
+    QueuedTask(std::shared_ptr<Task> sp, int64_t now, Priority level)
+        : task(std::move(sp)), submitTime(now), priority(level), holdsSlot(false) {}
+    QueuedTask(UniqueFunction<void()> f, int64_t now)
+        : func(std::move(f)), submitTime(now), priority(Priority::PRIORITY_NORMAL), holdsSlot(false) {}
+    QueuedTask(QueuedTask &&) = default;
+    QueuedTask &operator=(QueuedTask &&) = default;
+    // 跟踪事件关联用的id：任务的地址；可调用对象入队、出队时被移动，没有固定的地址，用提交时间代替
+    const void *traceId() const
+    {
+        return task != nullptr ? static_cast<const void *>(task.get()) : reinterpret_cast<const void *>(static_cast<uintptr_t>(submitTime));
+    }
+
+    std::shared_ptr<Task> task;  // 为空时槽位保存的是post的可调用对象
+    UniqueFunction<void()> func; // post的可调用对象
+    int64_t submitTime;          // 入队时间（steady_clock的纳秒）
+    Priority priority;           // post的可调用对象总是普通优先级
+    bool holdsSlot;              // 取出时是否占用了所属优先级的并发名额
+};
+
+// then的后续任务：取出前一个任务的返回值交给func，前一个任务的异常在take()中重新抛出并传递下去
+template <typename R, typename F>
+class ThenCall
+{
+public:
+    using result_type = typename std::decay<decltype(std::declval<F &>()(std::declval<R>()))>::type;
+    ThenCall(std::shared_ptr<TypedState<R>> prev, F func) : prev_(std::move(prev)), func_(std::move(func)) {}
+    result_type operator()()
+    {
+        return func_(prev_->take());
+    }
+
+private:
+    std::shared_ptr<TypedState<R>> prev_;
+    F func_;
+};
+
+template <typename F>
+class ThenCall<void, F>
+{
+public:
+    using result_type = typename std::decay<decltype(std::declval<F &>()())>::type;
+    ThenCall(std::shared_ptr<TypedState<void>> prev, F func) : prev_(std::move(prev)), func_(std::move(func)) {}
+    result_type operator()()
+    {
+        prev_->take();
+        return func_();
+    }
+
+private:
+    std::shared_ptr<TypedState<void>> prev_;
+    F func_;
+};
+
+// ThreadPool::submit的返回值，类似std::future<R>
+template <typename R>
+class TypedResult
+{
+public:
+    TypedResult() = default;
+    explicit TypedResult(std::shared_ptr<TypedState<R>> state) : state_(std::move(state)) {}
+    // 是否关联了任务
+    bool valid() const
+    {
+        return state_ != nullptr;
+    }
+    // 任务是否已经完成（不阻塞）
+    bool ready() const
+    {
+        return state_ != nullptr && state_->ready();
+    }
+    // 阻塞直到任务完成
+    void wait() const
+    {
+        state_->wait();
+    }
+    // 获取返回值，任务没有执行完会阻塞；只能调用一次
+    R get()
+    {
+        return state_->take();
+    }
+    // 任务完成（包括失败）后在完成它的线程中调用callback，已经完成时立即在当前线程调用
+    void onReady(UniqueFunction<void()> callback) const
+    {
+        state_->onReady(std::move(callback));
+    }
+    // 任务提交到的线程池
+    ThreadPool *pool() const
+    {
+        return state_->pool();
+    }
+    /*
+    注册后续任务：本任务完成后，由完成它的线程把func(返回值)直接放入同一个线程池，没有线程阻塞等待
+    本任务以异常结束时不调用func，异常传递给返回的TypedResult
+    返回值被移动给func，调用之后当前对象不再关联任务
+    example:
+    pool.submit(load, path).then([](Data d) { return parse(d); }).then([](Doc doc) { index(doc); });
+    */
+    template <typename F>
+    TypedResult<typename ThenCall<R, F>::result_type> then(F func);
+
+private:
+    std::shared_ptr<TypedState<R>> state_;
+};
+
+// ThreadPool::submitBatch提交一组Task的返回值
+class BatchResult
+{
+public:
+    BatchResult(std::vector<Result> results, std::shared_ptr<CountDownLatch> latch)
+        : results_(std::move(results)), latch_(std::move(latch)) {}
+    // 批次中任务的数量
+    size_t size() const
+    {
+        return results_.size();
+    }
+    // 批次中所有任务是否都已完成（不阻塞）
+    bool ready() const
+    {
+        return latch_->count() == 0;
+    }
+    // 阻塞直到批次中所有任务完成，只会被唤醒一次
+    void wait()
+    {
+        latch_->wait();
+    }
+    // 单个任务的结果，和submitTask返回的Result用法相同
+    Result &operator[](size_t i)
+    {
+        return results_[i];
+    }
+
+private:
+    std::vector<Result> results_; // 预留了容量，Result的地址在提交后不会改变
+    std::shared_ptr<CountDownLatch> latch_;
+};
+
+// ThreadPool::submitBatch提交一组可调用对象的返回值
+template <typename R>
+class TypedBatchResult
+{
+public:
+    TypedBatchResult(std::vector<TypedResult<R>> results, std::shared_ptr<CountDownLatch> latch)
+        : results_(std::move(results)), latch_(std::move(latch)) {}
+    size_t size() const
+    {
+        return results_.size();
+    }
+    bool ready() const
+    {
+        return latch_->count() == 0;
+    }
+    // 阻塞直到批次中所有任务完成，只会被唤醒一次
+    void wait()
+    {
+        latch_->wait();
+    }
+    // 单个任务的结果
+    TypedResult<R> &operator[](size_t i)
+    {
+        return results_[i];
+    }
+
+private:
+    std::vector<TypedResult<R>> results_;
+    std::shared_ptr<CountDownLatch> latch_;
 };
 
 // 线程类型
-class Thread
+class FLEXIPOOL_API Thread
 {
 public:
     // 定义线程函数对象类型
@@ -161,12 +728,15 @@ public:
     ~Thread();
     // 启动线程
     void start();
+    // 等待线程函数返回，不能在线程自己中调用
+    void join();
     // 获取线程id
     size_t getId() const;
 
 private:
     ThreadFunc func_;
-    static size_t generateId_; // 自定义线程id
+    std::thread thread_;
+    static std::atomic_size_t generateId_; // 自定义线程id（cached模式下由监督线程创建线程）
     size_t threadId_;          // 保存线程id
 };
 /*
@@ -184,7 +754,7 @@ pool.submitTask(std::make_shared<MyTask>());
 */
 
 // 线程池类型
-class ThreadPool
+class FLEXIPOOL_API ThreadPool
 {
 public:
     // 线程池构造
@@ -201,35 +771,703 @@ public:
     // 设置线程池cached模式下的线程上限阈值
     void setThreadMaxThreshHold(size_t threshhold);
 
-    // 给线程池提交任务
+    // 设置cached模式下的线程空闲超时：负载持续低于线程数这么久才开始回收，线程空闲这么久才退出
+    void setThreadIdleTimeout(std::chrono::milliseconds timeout);
+
+    // 设置cached模式下监督线程的采样周期
+    void setElasticInterval(std::chrono::milliseconds interval);
+
+    // 设置任务队列的实现方式
+    void setTaskQueMode(TaskQueMode mode);
+
+    // 设置任务队列满时默认的提交策略
+    void setSubmitPolicy(SubmitPolicy policy);
+
+    // 设置POLICY_BLOCK策略下提交任务的最长等待时间
+    void setSubmitTimeout(std::chrono::milliseconds timeout);
+
+    // 设置优先级老化时间：任务每排队这么久，有效优先级提升一级（0表示不老化）
+    void setPriorityAging(std::chrono::milliseconds aging);
+
+    // 设置某个优先级同时执行的任务数量上限，避免批量任务占满所有线程
+    void setPriorityConcurrency(Priority priority, size_t maxRunning);
+
+    // 设置工作线程的CPU绑定方式，绑定后每个NUMA节点有一个任务队列分片
+    void setAffinityMode(AffinityMode mode);
+
+    // 设置空闲线程等待新任务的方式，cached模式下的空闲超时对所有方式都有效
+    void setIdleStrategy(IdleStrategy strategy);
+
+    // 使用自定义的CPU拓扑代替自动检测（例如只使用部分CPU）
+    void setCpuTopology(const CpuTopology &topology);
+
+    // 线程池使用的NUMA节点数量（start之后有效，没有设置CPU绑定时为1）
+    size_t nodeCount() const;
+
+    // 给线程池提交任务（使用默认的提交策略）
     Result submitTask(std::shared_ptr<Task> sp);
 
+    // 给线程池提交任务，指定本次提交在任务队列满时的策略
+    Result submitTask(std::shared_ptr<Task> sp, SubmitPolicy policy);
+
+    // 尝试提交任务，任务队列满时立即失败（Result无效）
+    Result trySubmitTask(std::shared_ptr<Task> sp);
+
+    // 按照优先级提交任务（使用默认的提交策略）
+    Result submitTask(std::shared_ptr<Task> sp, Priority priority);
+
+    /*
+    给线程池提交任意可调用对象和参数，返回带类型的结果
+    example:
+    TypedResult<int> res = pool.submit([](int a, int b) { return a + b; }, 1, 2);
+    int sum = res.get();
+    */
+    template <typename Func, typename... Args>
+    auto submit(Func &&func, Args &&...args) -> TypedResult<decltype(func(args...))>
+    {
+        return submit(submitPolicy_, std::forward<Func>(func), std::forward<Args>(args)...);
+    }
+
+    // 指定本次提交在任务队列满时的策略，提交失败时get()抛出std::runtime_error
+    template <typename Func, typename... Args>
+    auto submit(SubmitPolicy policy, Func &&func, Args &&...args) -> TypedResult<decltype(func(args...))>
+    {
+        using RType = decltype(func(args...));
+        using BindType = decltype(std::bind(std::forward<Func>(func), std::forward<Args>(args)...));
+        std::shared_ptr<FuncTask<RType, BindType>> task =
+            makeTask<FuncTask<RType, BindType>>(std::bind(std::forward<Func>(func), std::forward<Args>(args)...));
+        if (!enqueueTask(task, policy))
+        {
+            task->setError(std::make_exception_ptr(std::runtime_error("task queue is full, submit task failed.")));
+        }
+        return TypedResult<RType>(task);
+    }
+
+    /*
+    提交不需要返回值的可调用对象（fire-and-forget）：可调用对象一路移动到任务队列的槽位中（QueuedTask），
+    小的可调用对象不分配内存，没有结果状态，可以是只能移动的可调用对象
+    提交失败返回false；可调用对象抛出的异常被记录后忽略
+    example:
+    pool.post([conn]() { conn->flush(); });
+    */
+    template <typename Func>
+    bool post(Func &&func)
+    {
+        return enqueueFunc(UniqueFunction<void()>(std::forward<Func>(func)));
+    }
+
+    // 按照优先级提交任意可调用对象
+    template <typename Func, typename... Args>
+    auto submit(Priority priority, Func &&func, Args &&...args) -> TypedResult<decltype(func(args...))>
+    {
+        using RType = decltype(func(args...));
+        using BindType = decltype(std::bind(std::forward<Func>(func), std::forward<Args>(args)...));
+        std::shared_ptr<FuncTask<RType, BindType>> task =
+            makeTask<FuncTask<RType, BindType>>(std::bind(std::forward<Func>(func), std::forward<Args>(args)...));
+        if (!enqueueTask(task, submitPolicy_, priority))
+        {
+            task->setError(std::make_exception_ptr(std::runtime_error("task queue is full, submit task failed.")));
+        }
+        return TypedResult<RType>(task);
+    }
+
+    /*
+    附加取消令牌和（或）截止时间提交：开始执行时已经取消或者超过截止时间的任务被跳过，get()抛出TaskCancelled
+    正在执行的任务可以检查token.isCancelled()或者Task::current()->isCancelled()提前结束
+    example:
+    CancellationToken token;
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(50);
+    TypedResult<Reply> res = pool.submit(token, deadline, handle, request);
+    token.cancel(); // RPC超时，还在排队的子任务不再执行
+    */
+    template <typename Func, typename... Args>
+    auto submit(const CancellationToken &token, std::chrono::steady_clock::time_point deadline, Func &&func, Args &&...args) -> TypedResult<decltype(func(args...))>
+    {
+        return submitCancellable(&token, deadline, std::forward<Func>(func), std::forward<Args>(args)...);
+    }
+
+    template <typename Func, typename... Args>
+    auto submit(const CancellationToken &token, Func &&func, Args &&...args) -> TypedResult<decltype(func(args...))>
+    {
+        return submitCancellable(&token, std::chrono::steady_clock::time_point::max(), std::forward<Func>(func), std::forward<Args>(args)...);
+    }
+
+    template <typename Func, typename... Args>
+    auto submit(std::chrono::steady_clock::time_point deadline, Func &&func, Args &&...args) -> TypedResult<decltype(func(args...))>
+    {
+        return submitCancellable(nullptr, deadline, std::forward<Func>(func), std::forward<Args>(args)...);
+    }
+
+    /*
+    定时提交：到期后由定时线程整批放入任务队列（按照默认的提交策略），不占用工作线程
+    线程池关闭时还没有到期的任务被取消
+    example:
+    pool.submitAfter(std::chrono::milliseconds(200), retry, request);
+    */
+    Result submitTaskAfter(std::chrono::steady_clock::duration delay, std::shared_ptr<Task> sp);
+    Result submitTaskAt(std::chrono::steady_clock::time_point when, std::shared_ptr<Task> sp);
+
+    template <typename Func, typename... Args>
+    auto submitAfter(std::chrono::steady_clock::duration delay, Func &&func, Args &&...args) -> TypedResult<decltype(func(args...))>
+    {
+        return submitAt(std::chrono::steady_clock::now() + delay, std::forward<Func>(func), std::forward<Args>(args)...);
+    }
+
+    template <typename Func, typename... Args>
+    auto submitAt(std::chrono::steady_clock::time_point when, Func &&func, Args &&...args) -> TypedResult<decltype(func(args...))>
+    {
+        using RType = decltype(func(args...));
+        using BindType = decltype(std::bind(std::forward<Func>(func), std::forward<Args>(args)...));
+        std::shared_ptr<FuncTask<RType, BindType>> task =
+            makeTask<FuncTask<RType, BindType>>(std::bind(std::forward<Func>(func), std::forward<Args>(args)...));
+        if (!scheduleTask(task, when))
+        {
+            task->setError(std::make_exception_ptr(std::runtime_error("thread pool has been shut down, submit task failed.")));
+        }
+        return TypedResult<RType>(task);
+    }
+
+    /*
+    周期任务：每隔period执行一次func，返回的令牌取消后不再执行
+    上一次执行完成后才安排下一次（同一个周期任务不会同时执行），落后时不补执行错过的次数；func抛出的异常被记录后忽略
+    */
+    CancellationToken scheduleEvery(std::chrono::steady_clock::duration period, UniqueFunction<void()> func);
+
+    /*
+    提交到指定的NUMA节点：由该节点的线程优先执行，其他节点的线程空闲时也可以取走
+    节点编号超出范围时取模；没有设置CPU绑定时和普通提交相同
+    节点队列满时除了POLICY_CALLER_RUNS之外都立即失败
+    */
+    Result submitTaskToNode(std::shared_ptr<Task> sp, size_t node);
+
+    template <typename Func, typename... Args>
+    auto submitToNode(size_t node, Func &&func, Args &&...args) -> TypedResult<decltype(func(args...))>
+    {
+        using RType = decltype(func(args...));
+        using BindType = decltype(std::bind(std::forward<Func>(func), std::forward<Args>(args)...));
+        std::shared_ptr<FuncTask<RType, BindType>> task =
+            makeTask<FuncTask<RType, BindType>>(std::bind(std::forward<Func>(func), std::forward<Args>(args)...));
+        if (!enqueueNodeTask(task, node))
+        {
+            task->setError(std::make_exception_ptr(std::runtime_error("task queue is full, submit task failed.")));
+        }
+        return TypedResult<RType>(task);
+    }
+
+    // 尝试提交，任务队列满时立即失败
+    template <typename Func, typename... Args>
+    auto trySubmit(Func &&func, Args &&...args) -> TypedResult<decltype(func(args...))>
+    {
+        return submit(SubmitPolicy::POLICY_FAIL_FAST, std::forward<Func>(func), std::forward<Args>(args)...);
+    }
+
+    /*
+    批量提交一组任务：只进入一次临界区，只唤醒min(N, 等待中的线程数)个线程
+    [first, last)的元素可以是std::shared_ptr<Task>（返回BatchResult），
+    也可以是无参数的可调用对象（返回TypedBatchResult<R>）
+    放不进任务队列的部分按照默认的提交策略逐个提交
+    */
+    template <typename Iter>
+    typename std::enable_if<std::is_convertible<typename std::iterator_traits<Iter>::value_type, std::shared_ptr<Task>>::value,
+                            BatchResult>::type
+    submitBatch(Iter first, Iter last)
+    {
+        std::vector<std::shared_ptr<Task>> tasks(first, last);
+        std::shared_ptr<CountDownLatch> latch = std::make_shared<CountDownLatch>(tasks.size());
+        std::vector<Result> results;
+        results.reserve(tasks.size()); // 预留容量，保证任务绑定的Result地址不变
+        for (auto &task : tasks)
+        {
+            task->setLatch(latch);
+            results.emplace_back(task);
+        }
+        size_t accepted = enqueueBatch(tasks);
+        for (size_t i = accepted; i < tasks.size(); i++)
+        {
+            if (!enqueueTask(tasks[i], submitPolicy_))
+            {
+                results[i].isValid_ = false;
+                latch->countDown();
+            }
+        }
+        return BatchResult(std::move(results), std::move(latch));
+    }
+
+    template <typename Iter>
+    auto submitBatch(Iter first, Iter last)
+        -> typename std::enable_if<!std::is_convertible<typename std::iterator_traits<Iter>::value_type, std::shared_ptr<Task>>::value,
+                                   TypedBatchResult<decltype((*first)())>>::type
+    {
+        using RType = decltype((*first)());
+        using FuncType = typename std::decay<decltype(*first)>::type;
+        std::vector<std::shared_ptr<Task>> tasks;
+        std::vector<TypedResult<RType>> results;
+        size_t n = static_cast<size_t>(std::distance(first, last));
+        tasks.reserve(n);
+        results.reserve(n);
+        std::shared_ptr<CountDownLatch> latch = std::make_shared<CountDownLatch>(n);
+        for (; first != last; ++first)
+        {
+            std::shared_ptr<FuncTask<RType, FuncType>> task = makeTask<FuncTask<RType, FuncType>>(*first);
+            task->setLatch(latch);
+            results.emplace_back(task);
+            tasks.emplace_back(std::move(task));
+        }
+        size_t accepted = enqueueBatch(tasks);
+        for (size_t i = accepted; i < tasks.size(); i++)
+        {
+            if (!enqueueTask(tasks[i], submitPolicy_))
+            {
+                std::static_pointer_cast<TypedStateBase>(tasks[i])->setError(std::make_exception_ptr(std::runtime_error("task queue is full, submit task failed.")));
+                latch->countDown();
+            }
+        }
+        return TypedBatchResult<RType>(std::move(results), std::move(latch));
+    }
+
+    // 获取线程池的运行统计快照（不会阻塞提交者和工作线程）
+    PoolStats stats();
+
+    /*
+    执行跟踪：记录提交、取出、开始、结束、窃取、提交者阻塞、线程挂起、线程创建和回收的事件
+    每个线程保留最近eventsPerThread个事件，可以在运行中随时开启、关闭和导出
+    */
+    void enableTracing(size_t eventsPerThread = TRACE_BUFFER_EVENTS);
+    void disableTracing();
+    // 导出为Chrome trace JSON，可以用chrome://tracing或者Perfetto UI打开
+    std::string traceJson() const;
+    bool dumpTrace(const std::string &path) const;
+
+    // 当前的线程数量
+    size_t threadCount() const;
+
+    // 当前没有在执行任务的线程数量（parallelFor等据此决定是否拆分剩余区间）
+    size_t idleThreadCount() const;
+
+#if defined(FLEXIPOOL_COROUTINES)
+    // co_await pool.schedule()：之后在工作线程中继续执行协程（定义在coroutine.h）
+    class ScheduleAwaiter schedule();
+#endif
+
     // 指定初始化线程数量，并开启线程池
     void start(size_t initThreadSize = std::thread::hardware_concurrency());
 
+    /*
+    关闭线程池，最多等待timeout让所有线程退出并回收（join），全部回收返回true
+    - 之后的提交：POLICY_CALLER_RUNS在提交者线程中执行，其余提交失败
+    - SHUTDOWN_DRAIN执行完排队的任务；SHUTDOWN_CANCEL_PENDING立即取消排队的任务
+    - 超时时取消剩余的排队任务并返回false，正在执行的任务不能被中断，析构时继续等待它们结束
+    可以重复调用；关闭后的线程池不能再次start
+    不能在这个线程池的工作线程中调用（任务、then回调等），否则抛出std::logic_error；析构同理
+    */
+    bool shutdown(ShutdownMode mode = ShutdownMode::SHUTDOWN_DRAIN, std::chrono::milliseconds timeout = std::chrono::milliseconds::max());
+
     // 禁止拷贝、赋值
     ThreadPool(const ThreadPool &) = delete;
     ThreadPool &operator=(const ThreadPool &) = delete;
 
 private:
+    template <typename R>
+    friend class TypedResult; // then提交后续任务
+    friend class TaskGraph;   // 依赖全部完成的节点由线程池调度
+    friend class ExecutorGroup; // 每个任务对应一个调度令牌放入任务队列，令牌中执行选中的任务
+    friend class ResultSet;     // 绑定观察者之后再放入任务队列
+    friend class TaskGroup;     // 子任务放入本地队列，队列满时直接执行
+    friend class Strand;        // 空闲的strand变为非空时提交排空任务，排空任务中依次执行排队的任务
+    friend class Pipeline;      // 读取输入和交给其他线程继续处理条目
+#if defined(FLEXIPOOL_COROUTINES)
+    friend class ScheduleAwaiter; // 协程的恢复任务直接放入任务队列
+#endif
+
+    /*
+    依赖已经全部完成的后续任务：由完成最后一个依赖的线程直接放入pool的任务队列，
+    任务队列满时在当前线程执行，不会阻塞工作线程；pool为空时直接在当前线程执行
+    */
+    static void scheduleContinuation(ThreadPool *pool, std::shared_ptr<Task> task);
+    // 附加取消令牌（可以为空）和截止时间（time_point::max()表示没有）提交
+    template <typename Func, typename... Args>
+    auto submitCancellable(const CancellationToken *token, std::chrono::steady_clock::time_point deadline, Func &&func, Args &&...args)
+        -> TypedResult<decltype(func(args...))>
+    {
+        using RType = decltype(func(args...));
+        using BindType = decltype(std::bind(std::forward<Func>(func), std::forward<Args>(args)...));
+        std::shared_ptr<FuncTask<RType, BindType>> task =
+            makeTask<FuncTask<RType, BindType>>(std::bind(std::forward<Func>(func), std::forward<Args>(args)...));
+        if (token != nullptr)
+            task->setCancellationToken(*token);
+        if (deadline != std::chrono::steady_clock::time_point::max())
+            task->setDeadline(deadline);
+        if (!enqueueTask(task, submitPolicy_))
+        {
+            task->setError(std::make_exception_ptr(std::runtime_error("task queue is full, submit task failed.")));
+        }
+        return TypedResult<RType>(task);
+    }
+    class PeriodicTask; // scheduleEvery的任务，每次执行完成前把下一次的新任务放入定时队列
+
     // 定义线程函数
     void threadHandler(size_t threadId);
+    // 把任务放入定时队列，when到期后放入任务队列，线程池已经关闭时返回false
+    bool scheduleTask(std::shared_ptr<Task> sp, std::chrono::steady_clock::time_point when);
+    // 定时线程：把一批到期的任务放入任务队列，放不进去的任务被丢弃
+    void fireTimers(std::vector<std::shared_ptr<Task>> &tasks);
+    // 线程池关闭之后的提交：POLICY_CALLER_RUNS在当前线程执行，其余失败
+    bool pushAfterShutdown(QueuedTask &slot, SubmitPolicy policy);
+    // 任务放入队列之后：所有线程都已经退出时，取消这个迟到的任务
+    void checkStranded();
+    // 取消所有排队的任务（以丢弃完成其结果），返回取消的数量
+    size_t cancelPending();
+    // 工作线程退出前把自己移到exitedThreads_并通知exitCond_（需要持有taskQueMtx_）
+    void retireThread(size_t threadId);
+    // join已经退出的线程
+    void joinExitedThreads();
+    // 把任务放入任务队列，按照policy处理队列已满的情况，提交失败返回false
+    bool enqueueTask(std::shared_ptr<Task> sp, SubmitPolicy policy, Priority priority = Priority::PRIORITY_NORMAL);
+    // 把post的可调用对象直接放入任务队列的槽位（使用默认的提交策略），提交失败返回false
+    bool enqueueFunc(UniqueFunction<void()> func);
+    // enqueueTask和enqueueFunc的共同部分：放入槽位并统计提交和拒绝的数量
+    bool enqueueSlot(QueuedTask slot, SubmitPolicy policy);
+    // enqueueSlot的实现，不做统计
+    bool pushTask(QueuedTask slot, SubmitPolicy policy);
+    // 把任务放入指定节点的任务队列，提交失败返回false
+    bool enqueueNodeTask(std::shared_ptr<Task> sp, size_t node);
+    // enqueueNodeTask的实现，不做统计
+    bool pushNodeTask(QueuedTask slot, size_t node);
+    // 从指定节点的任务队列取一个任务
+    bool popNodeTask(size_t node, QueuedTask &slot);
+    // 依次从其他节点的任务队列取一个任务
+    bool popRemoteNodeTask(size_t node, QueuedTask &slot);
+    // 普通模式的线程取任务：本节点队列、任务队列、其他节点队列
+    bool fetchTask(QueuedTask &slot);
+    // 第slot个工作线程所在的节点
+    size_t slotNode(size_t slot) const;
+    // 工作线程启动时按照绑定方式设置CPU亲和性，并记录自己所在的节点
+    void placeWorker(size_t slot);
+    // 执行一个任务，并记录排队时间、执行时间、忙碌/空闲时间
+    void runTask(Task &task);
+    // 执行从任务队列取出的槽位：Task交给runTask，post的可调用对象同样记录统计、归还并发名额
+    void runSlot(QueuedTask &slot);
+    // runTask和runSlot的共同部分，body(start)执行任务，任务被跳过时返回false
+    template <typename Body>
+    void runMeasured(const void *traceId, int64_t submitTime, Priority priority, bool holdsSlot, Body body);
+    // 在提交者线程中执行任务（POLICY_CALLER_RUNS）
+    void runInline(QueuedTask &slot);
+    // 丢弃一个排队的槽位：Task以“任务被丢弃”完成结果，post的可调用对象直接销毁
+    static void discardSlot(QueuedTask &slot);
+    // 任务进入线程池或者Strand、ExecutorGroup的队列：记录提交时间（now）、优先级和跟踪事件
+    void stampTask(Task &task, Priority priority, int64_t now);
+    // 执行Strand、ExecutorGroup从自己的队列取出的任务：和工作线程取出的任务一样检查取消和截止时间、记录统计和跟踪
+    void runDequeued(Task &task);
+    // 工作线程开始时注册自己的计数器
+    void registerWorkerStats(size_t threadId);
+    // 工作线程退出前把自己的计数器合并到已退出线程的统计中（需要持有taskQueMtx_，在从threads_删除之前调用）
+    void retireWorkerStats();
+    // 批量放入任务队列：一次临界区、一次唤醒，返回成功放入的任务数量（tasks的前缀）
+    size_t enqueueBatch(std::vector<std::shared_ptr<Task>> &tasks);
+    // enqueueBatch的实现，不做统计，没有放入的槽位保持不变
+    size_t pushBatch(std::vector<QueuedTask> &slots);
+    // 唤醒一个最近空闲的线程（没有挂起的线程时不加锁）
+    void notifyWorker();
+    // 从空闲栈顶开始唤醒最多n个挂起的线程
+    void wakeWorkers(size_t n);
+    // 优先唤醒指定节点最近空闲的线程，该节点没有挂起的线程时唤醒栈顶的线程
+    void wakeNodeWorker(size_t node);
+    // 工作线程空闲等待的状态：最近任务到达间隔的滑动平均，IDLE_ADAPTIVE据此决定自旋多久
+    struct IdleState
+    {
+        IdleState() : gapNs(0) {}
+        int64_t gapNs;
+    };
+    // 等待新任务：按照idleStrategy_自旋或者挂起，timeout为0表示一直等待，超时返回false
+    bool waitForTask(Parker &parker, IdleState &idle, std::chrono::milliseconds timeout);
+    // 自旋直到有任务或者线程池结束（返回true），到达until（纳秒）返回false；yield为true时每次检查后让出CPU
+    bool spinForTask(int64_t until, bool yield);
+    // 登记到空闲栈并挂起，超时返回false
+    bool parkForTask(Parker &parker, std::chrono::milliseconds timeout);
+    // 把线程从空闲栈中移除，返回false表示已经被提交者弹出
+    bool removeIdleWorker(Parker &parker);
+    // 环形缓冲区模式：无锁入队，队列已满时按照policy处理
+    bool enqueueRingTask(QueuedTask &slot, SubmitPolicy policy);
+    // 环形缓冲区模式：尝试入队一次，队列满返回false
+    bool tryPushRing(QueuedTask &slot);
+    // 环形缓冲区模式：阻塞等待队列有空余入队，超时返回false
+    bool waitRingSpace(QueuedTask &slot);
+    // 环形缓冲区模式：无锁出队
+    bool popRingTask(QueuedTask &slot);
+    // 从任务队列取一个任务，队列为空返回false
+    bool popQueTask(QueuedTask &slot);
+    // 按照有效优先级从多级队列（环形缓冲区模式下还有普通优先级的环形缓冲区）取一个任务，需要持有taskQueMtx_
+    bool popLevelTask(QueuedTask &slot);
+    // 是否有可以立即执行的任务（排除已经达到并发上限的优先级）
+    bool hasRunnableTask() const;
+    // 占用一个优先级的并发名额，已经达到上限返回false
+    bool tryAcquireSlot(size_t level);
+    // 归还一个优先级的并发名额，有排队的任务时唤醒一个线程
+    void releaseSlot(size_t level);
+    // cached模式：任务数量多于空闲线程时通知监督线程创建线程，调用时不能持有taskQueMtx_
+    void requestThreads();
+    // cached模式的监督线程：定期采样，按照弹性控制器的目标线程数提前创建线程、调整回收下限
+    void supervisorHandler();
+    // 创建并启动n个线程，只在taskQueMtx_中登记，线程的创建在锁外
+    void spawnThreads(size_t n);
+    // 工作窃取模式：池内线程提交任务时放入自己的本地队列
+    void pushLocalTask(QueuedTask slot);
+    // 工作窃取模式的线程函数，index为线程在workerQues_中的下标，创建好本地队列后对ready减一
+    void stealingHandler(size_t threadId, size_t index, CountDownLatch *ready);
+    // 工作窃取模式：依次从本地队列、本节点队列、注入队列、同节点线程、其他节点获取任务
+    bool takeTask(size_t index, QueuedTask &slot);
+    // 等待其他任务完成的工作线程执行一个排队的任务，没有可以执行的任务时返回false
+    bool helpOnce();
+    friend void waitCompletion(Completion &completion);
+    // 从victims中随机选择的线程开始，依次尝试窃取
+    bool stealFrom(const std::vector<size_t> &victims, size_t index, QueuedTask &slot);
     // 检查线程池的运行状态
     bool checkRunningState() const;
-    // std::vector<std::unique_ptr<Thread>> threads_; // 线程列表
-    std::unordered_map<size_t, std::unique_ptr<Thread>> threads_; // 线程列表
+    // 工作窃取模式下本地队列的元素，指向内存池中的槽位（Chase-Lev队列只能存放可以原子读写的指针）
+    using TaskDeque = WorkStealingQueue<QueuedTask *>;
+    // 一个NUMA节点的任务队列分片
+    struct NodeShard
+    {
+        std::mutex mtx;
+        std::deque<QueuedTask, PoolAllocator<QueuedTask>> que;
+    };
+    /*
+    成员按照访问方式分段，段之间隔开一个缓存行，互相之间不会伪共享：
+    - 配置：start之前设置，之后只读（isPoolRunning_和关闭标志只在启动、关闭时修改一次）
+    - 任务队列：每次提交和取任务都要修改
+    - 唤醒：提交者读取threadWaitSize_判断是否需要唤醒，只有线程挂起、被唤醒时修改
+    - 工作线程：线程数量和忙碌计数，忙碌计数按线程分散累加，每个任务前后只写自己的槽位
+    - 冷数据：线程列表、统计、监督线程、关闭、定时任务
+    */
+    PoolMode poolMode_;                                           // 当前线程池的工作模式
+    TaskQueMode taskQueMode_;                                     // 任务队列的实现方式
+    SubmitPolicy submitPolicy_;                                   // 任务队列满时默认的提交策略
+    std::chrono::milliseconds submitTimeout_;                     // POLICY_BLOCK策略下提交任务的最长等待时间
     size_t initThreadSize_;                                       // 初始的线程数量（无符号整形）
-    std::atomic_size_t curThreadSize_;                            // 记录当前线程池中线程的总数量
-    std::atomic_size_t threadIdelSize_;                           // 记录空闲线程数量
     size_t threadSizeThreshHold_;                                 // 线程数量上限阈值
-    std::queue<std::shared_ptr<Task>> taskQue_;                   // 任务队列（考虑到用户可能传入临时变量，生命周期不够长的变量）
-    std::atomic_size_t taskSize_;                                 // 任务的数量（无符号原子整形）
     size_t taskQueMaxThreshHold_;                                 // 任务队列数量的上限阈值
+    size_t levelCap_[PRIORITY_LEVELS];                            // 各优先级的并发上限
+    bool capsEnabled_;                                            // 是否设置了并发上限
+    std::chrono::milliseconds agingTime_;                         // 优先级老化时间
+    AffinityMode affinityMode_;                                   // 工作线程的CPU绑定方式
+    IdleStrategy idleStrategy_;                                   // 空闲线程等待新任务的方式
+    CpuTopology topology_;                                        // CPU拓扑，设置了CPU绑定时在start中检测
+    std::chrono::milliseconds threadIdleTimeout_;                 // cached模式下的线程空闲超时
+    std::chrono::milliseconds elasticInterval_;                   // cached模式下监督线程的采样周期
+    std::atomic_bool isPoolRunning_;                              // 表示当前线程池的启动状态
+    std::atomic_bool isShutdown_;                                 // 已经开始关闭，不再接受新任务
+    std::atomic_bool workersExited_;                              // 所有线程都已经退出，之后放入队列的任务由提交者取消
+    std::vector<std::unique_ptr<TaskDeque>> workerQues_;          // 工作窃取模式下每个线程的本地双端队列（taskQue_作为外部提交的注入队列）
+    std::vector<std::unique_ptr<NodeShard>> nodeShards_;          // 每个节点一个任务队列分片（没有设置CPU绑定时为空）
+    std::vector<size_t> workerNode_;                              // 工作窃取模式下每个线程所在的节点
+    std::vector<std::vector<size_t>> nodeWorkers_;                // 工作窃取模式下每个节点的线程下标，窃取时先找同节点的线程
+    std::unique_ptr<MpmcQueue<QueuedTask>> ringQue_;              // 环形缓冲区模式下的任务队列（代替taskQue_）
+    Tracer tracer_;                                               // 执行跟踪，记录时只读取开关
+    char pad0_[CACHE_LINE_SIZE];                                  // 配置和任务队列之间
     std::mutex taskQueMtx_;                                       // 保证任务队列的线程安全
     std::condition_variable notFull_;                             // 表示任务队列不满
-    std::condition_variable notEmpty_;                            // 表示任务队列不空
+    MultiLevelQueue<QueuedTask, PRIORITY_LEVELS, PoolAllocator<std::pair<QueuedTask, int64_t>>> taskQue_; // 按优先级分级的任务队列（考虑到用户可能传入临时变量，生命周期不够长的变量）
+    std::atomic_size_t taskSize_;                                 // 任务的数量（无符号原子整形）
+    std::atomic_size_t levelSize_[PRIORITY_LEVELS];               // 各优先级排队的任务数量（不包括工作窃取模式的本地队列）
+    std::atomic_size_t producerWaitSize_;                         // 阻塞等待队列空余的提交者数量，为0时出队不需要通知notFull_
+    std::atomic_size_t nodeTaskSize_;                             // 所有节点队列中的任务数量，为0时不需要检查节点队列
+    char pad1_[CACHE_LINE_SIZE];                                  // 任务队列和唤醒之间
+    std::atomic_size_t threadWaitSize_;                           // 空闲栈中挂起的线程数量，为0时提交任务不需要唤醒
+    std::mutex idleMtx_;                                          // 保护空闲栈
+    std::vector<Parker *> idleStack_;                             // 挂起线程的停车位，栈顶是最近空闲的线程
+    char pad2_[CACHE_LINE_SIZE];                                  // 唤醒和工作线程之间
+    StripedCounter busyThreads_;                                  // 正在执行任务的线程数量（工作线程各自累加自己的槽位，读取时求和）
+    std::atomic_size_t curThreadSize_;                            // 记录当前线程池中线程的总数量
+    std::atomic_size_t levelRunning_[PRIORITY_LEVELS];            // 各优先级正在执行的任务数量（只在设置了并发上限时统计）
+    std::atomic_size_t nextWorkerSlot_;                           // 普通模式下分配给新线程的序号，决定线程所在的节点和CPU
+    std::atomic_bool spawnRequested_;                             // 已经通知了监督线程还没有处理，避免每次提交都去通知
+    std::atomic_size_t keepThreads_;                              // 空闲线程退出的下限（弹性控制器的目标线程数）
+    char pad3_[CACHE_LINE_SIZE];                                  // 工作线程和冷数据之间
+    std::unordered_map<size_t, std::unique_ptr<Thread>> threads_; // 线程列表
     std::condition_variable exitCond_;                            // 等待线程资源全部回收
-    PoolMode poolMode_;                                           // 当前线程池的工作模式
-    std::atomic_bool isPoolRunning_;                              // 表示当前线程池的启动状态
+    StripedCounter submittedCount_;                               // 提交成功的任务数量（按提交线程分散累加）
+    StripedCounter rejectedCount_;                                // 提交失败的任务数量
+    StripedCounter droppedCount_;                                 // POLICY_DROP_OLDEST丢弃的任务数量
+    StripedCounter callerRunCount_;                               // 线程池之外的提交者线程直接执行完成的任务数量
+    std::atomic<uint64_t> threadsCreated_;                        // cached模式下动态创建的线程数量
+    std::atomic<uint64_t> threadsReaped_;                         // cached模式下回收的线程数量
+    std::mutex statsMtx_;                                         // 保护workerCounters_和已退出线程的统计
+    std::vector<std::unique_ptr<WorkerCounters>> workerCounters_; // 存活的工作线程的计数器
+    PoolStats retiredStats_;                                      // 已退出的工作线程的累计统计
+    std::thread supervisor_;                                      // cached模式的监督线程
+    std::mutex supervisorMtx_;                                    // 配合supervisorCond_使用
+    std::condition_variable supervisorCond_;                      // 唤醒监督线程：有积压任务或者线程池结束
+    std::vector<std::unique_ptr<Thread>> exitedThreads_;          // 已经退出、等待join的线程，由taskQueMtx_保护
+    std::mutex shutdownMtx_;                                      // 串行化shutdown的调用
+    std::atomic<uint64_t> cancelledCount_;                        // 没有执行就被取消的任务数量（关闭、取消令牌、截止时间）
+    TimerQueue timers_;                                           // 定时任务队列，第一次定时提交时启动定时线程
+};
+
+template <typename R>
+template <typename F>
+TypedResult<typename ThenCall<R, F>::result_type> TypedResult<R>::then(F func)
+{
+    using RType = typename ThenCall<R, F>::result_type;
+    std::shared_ptr<TypedState<R>> prev = std::move(state_);
+    ThreadPool *pool = prev->pool();
+    std::shared_ptr<FuncTask<RType, ThenCall<R, F>>> next =
+        makeTask<FuncTask<RType, ThenCall<R, F>>>(ThenCall<R, F>(prev, std::move(func)));
+    // 回调和后续任务互相引用，前一个任务完成、回调执行完被释放后引用解除
+    std::shared_ptr<Task> task = next;
+    prev->onReady([pool, task]()
+                  { ThreadPool::scheduleContinuation(pool, task); });
+    return TypedResult<RType>(next);
+}
+
+// whenAll的汇合状态：所有依赖都完成时完成，不需要执行
+class WhenAllState : public TypedState<void>
+{
+public:
+    WhenAllState(size_t count, ThreadPool *pool) : remaining_(count)
+    {
+        setPool(pool);
+    }
+    // 一个依赖完成
+    void arrive()
+    {
+        if (remaining_.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        {
+            setReady();
+        }
+    }
+    Any run()
+    {
+        return Any();
+    }
+
+private:
+    std::atomic_size_t remaining_;
 };
+
+// whenAny的汇合状态：第一个完成的依赖写入自己的下标
+class WhenAnyState : public TypedState<size_t>
+{
+public:
+    explicit WhenAnyState(ThreadPool *pool) : done_(false)
+    {
+        setPool(pool);
+    }
+    void arrive(size_t index)
+    {
+        if (!done_.exchange(true, std::memory_order_acq_rel))
+        {
+            invoke(index);
+        }
+    }
+    Any run()
+    {
+        return Any();
+    }
+
+private:
+    // invoke需要可调用对象
+    void invoke(size_t index)
+    {
+        struct Index
+        {
+            size_t value;
+            size_t operator()() const
+            {
+                return value;
+            }
+        } func{index};
+        TypedState<size_t>::invoke(func);
+    }
+    std::atomic_bool done_;
+};
+
+// 依赖的线程池：取第一个已经提交的依赖
+inline ThreadPool *firstPool()
+{
+    return nullptr;
+}
+template <typename R, typename... Rs>
+ThreadPool *firstPool(const TypedResult<R> &result, const TypedResult<Rs> &...rest)
+{
+    return result.pool() != nullptr ? result.pool() : firstPool(rest...);
+}
+
+inline void registerWhenAll(const std::shared_ptr<WhenAllState> &)
+{
+}
+template <typename R, typename... Rs>
+void registerWhenAll(const std::shared_ptr<WhenAllState> &state, const TypedResult<R> &result, const TypedResult<Rs> &...rest)
+{
+    result.onReady([state]()
+                   { state->arrive(); });
+    registerWhenAll(state, rest...);
+}
+
+inline void registerWhenAny(const std::shared_ptr<WhenAnyState> &, size_t)
+{
+}
+template <typename R, typename... Rs>
+void registerWhenAny(const std::shared_ptr<WhenAnyState> &state, size_t index, const TypedResult<R> &result, const TypedResult<Rs> &...rest)
+{
+    result.onReady([state, index]()
+                   { state->arrive(index); });
+    registerWhenAny(state, index + 1, rest...);
+}
+
+/*
+所有结果都完成（包括失败）时完成，不等待、不取走返回值，之后可以对每个结果调用get()
+example:
+TypedResult<int> a = pool.submit(f), b = pool.submit(g);
+whenAll(a, b).then([&]() { return a.get() + b.get(); });
+*/
+template <typename... Rs>
+TypedResult<void> whenAll(const TypedResult<Rs> &...results)
+{
+    // 多计一次，全部注册完再减掉，注册过程中不会提前完成
+    std::shared_ptr<WhenAllState> state = makeTask<WhenAllState>(sizeof...(Rs) + 1, firstPool(results...));
+    registerWhenAll(state, results...);
+    state->arrive();
+    return TypedResult<void>(state);
+}
+
+template <typename R>
+TypedResult<void> whenAll(const std::vector<TypedResult<R>> &results)
+{
+    ThreadPool *pool = results.empty() ? nullptr : results.front().pool();
+    std::shared_ptr<WhenAllState> state = makeTask<WhenAllState>(results.size() + 1, pool);
+    for (const TypedResult<R> &result : results)
+    {
+        result.onReady([state]()
+                       { state->arrive(); });
+    }
+    state->arrive();
+    return TypedResult<void>(state);
+}
+
+// 任意一个结果完成时完成，返回值为该结果的下标
+template <typename... Rs>
+TypedResult<size_t> whenAny(const TypedResult<Rs> &...results)
+{
+    static_assert(sizeof...(Rs) > 0, "whenAny() needs at least one result");
+    std::shared_ptr<WhenAnyState> state = makeTask<WhenAnyState>(firstPool(results...));
+    registerWhenAny(state, 0, results...);
+    return TypedResult<size_t>(state);
+}
+
+// results为空时没有结果能够完成，抛出std::invalid_argument
+template <typename R>
+TypedResult<size_t> whenAny(const std::vector<TypedResult<R>> &results)
+{
+    if (results.empty())
+    {
+        throw std::invalid_argument("whenAny() needs at least one result.");
+    }
+    std::shared_ptr<WhenAnyState> state = makeTask<WhenAnyState>(results.front().pool());
+    for (size_t i = 0; i < results.size(); i++)
+    {
+        results[i].onReady([state, i]()
+                           { state->arrive(i); });
+    }
+    return TypedResult<size_t>(state);
+}
 #endif
\ No newline at end of file
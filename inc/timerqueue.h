@@ -0,0 +1,66 @@
+#ifndef TIMERQUEUE_H
+#define TIMERQUEUE_H
+#include <vector>
+#include <queue>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <thread>
+#include <cstdint>
+#include "steadyclock.h"
+#include "flexipoolexport.h"
+
+class Task;
+
+/*
+定时任务队列：按照到期时间排序的最小堆，由一个定时线程服务
+- 定时线程在第一次添加定时任务时启动，没有定时任务的线程池不会多一个线程
+- 同一时刻到期的任务一次取出，整批交给fire（放入线程池的任务队列），定时线程不执行任务
+- 到期时间相同的任务按照添加的顺序取出
+*/
+class FLEXIPOOL_API TimerQueue
+{
+public:
+    // 处理一批到期的任务，在定时线程中调用，调用时不持有锁
+    using FireFunc = std::function<void(std::vector<std::shared_ptr<Task>> &)>;
+
+    explicit TimerQueue(FireFunc fire);
+    ~TimerQueue();
+    TimerQueue(const TimerQueue &) = delete;
+    TimerQueue &operator=(const TimerQueue &) = delete;
+
+    // 添加一个定时任务，due为到期时间（steady_clock纳秒），已经停止时返回false
+    bool add(int64_t due, std::shared_ptr<Task> task);
+    // 停止定时线程，返回还没有到期的任务；之后的add都失败
+    std::vector<std::shared_ptr<Task>> stop();
+    // 还没有到期的任务数量
+    size_t size();
+
+private:
+    struct Entry
+    {
+        int64_t due;
+        uint64_t seq; // 到期时间相同时按照添加顺序
+        std::shared_ptr<Task> task;
+    };
+    struct Later
+    {
+        bool operator()(const Entry &a, const Entry &b) const
+        {
+            return a.due > b.due || (a.due == b.due && a.seq > b.seq);
+        }
+    };
+
+    // 定时线程：等到堆顶到期，取出所有到期的任务交给fire
+    void loop();
+
+    FireFunc fire_;
+    std::mutex mtx_;
+    std::condition_variable cond_; // 有更早到期的任务或者停止时唤醒定时线程
+    std::priority_queue<Entry, std::vector<Entry>, Later> heap_;
+    uint64_t nextSeq_;
+    bool stopped_;
+    std::thread thread_;
+};
+#endif
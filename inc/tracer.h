@@ -0,0 +1,99 @@
+#ifndef TRACER_H
+#define TRACER_H
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <thread>
+#include <chrono>
+#include <cstdint>
+#include <cstddef>
+#include "steadyclock.h"
+#include "flexipoolexport.h"
+
+const size_t TRACE_BUFFER_EVENTS = 8192; // 每个线程默认保留的最近事件数量
+const size_t TRACE_THREAD_BINDINGS = 4;  // 每个线程缓存的Tracer绑定数量（嵌套线程池、ExecutorGroup和它的线程池各占一个）
+
+// 跟踪记录的事件
+enum class TraceEvent : uint8_t
+{
+    TRACE_SUBMIT,         // 任务放入队列（提交者线程）
+    TRACE_DEQUEUE,        // 任务从队列中取出（POLICY_CALLER_RUNS在提交者线程中直接执行时也会记录）
+    TRACE_START,          // 开始执行
+    TRACE_END,            // 执行结束
+    TRACE_STEAL,          // 从其他线程的本地队列窃取，arg为被窃取的线程下标
+    TRACE_SUBMIT_BLOCKED, // 队列已满，提交者开始在notFull_上等待
+    TRACE_SUBMIT_RESUMED, // 提交者结束等待（有空余或者超时）
+    TRACE_PARK,           // 空闲线程挂起
+    TRACE_UNPARK,         // 空闲线程被唤醒或者等待超时
+    TRACE_THREAD_SPAWN,   // 创建工作线程，arg为线程id
+    TRACE_THREAD_REAP,    // 空闲线程退出，arg为线程id
+};
+
+/*
+线程池的执行跟踪：记录任务从提交到执行结束的各个事件，导出为Chrome trace JSON
+- 每个线程写自己的环形缓冲区（单写者，无锁），只保留最近的若干个事件，旧的事件被覆盖
+- 线程缓存最近TRACE_THREAD_BINDINGS个Tracer中自己的缓冲区，同时记录到几个线程池的跟踪不会每次加锁查找
+- 记录一个事件：一次relaxed读检查开关、一次取时间、写一个32字节的槽位，没有原子的读-改-写
+- 导出时按槽位的序号校验，正在被覆盖的槽位直接跳过，导出不会阻塞写入的线程
+- 导出的JSON可以用chrome://tracing或者Perfetto UI（ui.perfetto.dev）直接打开
+*/
+class FLEXIPOOL_API Tracer
+{
+public:
+    Tracer();
+    ~Tracer();
+    Tracer(const Tracer &) = delete;
+    Tracer &operator=(const Tracer &) = delete;
+
+    // 开始记录，之后创建的缓冲区保留eventsPerThread个事件（向上取整为2的幂），已经创建的缓冲区保持原来的大小
+    void enable(size_t eventsPerThread = TRACE_BUFFER_EVENTS);
+    // 停止记录，已经记录的事件保留到导出
+    void disable();
+    bool enabled() const
+    {
+        return enabled_.load(std::memory_order_relaxed);
+    }
+
+    // 记录一个事件，id用来关联同一个任务的事件（任务的地址），tsNs为steady_clock的纳秒时间
+    void record(TraceEvent event, const void *id, uint32_t arg = 0)
+    {
+        if (enabled())
+            append(event, id, arg, steadyNowNs());
+    }
+    void record(TraceEvent event, const void *id, uint32_t arg, int64_t tsNs)
+    {
+        if (enabled())
+            append(event, id, arg, tsNs);
+    }
+
+    // 当前线程在导出结果中的名字（线程开始时设置一次）
+    static void setThreadName(const std::string &name);
+    // 当前线程不会再记录事件（线程退出前调用），缓冲区留给之后创建的线程，已经记录的事件保留
+    void releaseThread();
+
+    // 导出为Chrome trace JSON（{"traceEvents":[...]}），时间相对于第一次开启跟踪
+    std::string toChromeTrace() const;
+    // 导出到文件，失败返回false
+    bool dump(const std::string &path) const;
+
+private:
+    class Buffer;
+
+    // 写入当前线程的缓冲区，第一次记录时绑定一个缓冲区
+    void append(TraceEvent event, const void *id, uint32_t arg, int64_t tsNs);
+    Buffer *bind();
+
+    std::atomic_bool enabled_;
+    const uint64_t serial_;                           // 区分不同的Tracer，线程缓存的绑定不会指向已经析构的Tracer
+    int64_t originNs_;                                // 第一次开启跟踪的时间，导出时间的零点
+    size_t capacity_;                                 // 新建缓冲区的容量
+    mutable std::mutex mtx_;                          // 保护下面的成员，只在绑定、释放和导出时使用
+    std::vector<std::unique_ptr<Buffer>> buffers_;    // 所有创建过的缓冲区
+    std::unordered_map<std::thread::id, Buffer *> bound_; // 已经绑定缓冲区的线程
+    std::vector<Buffer *> free_;                      // 已经退出的线程留下的缓冲区
+    std::vector<std::string> names_;                  // 线程编号对应的名字
+};
+#endif
@@ -0,0 +1,144 @@
+#ifndef UNIQUEFUNCTION_H
+#define UNIQUEFUNCTION_H
+#include <cstddef>
+#include <new>
+#include <utility>
+#include <type_traits>
+#include <functional>
+
+// 小对象优化：不超过FUNCTION_INLINE_SIZE字节、可以无异常移动的可调用对象直接存放在对象内部
+// 固定字节数而不是指针个数：32位平台上同样能放下捕获了几个std::string或者std::shared_ptr的lambda
+const size_t FUNCTION_INLINE_SIZE = 48;
+
+template <typename Signature>
+class UniqueFunction;
+
+/*
+只能移动的类型擦除可调用对象，代替std::function保存回调和任务图的节点
+- 可以保存只能移动的可调用对象（例如捕获了std::unique_ptr的lambda），std::function要求可以拷贝
+- 小的可调用对象（捕获几个指针的lambda）不分配堆内存，移动时也不分配
+example:
+std::unique_ptr<Buffer> buf(new Buffer());
+UniqueFunction<void()> f = [buf = std::move(buf)]() { flush(*buf); }; // C++14的初始化捕获
+f();
+*/
+template <typename R, typename... Args>
+class UniqueFunction<R(Args...)>
+{
+public:
+    UniqueFunction() : base_(nullptr) {}
+    UniqueFunction(std::nullptr_t) : base_(nullptr) {}
+    template <typename F, typename = typename std::enable_if<!std::is_same<typename std::decay<F>::type, UniqueFunction>::value>::type>
+    UniqueFunction(F &&func) : base_(nullptr)
+    {
+        using FuncType = typename std::decay<F>::type;
+        construct<FuncType>(std::forward<F>(func), std::integral_constant<bool, Derive<FuncType>::isInline>());
+    }
+    ~UniqueFunction()
+    {
+        reset();
+    }
+    UniqueFunction(const UniqueFunction &) = delete;
+    UniqueFunction &operator=(const UniqueFunction &) = delete;
+    UniqueFunction(UniqueFunction &&other) noexcept : base_(nullptr)
+    {
+        moveFrom(other);
+    }
+    UniqueFunction &operator=(UniqueFunction &&other) noexcept
+    {
+        if (this != &other)
+        {
+            reset();
+            moveFrom(other);
+        }
+        return *this;
+    }
+
+    // 是否保存了可调用对象
+    explicit operator bool() const
+    {
+        return base_ != nullptr;
+    }
+    // 调用保存的可调用对象，为空时抛出std::bad_function_call
+    R operator()(Args... args)
+    {
+        if (base_ == nullptr)
+            throw std::bad_function_call();
+        return base_->call(std::forward<Args>(args)...);
+    }
+
+private:
+    class Base
+    {
+    public:
+        virtual ~Base() = default;
+        virtual R call(Args &&...args) = 0;
+        // 把自己移动构造到另一个UniqueFunction的内部缓冲区
+        virtual Base *moveTo(void *buffer) noexcept = 0;
+        virtual bool isInlineStored() const = 0;
+    };
+    template <typename F>
+    class Derive : public Base
+    {
+    public:
+        static const bool isInline = sizeof(F) <= FUNCTION_INLINE_SIZE && alignof(F) <= alignof(void *) &&
+                                     std::is_nothrow_move_constructible<F>::value;
+        template <typename T>
+        explicit Derive(T &&func) : func_(std::forward<T>(func)) {}
+        R call(Args &&...args)
+        {
+            return func_(std::forward<Args>(args)...);
+        }
+        Base *moveTo(void *buffer) noexcept
+        {
+            return new (buffer) Derive<F>(std::move(func_));
+        }
+        bool isInlineStored() const
+        {
+            return isInline;
+        }
+        F func_;
+    };
+
+    // 小对象直接构造在内部缓冲区
+    template <typename FuncType, typename F>
+    void construct(F &&func, std::true_type)
+    {
+        base_ = new (&buffer_) Derive<FuncType>(std::forward<F>(func));
+    }
+    template <typename FuncType, typename F>
+    void construct(F &&func, std::false_type)
+    {
+        base_ = new Derive<FuncType>(std::forward<F>(func));
+    }
+    void reset()
+    {
+        if (base_ == nullptr)
+            return;
+        if (base_->isInlineStored())
+            base_->~Base();
+        else
+            delete base_;
+        base_ = nullptr;
+    }
+    void moveFrom(UniqueFunction &other)
+    {
+        if (other.base_ == nullptr)
+            return;
+        if (other.base_->isInlineStored())
+        {
+            base_ = other.base_->moveTo(&buffer_);
+            other.reset();
+        }
+        else
+        {
+            base_ = other.base_;
+            other.base_ = nullptr;
+        }
+    }
+
+    Base *base_; // 指向buffer_或者堆上的对象
+    // 内部缓冲区：Derive对象包含虚表指针，所以多留一个指针的空间
+    typename std::aligned_storage<FUNCTION_INLINE_SIZE + sizeof(void *), alignof(void *)>::type buffer_;
+};
+#endif
@@ -0,0 +1,166 @@
+#ifndef WORKSTEALINGQUEUE_H
+#define WORKSTEALINGQUEUE_H
+#include <atomic>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+/*
+Chase-Lev 无锁工作窃取双端队列（参考 Lê et al. 2013 弱内存模型版本）
+- push/pop 只能由队列的拥有者线程调用，操作底部（LIFO，缓存友好）
+- steal 可以由任意线程调用，从顶部窃取（FIFO，先窃取最老的任务）
+- T 必须是可以原子读写的平凡类型，一般存放指针
+*/
+template <typename T>
+class WorkStealingQueue
+{
+public:
+    explicit WorkStealingQueue(int64_t capacity = 256)
+        : top_(0), bottom_(0), array_(new Array(roundUp(capacity)))
+    {
+    }
+    ~WorkStealingQueue()
+    {
+        for (Array *a : garbage_)
+        {
+            delete a;
+        }
+        delete array_.load(std::memory_order_relaxed);
+    }
+    WorkStealingQueue(const WorkStealingQueue &) = delete;
+    WorkStealingQueue &operator=(const WorkStealingQueue &) = delete;
+
+    // 拥有者线程：在底部压入一个元素，空间不足时扩容
+    void push(T item)
+    {
+        int64_t b = bottom_.load(std::memory_order_relaxed);
+        int64_t t = top_.load(std::memory_order_acquire);
+        Array *a = array_.load(std::memory_order_relaxed);
+        if (b - t > a->capacity() - 1)
+        {
+            a = resize(a, b, t);
+        }
+        a->put(b, item);
+        // release保证窃取者看到新的bottom时也能看到写入的元素
+        bottom_.store(b + 1, std::memory_order_release);
+    }
+
+    // 拥有者线程：从底部弹出一个元素，队列为空返回false
+    bool pop(T &item)
+    {
+        int64_t b = bottom_.load(std::memory_order_relaxed) - 1;
+        Array *a = array_.load(std::memory_order_relaxed);
+        bottom_.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t t = top_.load(std::memory_order_relaxed);
+        if (t > b)
+        {
+            // 队列为空，恢复bottom
+            bottom_.store(b + 1, std::memory_order_relaxed);
+            return false;
+        }
+        item = a->get(b);
+        if (t == b)
+        {
+            // 只剩最后一个元素，和窃取者竞争
+            bool won = top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+            bottom_.store(b + 1, std::memory_order_relaxed);
+            return won;
+        }
+        return true;
+    }
+
+    // 任意线程：从顶部窃取一个元素，队列为空或竞争失败返回false
+    bool steal(T &item)
+    {
+        int64_t t = top_.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t b = bottom_.load(std::memory_order_acquire);
+        if (t >= b)
+        {
+            return false;
+        }
+        Array *a = array_.load(std::memory_order_acquire);
+        T x = a->get(t);
+        if (!top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+        {
+            return false;
+        }
+        item = x;
+        return true;
+    }
+
+    // 近似的元素个数（并发下仅供参考）
+    size_t size() const
+    {
+        int64_t b = bottom_.load(std::memory_order_relaxed);
+        int64_t t = top_.load(std::memory_order_relaxed);
+        return b > t ? static_cast<size_t>(b - t) : 0;
+    }
+
+    bool empty() const
+    {
+        return size() == 0;
+    }
+
+private:
+    // 环形数组，容量为2的幂
+    class Array
+    {
+    public:
+        explicit Array(int64_t capacity)
+            : capacity_(capacity), mask_(capacity - 1), buffer_(new std::atomic<T>[capacity])
+        {
+        }
+        ~Array()
+        {
+            delete[] buffer_;
+        }
+        int64_t capacity() const
+        {
+            return capacity_;
+        }
+        void put(int64_t i, T item)
+        {
+            buffer_[i & mask_].store(item, std::memory_order_relaxed);
+        }
+        T get(int64_t i) const
+        {
+            return buffer_[i & mask_].load(std::memory_order_relaxed);
+        }
+
+    private:
+        int64_t capacity_;
+        int64_t mask_;
+        std::atomic<T> *buffer_;
+    };
+
+    static int64_t roundUp(int64_t n)
+    {
+        int64_t cap = 1;
+        while (cap < n)
+        {
+            cap <<= 1;
+        }
+        return cap;
+    }
+
+    // 扩容为原来的两倍，旧数组可能仍被窃取者读取，延迟到析构时再释放
+    Array *resize(Array *a, int64_t b, int64_t t)
+    {
+        Array *na = new Array(a->capacity() * 2);
+        for (int64_t i = t; i < b; i++)
+        {
+            na->put(i, a->get(i));
+        }
+        garbage_.push_back(a);
+        array_.store(na, std::memory_order_release);
+        return na;
+    }
+
+    std::atomic<int64_t> top_;    // 窃取端
+    std::atomic<int64_t> bottom_; // 拥有者端
+    std::atomic<Array *> array_;  // 当前使用的环形数组
+    std::vector<Array *> garbage_; // 扩容后被替换下来的旧数组，只由拥有者线程访问
+};
+#endif
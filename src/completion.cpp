@@ -0,0 +1,60 @@
+#include "completion.h"
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <climits>
+#else
+#include <mutex>
+#include <condition_variable>
+#endif
+
+static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "futex word must be a plain 32-bit integer");
+
+#if defined(__linux__)
+void Completion::waitWhile(std::atomic<uint32_t> *word, uint32_t value)
+{
+    // 状态已经改变时内核立即返回；被信号打断或者虚假唤醒由调用者重新检查
+    syscall(SYS_futex, reinterpret_cast<uint32_t *>(word), FUTEX_WAIT_PRIVATE, value, nullptr, nullptr, 0);
+}
+
+void Completion::wakeAll(std::atomic<uint32_t> *word)
+{
+    syscall(SYS_futex, reinterpret_cast<uint32_t *>(word), FUTEX_WAKE_PRIVATE, INT_MAX, nullptr, nullptr, 0);
+}
+#else
+// 地址散列到的等待桶，不同的完成事件共享，挂起的线程很少时冲突的代价只是多一次虚假唤醒
+const size_t COMPLETION_WAIT_BUCKETS = 64;
+
+struct CompletionBucket
+{
+    std::mutex mtx;
+    std::condition_variable cond;
+};
+
+static CompletionBucket &bucketOf(const void *addr)
+{
+    static CompletionBucket buckets[COMPLETION_WAIT_BUCKETS];
+    return buckets[(reinterpret_cast<uintptr_t>(addr) >> 4) % COMPLETION_WAIT_BUCKETS];
+}
+
+void Completion::waitWhile(std::atomic<uint32_t> *word, uint32_t value)
+{
+    CompletionBucket &bucket = bucketOf(word);
+    std::unique_lock<std::mutex> lock(bucket.mtx);
+    while (word->load(std::memory_order_acquire) == value)
+    {
+        bucket.cond.wait(lock);
+    }
+}
+
+void Completion::wakeAll(std::atomic<uint32_t> *word)
+{
+    CompletionBucket &bucket = bucketOf(word);
+    {
+        // 状态已经改变，加锁保证检查完状态的等待者已经进入wait，通知不会丢失
+        std::lock_guard<std::mutex> lock(bucket.mtx);
+    }
+    bucket.cond.notify_all();
+}
+#endif
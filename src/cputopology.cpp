@@ -0,0 +1,140 @@
+#include "cputopology.h"
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <thread>
+#include <cstdlib>
+#if defined(__linux__)
+#include <sched.h>
+#include <dirent.h>
+#include <pthread.h>
+#endif
+
+CpuTopology::CpuTopology(std::vector<std::vector<int>> nodes)
+{
+    for (auto &cpus : nodes)
+    {
+        if (!cpus.empty())
+        {
+            nodes_.emplace_back(std::move(cpus));
+        }
+    }
+}
+
+size_t CpuTopology::cpuCount() const
+{
+    size_t n = 0;
+    for (auto &cpus : nodes_)
+    {
+        n += cpus.size();
+    }
+    return n;
+}
+
+std::vector<int> CpuTopology::parseCpuList(const std::string &list)
+{
+    std::vector<int> cpus;
+    std::stringstream ss(list);
+    std::string range;
+    while (std::getline(ss, range, ','))
+    {
+        if (range.empty() || range[0] < '0' || range[0] > '9')
+            continue;
+        size_t dash = range.find('-');
+        int first = std::atoi(range.c_str());
+        int last = dash == std::string::npos ? first : std::atoi(range.c_str() + dash + 1);
+        for (int cpu = first; cpu <= last; cpu++)
+        {
+            cpus.push_back(cpu);
+        }
+    }
+    return cpus;
+}
+
+#if defined(__linux__)
+// 当前进程允许使用的CPU
+static std::vector<int> allowedCpus()
+{
+    std::vector<int> cpus;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) == 0)
+    {
+        for (int cpu = 0; cpu < CPU_SETSIZE; cpu++)
+        {
+            if (CPU_ISSET(cpu, &set))
+                cpus.push_back(cpu);
+        }
+    }
+    return cpus;
+}
+
+CpuTopology CpuTopology::detect()
+{
+    std::vector<int> allowed = allowedCpus();
+    // 节点编号可能不连续，按编号排序
+    std::vector<std::pair<int, std::vector<int>>> found;
+    DIR *dir = opendir("/sys/devices/system/node");
+    if (dir != nullptr)
+    {
+        while (dirent *entry = readdir(dir))
+        {
+            std::string name = entry->d_name;
+            if (name.compare(0, 4, "node") != 0 || name.size() == 4 || name[4] < '0' || name[4] > '9')
+                continue;
+            std::ifstream file("/sys/devices/system/node/" + name + "/cpulist");
+            std::string list;
+            if (!std::getline(file, list))
+                continue;
+            std::vector<int> cpus;
+            for (int cpu : parseCpuList(list))
+            {
+                if (std::find(allowed.begin(), allowed.end(), cpu) != allowed.end())
+                    cpus.push_back(cpu);
+            }
+            found.emplace_back(std::atoi(name.c_str() + 4), std::move(cpus));
+        }
+        closedir(dir);
+    }
+    std::sort(found.begin(), found.end());
+    std::vector<std::vector<int>> nodes;
+    for (auto &node : found)
+    {
+        nodes.emplace_back(std::move(node.second));
+    }
+    CpuTopology topology(std::move(nodes));
+    if (topology.nodeCount() == 0)
+    {
+        // 没有NUMA信息（容器、未开启NUMA的内核）：所有允许的CPU属于一个节点
+        topology = CpuTopology(std::vector<std::vector<int>>(1, allowed));
+    }
+    return topology;
+}
+
+bool CpuTopology::pinCurrentThread(const std::vector<int> &cpus)
+{
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu : cpus)
+    {
+        if (cpu >= 0 && cpu < CPU_SETSIZE)
+            CPU_SET(cpu, &set);
+    }
+    return CPU_COUNT(&set) > 0 && pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+}
+#else
+CpuTopology CpuTopology::detect()
+{
+    std::vector<int> cpus;
+    for (unsigned i = 0; i < std::max(1u, std::thread::hardware_concurrency()); i++)
+    {
+        cpus.push_back(static_cast<int>(i));
+    }
+    return CpuTopology(std::vector<std::vector<int>>(1, cpus));
+}
+
+bool CpuTopology::pinCurrentThread(const std::vector<int> &)
+{
+    return false;
+}
+#endif
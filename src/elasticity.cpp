@@ -0,0 +1,70 @@
+#include "elasticity.h"
+#include <algorithm>
+#include <cmath>
+
+static const double EWMA_ALPHA = 0.3;             // 新采样的权重
+static const double DEMAND_HEADROOM = 1.25;       // 按照Little定律计算的线程数之外的余量
+static const double QUEUE_WAIT_TARGET_NS = 1e6;   // 排队时间超过1ms认为线程不够
+
+static double ewma(double old, double sample)
+{
+    return EWMA_ALPHA * sample + (1 - EWMA_ALPHA) * old;
+}
+
+ElasticController::ElasticController(size_t minThreads, size_t maxThreads, std::chrono::milliseconds idleTimeout)
+    : minThreads_(minThreads), maxThreads_(std::max(minThreads, maxThreads)),
+      idleTimeoutSec_(std::chrono::duration<double>(idleTimeout).count()), target_(minThreads),
+      sampled_(false), arrivalEwma_(0), waitEwma_(0), serviceEwma_(0), belowSec_(0)
+{
+}
+
+size_t ElasticController::update(const ElasticSample &sample)
+{
+    if (sample.intervalSec <= 0)
+        return target_;
+    double rate = sample.arrived / sample.intervalSec;
+    double wait = sample.waitCount > 0 ? static_cast<double>(sample.waitSumNs) / sample.waitCount : 0;
+    if (!sampled_)
+    {
+        arrivalEwma_ = rate;
+        waitEwma_ = wait;
+        sampled_ = true;
+    }
+    else
+    {
+        arrivalEwma_ = ewma(arrivalEwma_, rate);
+        // 没有任务开始执行时不更新排队时间，队列积压由queued体现
+        if (sample.waitCount > 0)
+            waitEwma_ = ewma(waitEwma_, wait);
+    }
+    if (sample.execCount > 0)
+    {
+        double service = static_cast<double>(sample.execSumNs) / sample.execCount;
+        serviceEwma_ = serviceEwma_ == 0 ? service : ewma(serviceEwma_, service);
+    }
+
+    // 平均忙碌的线程数 = 到达率 × 平均执行时间
+    double busy = arrivalEwma_ * serviceEwma_ / 1e9;
+    size_t need = static_cast<size_t>(std::ceil(busy * DEMAND_HEADROOM));
+    if (sample.queued > sample.idle)
+        need += sample.queued - sample.idle;
+    if (waitEwma_ > QUEUE_WAIT_TARGET_NS && sample.queued > 0)
+        need = std::max(need, sample.threads + 1);
+    need = std::min(std::max(need, minThreads_), maxThreads_);
+
+    if (need >= target_)
+    {
+        target_ = need;
+        belowSec_ = 0;
+    }
+    else
+    {
+        belowSec_ += sample.intervalSec;
+        if (belowSec_ >= idleTimeoutSec_)
+        {
+            target_ -= (target_ - need + 1) / 2;
+            belowSec_ = 0;
+        }
+    }
+    return target_;
+}
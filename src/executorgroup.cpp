@@ -0,0 +1,203 @@
+#include "executorgroup.h"
+#include <limits>
+
+static const uint64_t STRIDE_ONE = 1ull << 20; // 权重为1的执行器每执行一个任务虚拟时间前进的步长
+
+// 调度令牌：不属于任何执行器，被执行时才由组选出要运行的任务
+class ExecutorGroup::DispatchTask : public Task
+{
+public:
+    explicit DispatchTask(ExecutorGroup *group) : group_(group) {}
+    Any run()
+    {
+        group_->runNext();
+        return Any();
+    }
+
+protected:
+    // 组关闭时令牌被取消：丢弃一个排队的任务，让等待它的用户不会永久阻塞
+    void onDiscard()
+    {
+        group_->discardNext();
+    }
+
+private:
+    ExecutorGroup *group_;
+};
+
+///////////////////////////////////// Executor方法的实现
+Executor::Executor(ExecutorGroup &group, std::string name, size_t weight, Priority priority)
+    : group_(group), name_(std::move(name)), weight_(std::max<size_t>(weight, 1)), priority_(priority),
+      stride_(STRIDE_ONE / weight_), maxQueued_(TASK_MAX_THRESHOLD), pass_(0), completed_(0)
+{
+}
+
+Result Executor::submitTask(std::shared_ptr<Task> sp)
+{
+    Result result(sp);
+    if (!enqueue(sp))
+    {
+        result.isValid_ = false; // 提交失败，get()不会阻塞
+    }
+    return result;
+}
+
+bool Executor::enqueue(std::shared_ptr<Task> sp)
+{
+    return group_.enqueue(*this, std::move(sp));
+}
+
+void Executor::setTaskQueMaxThreshHold(size_t threshhold)
+{
+    std::lock_guard<std::mutex> lock(group_.mtx_);
+    maxQueued_ = threshhold;
+}
+
+size_t Executor::pending() const
+{
+    std::lock_guard<std::mutex> lock(group_.mtx_);
+    return queue_.size();
+}
+
+///////////////////////////////////// ExecutorGroup方法的实现
+ExecutorGroup::ExecutorGroup(size_t threads)
+{
+    std::fill(std::begin(virtualTime_), std::end(virtualTime_), 0);
+    pool_.setPoolMode(PoolMode::MODE_FIXED);
+    // 每个排队的任务对应一个令牌，令牌的数量已经由各个执行器的上限限制，线程池的队列不再设上限
+    pool_.setTaskQueMaxThreshHold(std::numeric_limits<size_t>::max());
+    pool_.start(threads);
+}
+
+ExecutorGroup::~ExecutorGroup()
+{
+    // 先回收线程，令牌执行时还要访问执行器
+    pool_.shutdown();
+}
+
+Executor &ExecutorGroup::createExecutor(const std::string &name, size_t weight, Priority priority)
+{
+    std::lock_guard<std::mutex> lock(mtx_);
+    executors_.emplace_back(new Executor(*this, name, weight, priority));
+    executors_.back()->pass_ = virtualTime_[static_cast<size_t>(priority)];
+    return *executors_.back();
+}
+
+Executor *ExecutorGroup::executor(const std::string &name)
+{
+    std::lock_guard<std::mutex> lock(mtx_);
+    for (auto &executor : executors_)
+    {
+        if (executor->name_ == name)
+            return executor.get();
+    }
+    return nullptr;
+}
+
+size_t ExecutorGroup::executorCount() const
+{
+    std::lock_guard<std::mutex> lock(mtx_);
+    return executors_.size();
+}
+
+bool ExecutorGroup::shutdown(ShutdownMode mode, std::chrono::milliseconds timeout)
+{
+    return pool_.shutdown(mode, timeout);
+}
+
+PoolStats ExecutorGroup::stats()
+{
+    return pool_.stats();
+}
+
+bool ExecutorGroup::enqueue(Executor &executor, std::shared_ptr<Task> sp)
+{
+    pool_.stampTask(*sp, executor.priority_, steadyNowNs()); // then的后续任务提交到组的线程池
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        if (executor.queue_.size() >= executor.maxQueued_)
+        {
+            return false;
+        }
+        // 重新变为非空的执行器从当前的虚拟时间开始，空闲期间不积累额度
+        if (executor.queue_.empty())
+        {
+            executor.pass_ = std::max(executor.pass_, virtualTime_[static_cast<size_t>(executor.priority_)]);
+        }
+        executor.queue_.emplace_back(sp);
+    }
+    if (!pool_.enqueueTask(makeTask<DispatchTask>(this), SubmitPolicy::POLICY_FAIL_FAST))
+    {
+        revoke(executor, sp);
+        return false;
+    }
+    pool_.submittedCount_.add();
+    return true;
+}
+
+void ExecutorGroup::revoke(Executor &executor, const std::shared_ptr<Task> &sp)
+{
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        for (auto it = executor.queue_.rbegin(); it != executor.queue_.rend(); ++it)
+        {
+            if (*it == sp)
+            {
+                executor.queue_.erase(std::next(it).base());
+                return;
+            }
+        }
+    }
+    // 任务已经被其他令牌执行，现在有一个任务没有令牌
+    discardNext();
+}
+
+std::shared_ptr<Task> ExecutorGroup::next(Executor *&from)
+{
+    std::lock_guard<std::mutex> lock(mtx_);
+    Executor *best = nullptr;
+    for (auto &executor : executors_)
+    {
+        if (executor->queue_.empty())
+            continue;
+        if (best == nullptr || executor->priority_ < best->priority_ ||
+            (executor->priority_ == best->priority_ && executor->pass_ < best->pass_))
+        {
+            best = executor.get();
+        }
+    }
+    if (best == nullptr)
+    {
+        return nullptr;
+    }
+    std::shared_ptr<Task> task = std::move(best->queue_.front());
+    best->queue_.pop_front();
+    virtualTime_[static_cast<size_t>(best->priority_)] = best->pass_;
+    best->pass_ += best->stride_;
+    from = best;
+    return task;
+}
+
+void ExecutorGroup::runNext()
+{
+    Executor *from = nullptr;
+    std::shared_ptr<Task> task = next(from);
+    if (task == nullptr)
+    {
+        return;
+    }
+    pool_.runDequeued(*task); // 已经取消或者超过截止时间的任务被跳过
+    from->completed_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void ExecutorGroup::discardNext()
+{
+    Executor *from = nullptr;
+    std::shared_ptr<Task> task = next(from);
+    if (task == nullptr)
+    {
+        return;
+    }
+    task->discard();
+    from->completed_.fetch_add(1, std::memory_order_relaxed);
+}
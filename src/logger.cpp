@@ -0,0 +1,239 @@
+#include "logger.h"
+#include "steadyclock.h"
+#include <chrono>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <algorithm>
+
+// 线程局部的缓冲区句柄析构之后置位；没有析构函数，之后（后析构的线程局部变量、主线程的静态对象析构）仍然可以读取
+static thread_local bool tlsLogBufferRetired = false;
+
+// 线程退出时把自己的缓冲区标记为退役，由flush输出完剩余记录后释放
+struct LocalBufferHandle
+{
+    Logger::Buffer *buffer = nullptr;
+    ~LocalBufferHandle()
+    {
+        if (buffer != nullptr)
+        {
+            buffer->retired.store(true, std::memory_order_release);
+            buffer = nullptr; // 后台线程随时可能释放它
+        }
+        tlsLogBufferRetired = true;
+    }
+};
+static thread_local LocalBufferHandle tlsLogBuffer;
+
+static const char *levelName(LogLevel level)
+{
+    switch (level)
+    {
+    case LogLevel::LEVEL_TRACE:
+        return "TRACE";
+    case LogLevel::LEVEL_DEBUG:
+        return "DEBUG";
+    case LogLevel::LEVEL_INFO:
+        return "INFO";
+    case LogLevel::LEVEL_WARN:
+        return "WARN";
+    default:
+        return "ERROR";
+    }
+}
+
+// 默认输出：WARN及以上输出到std::cerr，其余输出到std::cout
+static void defaultSink(const LogRecord &record)
+{
+    std::ostream &os = record.level >= LogLevel::LEVEL_WARN ? std::cerr : std::cout;
+    os << "[" << levelName(record.level) << "] tid: " << record.tid << " " << record.msg << std::endl;
+}
+
+Logger &Logger::instance()
+{
+    // 故意不析构：脱离的线程在进程退出时仍可能写日志
+    static Logger *logger = new Logger();
+    return *logger;
+}
+
+Logger::Logger()
+    : level_(FLEXIPOOL_LOG_LEVEL), dropped_(0), sink_(defaultSink), stop_(false), wakeup_(false), sleeping_(false), stopped_(false)
+{
+    flusher_ = std::thread(&Logger::flushLoop, this);
+    std::atexit(&Logger::stopAtExit);
+}
+
+void Logger::stopAtExit()
+{
+    Logger &logger = instance();
+    logger.stopped_.store(true); // 之后写的日志不再等待后台线程
+    {
+        std::lock_guard<std::mutex> lock(logger.stopMtx_);
+        logger.stop_ = true;
+    }
+    logger.stopCond_.notify_all();
+    if (logger.flusher_.joinable())
+    {
+        logger.flusher_.join();
+    }
+    logger.flush();
+}
+
+void Logger::log(LogLevel level, const char *fmt, ...)
+{
+    Buffer *buf = localBuffer();
+    if (buf == nullptr)
+    {
+        // 本线程的缓冲区已经退役：在当前线程格式化并直接输出，先输出之前的记录保持顺序
+        LogRecord record;
+        record.level = level;
+        record.timestamp = steadyNowNs();
+        record.tid = std::this_thread::get_id();
+        va_list args;
+        va_start(args, fmt);
+        vsnprintf(record.msg, LOG_MSG_SIZE, fmt, args);
+        va_end(args);
+        std::lock_guard<std::mutex> lock(flushMtx_);
+        flushLocked();
+        sink_(record);
+        return;
+    }
+    size_t tail = buf->tail.load(std::memory_order_relaxed);
+    if (tail - buf->head.load(std::memory_order_acquire) >= LOG_BUFFER_SIZE)
+    {
+        dropped_++; // 缓冲区满，丢弃这条日志
+        return;
+    }
+    // 在本线程格式化，后台线程只负责IO
+    LogRecord &record = buf->records[tail & (LOG_BUFFER_SIZE - 1)];
+    record.level = level;
+    record.timestamp = steadyNowNs();
+    record.tid = std::this_thread::get_id();
+    va_list args;
+    va_start(args, fmt);
+    vsnprintf(record.msg, LOG_MSG_SIZE, fmt, args);
+    va_end(args);
+    buf->tail.store(tail + 1, std::memory_order_release);
+    // 和flushLoop、stopAtExit配对：这条记录要么被它们看到，要么这里看到后台线程在挂起或者已经停止
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (stopped_.load(std::memory_order_relaxed))
+    {
+        flush(); // 进程正在退出，后台线程已经不再输出
+    }
+    else if (sleeping_.load(std::memory_order_relaxed) && sleeping_.exchange(false))
+    {
+        std::lock_guard<std::mutex> lock(stopMtx_);
+        wakeup_ = true;
+        stopCond_.notify_one();
+    }
+}
+
+// 获取当前线程的缓冲区，第一次调用时注册；线程局部变量已经析构时返回nullptr
+Logger::Buffer *Logger::localBuffer()
+{
+    if (tlsLogBufferRetired)
+    {
+        return nullptr;
+    }
+    if (tlsLogBuffer.buffer == nullptr)
+    {
+        Buffer *buf = new Buffer();
+        std::lock_guard<std::mutex> lock(registryMtx_);
+        buffers_.push_back(buf);
+        tlsLogBuffer.buffer = buf;
+    }
+    return tlsLogBuffer.buffer;
+}
+
+void Logger::setSink(LogSink sink)
+{
+    std::lock_guard<std::mutex> lock(flushMtx_);
+    sink_ = sink ? std::move(sink) : LogSink(defaultSink);
+}
+
+void Logger::setLevel(LogLevel level)
+{
+    level_ = static_cast<int>(level);
+}
+
+LogLevel Logger::level() const
+{
+    return static_cast<LogLevel>(level_.load(std::memory_order_relaxed));
+}
+
+void Logger::flush()
+{
+    std::lock_guard<std::mutex> lock(flushMtx_);
+    flushLocked();
+}
+
+size_t Logger::dropped() const
+{
+    return dropped_;
+}
+
+void Logger::flushLocked()
+{
+    std::vector<Buffer *> buffers;
+    {
+        std::lock_guard<std::mutex> lock(registryMtx_);
+        buffers = buffers_;
+    }
+    for (Buffer *buf : buffers)
+    {
+        // 先读retired再输出：标记退役之后线程不会再写入，输出完就可以释放
+        bool retired = buf->retired.load(std::memory_order_acquire);
+        size_t head = buf->head.load(std::memory_order_relaxed);
+        size_t tail = buf->tail.load(std::memory_order_acquire);
+        for (; head != tail; head++)
+        {
+            sink_(buf->records[head & (LOG_BUFFER_SIZE - 1)]);
+        }
+        buf->head.store(head, std::memory_order_release);
+        if (retired)
+        {
+            std::lock_guard<std::mutex> lock(registryMtx_);
+            buffers_.erase(std::find(buffers_.begin(), buffers_.end(), buf));
+            delete buf;
+        }
+    }
+}
+
+bool Logger::hasPending()
+{
+    std::lock_guard<std::mutex> lock(registryMtx_);
+    for (Buffer *buf : buffers_)
+    {
+        if (buf->head.load(std::memory_order_relaxed) != buf->tail.load(std::memory_order_acquire))
+            return true;
+    }
+    return false;
+}
+
+// 后台线程：没有日志时挂起，有日志之后最多等待LOG_FLUSH_INTERVAL输出一次
+void Logger::flushLoop()
+{
+    std::unique_lock<std::mutex> lock(stopMtx_);
+    while (!stop_)
+    {
+        sleeping_.store(true);
+        std::atomic_thread_fence(std::memory_order_seq_cst); // 和log配对
+        if (!hasPending())
+        {
+            stopCond_.wait(lock, [&]() -> bool
+                           { return stop_ || wakeup_; });
+        }
+        sleeping_.store(false, std::memory_order_relaxed);
+        wakeup_ = false;
+        // 积攒这段时间的日志一起输出，停止时剩下的日志由stopAtExit输出
+        if (stopCond_.wait_for(lock, std::chrono::milliseconds(LOG_FLUSH_INTERVAL), [&]() -> bool
+                               { return stop_; }))
+        {
+            break;
+        }
+        lock.unlock();
+        flush();
+        lock.lock();
+    }
+}
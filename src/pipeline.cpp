@@ -0,0 +1,311 @@
+#include "pipeline.h"
+
+struct Pipeline::Token
+{
+    size_t seq;   // 读取输入的顺序
+    size_t stage; // 下一个要执行的阶段
+    void *item;   // 下一个阶段的输入，nullptr表示条目已经被取消
+};
+
+class Pipeline::Run : public std::enable_shared_from_this<Pipeline::Run>
+{
+public:
+    Run(ThreadPool &pool, size_t maxTokens, std::shared_ptr<std::vector<std::unique_ptr<Stage>>> stages)
+        : pool_(pool), maxTokens_(maxTokens), stages_(std::move(stages)), orders_(new Order[stages_->size()]),
+          inFlight_(0), inputBusy_(false), inputDone_(false), stop_(false), nextInput_(0)
+    {
+        for (size_t i = 0; i < stages_->size(); i++)
+        {
+            orders_[i].next = 0;
+            orders_[i].waiting.assign(maxTokens_, nullptr);
+        }
+    }
+
+    // 任务的主体：处理token（为空时先读取输入），之后继续读取输入，直到令牌用完或者输入结束
+    void work(Token *token);
+    // 记录第一个异常，停止读取输入
+    void fail(std::exception_ptr error);
+
+    Completion done_; // 输入结束并且所有令牌都已经回收
+
+    std::exception_ptr error()
+    {
+        std::lock_guard<std::mutex> lock(errorMtx_);
+        return error_;
+    }
+
+private:
+    // 串行阶段的顺序：只有序号等于next的条目可以进入，先到的条目按照序号放在waiting中
+    struct Order
+    {
+        std::mutex mtx;
+        size_t next;
+        std::vector<Token *> waiting; // 下标为seq % maxTokens_：等待的条目的序号一定在[next, next + maxTokens_)之内
+    };
+
+    // 取得输入的读取权并读取一个条目，其他线程正在读取、令牌用完或者输入结束时返回nullptr
+    Token *pull();
+    // 沿着后续阶段处理条目，直到处理完成或者在串行阶段排队
+    void advance(Token *token, std::vector<Token *> &ready);
+    // 执行一个阶段，已经停止时只销毁输入
+    void process(Token *token);
+    // 条目处理完成，回收令牌
+    void finish(Token *token);
+    // 输入结束，没有在途的条目时run()返回
+    void endInput();
+    // 交给其他线程继续处理，提交失败时放入ready由当前线程处理
+    void schedule(Token *token, std::vector<Token *> &ready);
+    // 再提交一个读取输入的任务
+    void spawnReader();
+    // 记录第一个异常
+    void setError(std::exception_ptr error);
+
+    ThreadPool &pool_;
+    const size_t maxTokens_;
+    std::shared_ptr<std::vector<std::unique_ptr<Stage>>> stages_;
+    std::unique_ptr<Order[]> orders_;
+    std::atomic_size_t inFlight_; // 已经读取、还没有处理完成的条目数量
+    std::atomic_bool inputBusy_;  // 有线程正在读取输入，source串行执行
+    std::atomic_bool inputDone_;  // 输入已经结束（source返回false、抛出异常或者已经停止）
+    std::atomic_bool stop_;       // 发生了错误，不再调用用户函数
+    size_t nextInput_;            // 下一个条目的序号，只有持有读取权的线程访问
+    std::mutex errorMtx_;
+    std::exception_ptr error_;
+};
+
+class Pipeline::RunTask : public Task
+{
+public:
+    RunTask(std::shared_ptr<Run> run, Token *token) : run_(std::move(run)), token_(token) {}
+    Any run()
+    {
+        run_->work(token_);
+        return Any();
+    }
+
+protected:
+    // 线程池关闭时被取消：按照失败处理，条目和输入仍然要在这里结束，run()才能返回
+    void onDiscard()
+    {
+        run_->fail(std::make_exception_ptr(std::runtime_error("pipeline task was discarded before running.")));
+        run_->work(token_);
+    }
+
+private:
+    std::shared_ptr<Run> run_;
+    Token *token_;
+};
+
+Pipeline::Pipeline(ThreadPool &pool, size_t maxTokens)
+    : pool_(pool), maxTokens_(std::max<size_t>(maxTokens, 1)), stages_(std::make_shared<std::vector<std::unique_ptr<Stage>>>())
+{
+}
+
+void Pipeline::run()
+{
+    if (stages_->empty())
+    {
+        throw std::logic_error("pipeline has no source.");
+    }
+    std::shared_ptr<Run> run = std::make_shared<Run>(pool_, maxTokens_, stages_);
+    // 线程池队列满或者已经关闭时在当前线程执行
+    pool_.enqueueTask(makeTask<RunTask>(run, nullptr), SubmitPolicy::POLICY_CALLER_RUNS);
+    waitCompletion(run->done_); // 工作线程中等待时先执行线程池中的其他任务
+    std::exception_ptr error = run->error();
+    if (error)
+    {
+        std::rethrow_exception(error);
+    }
+}
+
+void Pipeline::Run::work(Token *token)
+{
+    std::vector<Token *> ready;
+    for (;;)
+    {
+        if (token == nullptr)
+        {
+            if (!ready.empty())
+            {
+                token = ready.back();
+                ready.pop_back();
+            }
+            else if ((token = pull()) == nullptr)
+            {
+                return;
+            }
+        }
+        advance(token, ready);
+        token = nullptr;
+    }
+}
+
+Pipeline::Token *Pipeline::Run::pull()
+{
+    /*
+    回收令牌的线程之后都会调用pull：放弃读取权之后重新检查，
+    持有读取权期间回收的令牌不会因为两边都以为对方会读取而闲置
+    */
+    while (!inputDone_.load() && inFlight_.load() < maxTokens_)
+    {
+        if (inputBusy_.exchange(true))
+        {
+            return nullptr;
+        }
+        Token *token = nullptr;
+        if (stop_.load(std::memory_order_relaxed))
+        {
+            endInput();
+        }
+        else if (pool_.isShutdown_)
+        {
+            // 线程池已经关闭：不再读取输入，已经读取的条目正常处理完
+            setError(std::make_exception_ptr(std::runtime_error("thread pool has been shut down, pipeline stopped reading input.")));
+            endInput();
+        }
+        else if (!inputDone_.load() && inFlight_.load() < maxTokens_)
+        {
+            void *item = nullptr;
+            try
+            {
+                item = (*stages_)[0]->process(nullptr);
+            }
+            catch (...)
+            {
+                fail(std::current_exception());
+            }
+            if (item == nullptr)
+            {
+                endInput();
+            }
+            else
+            {
+                inFlight_.fetch_add(1);
+                token = new (SlabPool::allocate(sizeof(Token))) Token{nextInput_++, 1, item};
+            }
+        }
+        inputBusy_.store(false);
+        if (token != nullptr)
+        {
+            // 还有令牌：让空闲的线程读取下一个条目，当前线程继续处理这个条目
+            if (inFlight_.load() < maxTokens_ && !inputDone_.load())
+            {
+                spawnReader();
+            }
+            return token;
+        }
+    }
+    return nullptr;
+}
+
+void Pipeline::Run::advance(Token *token, std::vector<Token *> &ready)
+{
+    std::vector<std::unique_ptr<Stage>> &stages = *stages_;
+    for (; token->stage < stages.size(); token->stage++)
+    {
+        if (stages[token->stage]->mode_ == StageMode::STAGE_PARALLEL)
+        {
+            process(token);
+            continue;
+        }
+        Order &order = orders_[token->stage];
+        size_t slot = token->seq % maxTokens_;
+        {
+            std::lock_guard<std::mutex> lock(order.mtx);
+            if (token->seq != order.next)
+            {
+                order.waiting[slot] = token; // 前面的条目处理完后交给线程池继续
+                return;
+            }
+        }
+        process(token);
+        Token *next = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(order.mtx);
+            order.next++;
+            slot = order.next % maxTokens_;
+            std::swap(next, order.waiting[slot]);
+        }
+        if (next != nullptr)
+        {
+            schedule(next, ready);
+        }
+    }
+    finish(token);
+}
+
+void Pipeline::Run::process(Token *token)
+{
+    void *in = token->item;
+    token->item = nullptr;
+    if (in == nullptr)
+    {
+        return; // 已经取消的条目仍然经过每个串行阶段，后面的条目才能进入
+    }
+    Stage &stage = *(*stages_)[token->stage];
+    if (stop_.load(std::memory_order_relaxed))
+    {
+        (*stages_)[token->stage - 1]->destroy(in);
+        return;
+    }
+    try
+    {
+        token->item = stage.process(in);
+    }
+    catch (...)
+    {
+        fail(std::current_exception());
+    }
+}
+
+void Pipeline::Run::finish(Token *token)
+{
+    if (token->item != nullptr)
+    {
+        stages_->back()->destroy(token->item);
+    }
+    token->~Token();
+    SlabPool::deallocate(token, sizeof(Token));
+    // 和endInput配对：至少一边能看到另一边的修改
+    if (inFlight_.fetch_sub(1) == 1 && inputDone_.load())
+    {
+        done_.set();
+    }
+}
+
+void Pipeline::Run::endInput()
+{
+    inputDone_.store(true);
+    if (inFlight_.load() == 0)
+    {
+        done_.set();
+    }
+}
+
+void Pipeline::Run::schedule(Token *token, std::vector<Token *> &ready)
+{
+    // 线程池已经关闭时不再提交，剩下的条目由当前线程处理完
+    if (pool_.isShutdown_ || !pool_.enqueueTask(makeTask<RunTask>(shared_from_this(), token), SubmitPolicy::POLICY_FAIL_FAST))
+    {
+        ready.push_back(token);
+    }
+}
+
+void Pipeline::Run::spawnReader()
+{
+    // 提交失败没有关系：当前线程处理完条目后会继续读取
+    pool_.enqueueTask(makeTask<RunTask>(shared_from_this(), nullptr), SubmitPolicy::POLICY_FAIL_FAST);
+}
+
+void Pipeline::Run::fail(std::exception_ptr error)
+{
+    setError(error);
+    stop_.store(true);
+}
+
+void Pipeline::Run::setError(std::exception_ptr error)
+{
+    std::lock_guard<std::mutex> lock(errorMtx_);
+    if (!error_)
+        error_ = error;
+}
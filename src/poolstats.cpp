@@ -0,0 +1,200 @@
+#include "poolstats.h"
+#include <sstream>
+#include <algorithm>
+
+///////////////////////////////////////// 直方图
+LatencyHistogram::LatencyHistogram()
+    : sum_(0), max_(0)
+{
+    for (size_t i = 0; i < HISTOGRAM_BUCKETS; i++)
+    {
+        counts_[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+size_t LatencyHistogram::bucketIndex(uint64_t value)
+{
+    if (value < HISTOGRAM_SUB_COUNT)
+    {
+        return static_cast<size_t>(value);
+    }
+    // 最高位的位置
+#if defined(__GNUC__)
+    size_t msb = 63 - __builtin_clzll(value);
+#else
+    size_t msb = 0;
+    for (uint64_t v = value; v > 1; v >>= 1)
+    {
+        msb++;
+    }
+#endif
+    size_t shift = msb - HISTOGRAM_SUB_BITS;
+    return (msb - HISTOGRAM_SUB_BITS + 1) * HISTOGRAM_SUB_COUNT + ((value >> shift) & (HISTOGRAM_SUB_COUNT - 1));
+}
+
+uint64_t LatencyHistogram::bucketUpperBound(size_t index)
+{
+    if (index < HISTOGRAM_SUB_COUNT)
+    {
+        return index;
+    }
+    size_t shift = index / HISTOGRAM_SUB_COUNT - 1;
+    uint64_t sub = index % HISTOGRAM_SUB_COUNT;
+    uint64_t lower = (HISTOGRAM_SUB_COUNT + sub) << shift;
+    return lower + ((uint64_t(1) << shift) - 1);
+}
+
+HistogramSnapshot::HistogramSnapshot()
+    : counts_(HISTOGRAM_BUCKETS, 0), count_(0), sum_(0), max_(0)
+{
+}
+
+void HistogramSnapshot::merge(const LatencyHistogram &histogram)
+{
+    for (size_t i = 0; i < HISTOGRAM_BUCKETS; i++)
+    {
+        uint64_t n = histogram.counts_[i].load(std::memory_order_relaxed);
+        counts_[i] += n;
+        count_ += n;
+    }
+    sum_ += histogram.sum_.load(std::memory_order_relaxed);
+    max_ = std::max(max_, histogram.max_.load(std::memory_order_relaxed));
+}
+
+void HistogramSnapshot::merge(const HistogramSnapshot &other)
+{
+    for (size_t i = 0; i < HISTOGRAM_BUCKETS; i++)
+    {
+        counts_[i] += other.counts_[i];
+    }
+    count_ += other.count_;
+    sum_ += other.sum_;
+    max_ = std::max(max_, other.max_);
+}
+
+uint64_t HistogramSnapshot::percentile(double q) const
+{
+    if (count_ == 0)
+    {
+        return 0;
+    }
+    uint64_t target = static_cast<uint64_t>(q * count_);
+    if (target == 0)
+    {
+        target = 1;
+    }
+    uint64_t seen = 0;
+    for (size_t i = 0; i < HISTOGRAM_BUCKETS; i++)
+    {
+        seen += counts_[i];
+        if (seen >= target)
+        {
+            return std::min(LatencyHistogram::bucketUpperBound(i), max_);
+        }
+    }
+    return max_;
+}
+
+uint64_t HistogramSnapshot::countBelow(uint64_t value) const
+{
+    uint64_t seen = 0;
+    for (size_t i = 0; i < HISTOGRAM_BUCKETS && LatencyHistogram::bucketUpperBound(i) <= value; i++)
+    {
+        seen += counts_[i];
+    }
+    return seen;
+}
+
+///////////////////////////////////////// 计数器
+WorkerCounters::WorkerCounters(size_t id)
+    : threadId(id), completed(0), stolen(0), busyNs(0), idleNs(0), lastTransition(0), depth(0), nestedNs(0)
+{
+}
+
+StripedCounter::StripedCounter()
+{
+    for (size_t i = 0; i < COUNTER_STRIPES; i++)
+    {
+        stripes_[i].value.store(0, std::memory_order_relaxed);
+    }
+}
+
+uint64_t StripedCounter::load() const
+{
+    uint64_t sum = 0;
+    for (size_t i = 0; i < COUNTER_STRIPES; i++)
+    {
+        sum += stripes_[i].value.load(std::memory_order_relaxed);
+    }
+    return sum;
+}
+
+// 每个线程第一次使用时按顺序分配一个槽位
+size_t StripedCounter::stripeIndex()
+{
+    static std::atomic<size_t> nextStripe(0);
+    static thread_local size_t stripe = nextStripe.fetch_add(1, std::memory_order_relaxed) % COUNTER_STRIPES;
+    return stripe;
+}
+
+///////////////////////////////////////// Prometheus导出
+// 直方图导出时使用的桶边界（纳秒）：1us到10s按照1-2-5递增
+static const uint64_t PROMETHEUS_BOUNDS[] = {
+    1000, 2000, 5000, 10000, 20000, 50000, 100000, 200000, 500000,
+    1000000, 2000000, 5000000, 10000000, 20000000, 50000000, 100000000, 200000000, 500000000,
+    1000000000, 2000000000, 5000000000, 10000000000};
+
+static void writeHistogram(std::ostringstream &os, const std::string &name, const std::string &help, const HistogramSnapshot &h)
+{
+    os << "# HELP " << name << " " << help << "\n";
+    os << "# TYPE " << name << " histogram\n";
+    for (uint64_t bound : PROMETHEUS_BOUNDS)
+    {
+        os << name << "_bucket{le=\"" << bound / 1e9 << "\"} " << h.countBelow(bound) << "\n";
+    }
+    os << name << "_bucket{le=\"+Inf\"} " << h.count() << "\n";
+    os << name << "_sum " << h.sum() / 1e9 << "\n";
+    os << name << "_count " << h.count() << "\n";
+}
+
+static void writeMetric(std::ostringstream &os, const std::string &name, const char *type, const std::string &help, uint64_t value)
+{
+    os << "# HELP " << name << " " << help << "\n";
+    os << "# TYPE " << name << " " << type << "\n";
+    os << name << " " << value << "\n";
+}
+
+std::string PoolStats::toPrometheus(const std::string &prefix) const
+{
+    std::ostringstream os;
+    writeMetric(os, prefix + "_tasks_submitted_total", "counter", "Tasks accepted by the pool.", submitted);
+    writeMetric(os, prefix + "_tasks_completed_total", "counter", "Tasks executed to completion.", completed);
+    writeMetric(os, prefix + "_tasks_caller_runs_total", "counter", "Tasks run by a submitting thread outside the pool (POLICY_CALLER_RUNS).", callerRuns);
+    writeMetric(os, prefix + "_tasks_rejected_total", "counter", "Tasks whose submission failed.", rejected);
+    writeMetric(os, prefix + "_tasks_dropped_total", "counter", "Queued tasks discarded by POLICY_DROP_OLDEST.", dropped);
+    writeMetric(os, prefix + "_tasks_cancelled_total", "counter", "Queued tasks cancelled before running (shutdown, token or deadline).", cancelled);
+    writeMetric(os, prefix + "_tasks_stolen_total", "counter", "Tasks stolen from another worker's deque.", stolen);
+    writeMetric(os, prefix + "_threads_created_total", "counter", "Threads created on demand in cached mode.", threadsCreated);
+    writeMetric(os, prefix + "_threads_reaped_total", "counter", "Idle threads reaped in cached mode.", threadsReaped);
+    writeMetric(os, prefix + "_queue_depth", "gauge", "Tasks waiting to be executed.", queueDepth);
+    writeMetric(os, prefix + "_threads", "gauge", "Current number of worker threads.", curThreads);
+    writeMetric(os, prefix + "_threads_idle", "gauge", "Current number of idle worker threads.", idleThreads);
+    writeHistogram(os, prefix + "_queue_wait_seconds", "Time from submission to the start of execution.", queueWait);
+    writeHistogram(os, prefix + "_exec_seconds", "Task execution time.", execTime);
+
+    std::string busy = prefix + "_worker_busy_seconds_total";
+    os << "# HELP " << busy << " Time each worker spent executing tasks.\n";
+    os << "# TYPE " << busy << " counter\n";
+    for (const WorkerStats &w : workers)
+    {
+        os << busy << "{worker=\"" << w.threadId << "\"} " << w.busyNs / 1e9 << "\n";
+    }
+    std::string idle = prefix + "_worker_idle_seconds_total";
+    os << "# HELP " << idle << " Time each worker spent waiting for tasks.\n";
+    os << "# TYPE " << idle << " counter\n";
+    for (const WorkerStats &w : workers)
+    {
+        os << idle << "{worker=\"" << w.threadId << "\"} " << w.idleNs / 1e9 << "\n";
+    }
+    return os.str();
+}
@@ -0,0 +1,103 @@
+#include "resultset.h"
+
+const size_t ResultSet::npos;
+
+// 所有任务共享的完成状态：只有一个等待者（使用ResultSet的线程），完成的数量达到它等待的数量时才通知
+class ResultSet::State : public TaskObserver
+{
+public:
+    State() : waiting_(false), wanted_(0) {}
+
+    // 任务完成，在完成它的线程中调用
+    void taskDone(size_t index)
+    {
+        bool wake;
+        {
+            std::lock_guard<std::mutex> lock(mtx_);
+            order_.push_back(index);
+            wake = waiting_ && order_.size() == wanted_;
+        }
+        if (wake)
+        {
+            cond_.notify_one();
+        }
+    }
+    // 阻塞直到至少count个任务完成
+    void waitCompleted(size_t count)
+    {
+        std::unique_lock<std::mutex> lock(mtx_);
+        if (order_.size() >= count)
+            return;
+        waiting_ = true;
+        wanted_ = count;
+        cond_.wait(lock, [&]() -> bool
+                   { return order_.size() >= count; });
+        waiting_ = false;
+    }
+    // 第i个完成的任务的编号，调用者保证已经有i+1个任务完成
+    size_t completedAt(size_t i)
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        return order_[i];
+    }
+    size_t completed()
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        return order_.size();
+    }
+
+private:
+    std::mutex mtx_;
+    std::condition_variable cond_;
+    std::vector<size_t> order_; // 按照完成顺序记录的任务编号
+    bool waiting_;              // 等待者是否已经挂起
+    size_t wanted_;             // 等待者需要的完成数量
+};
+
+ResultSet::ResultSet(ThreadPool &pool) : pool_(pool), state_(std::make_shared<State>()), consumed_(0)
+{
+}
+
+size_t ResultSet::submitTask(std::shared_ptr<Task> sp)
+{
+    size_t index = results_.size();
+    // 先绑定Result和观察者再入队，任务被取走执行时两者都已经就绪
+    results_.emplace_back(sp);
+    sp->setObserver(state_, index);
+    if (!pool_.enqueueTask(sp, pool_.submitPolicy_))
+    {
+        results_.back().isValid_ = false; // 提交失败，get()不会阻塞
+        state_->taskDone(index);
+    }
+    return index;
+}
+
+size_t ResultSet::completed() const
+{
+    return state_->completed();
+}
+
+void ResultSet::waitAll()
+{
+    state_->waitCompleted(results_.size());
+}
+
+size_t ResultSet::waitAny()
+{
+    if (results_.empty())
+    {
+        return npos;
+    }
+    state_->waitCompleted(1);
+    return state_->completedAt(0);
+}
+
+size_t ResultSet::next()
+{
+    if (consumed_ == results_.size())
+    {
+        return npos;
+    }
+    state_->waitCompleted(consumed_ + 1);
+    return state_->completedAt(consumed_++);
+}
@@ -0,0 +1,132 @@
+#include "strand.h"
+
+class Strand::State
+{
+public:
+    explicit State(ThreadPool &pool) : pool_(pool), pending_(0) {}
+
+    // 计数已经包含的任务一定会入队，生产者还没有链接好节点时稍等
+    std::shared_ptr<Task> take()
+    {
+        std::shared_ptr<Task> task;
+        for (size_t spin = 0; !queue_.pop(task); spin++)
+        {
+            if (spin < 64)
+                cpuRelax();
+            else
+                std::this_thread::yield();
+        }
+        return task;
+    }
+
+    ThreadPool &pool_;
+    MpscQueue<std::shared_ptr<Task>> queue_; // 只有持有排空任务的线程出队
+    std::atomic_size_t pending_;             // 入队、还没有执行完的任务数量，从0变为1的提交者负责提交排空任务
+};
+
+class Strand::DrainTask : public Task
+{
+public:
+    explicit DrainTask(std::shared_ptr<State> state) : state_(std::move(state)) {}
+    Any run()
+    {
+        Strand::drain(state_);
+        return Any();
+    }
+
+protected:
+    void onDiscard()
+    {
+        Strand::discardAll(state_);
+    }
+
+private:
+    std::shared_ptr<State> state_;
+};
+
+Strand::Strand(ThreadPool &pool) : state_(std::make_shared<State>(pool))
+{
+}
+
+Result Strand::submitTask(std::shared_ptr<Task> sp)
+{
+    Result result(sp);
+    if (!enqueue(sp))
+    {
+        result.isValid_ = false; // 提交失败，get()不会阻塞
+    }
+    return result;
+}
+
+bool Strand::enqueue(std::shared_ptr<Task> sp)
+{
+    ThreadPool &pool = state_->pool_;
+    if (pool.isShutdown_)
+    {
+        return false;
+    }
+    pool.stampTask(*sp, Priority::PRIORITY_NORMAL, steadyNowNs()); // then的后续任务提交到同一个线程池
+    state_->queue_.push(std::move(sp));
+    pool.submittedCount_.add();
+    if (state_->pending_.fetch_add(1, std::memory_order_acq_rel) == 0)
+    {
+        // 队列满或者正在关闭时在当前线程排空，和then的后续任务相同
+        pool.enqueueTask(makeTask<DrainTask>(state_), SubmitPolicy::POLICY_CALLER_RUNS);
+    }
+    return true;
+}
+
+size_t Strand::pending() const
+{
+    return state_->pending_.load(std::memory_order_acquire);
+}
+
+void Strand::drain(const std::shared_ptr<State> &state)
+{
+    for (size_t n = 1;; n++)
+    {
+        std::shared_ptr<Task> task = state->take();
+        state->pool_.runDequeued(*task); // 已经取消或者超过截止时间的任务被跳过
+        if (state->pending_.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        {
+            return;
+        }
+        // 还有任务：重新排到线程池的队尾，放不进去时继续在这里执行
+        if (n % STRAND_BATCH == 0 && state->pool_.enqueueTask(makeTask<DrainTask>(state), SubmitPolicy::POLICY_FAIL_FAST))
+        {
+            return;
+        }
+    }
+}
+
+void Strand::discardAll(const std::shared_ptr<State> &state)
+{
+    for (;;)
+    {
+        state->take()->discard();
+        if (state->pending_.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        {
+            return;
+        }
+    }
+}
+
+StrandGroup::StrandGroup(ThreadPool &pool, size_t strands)
+{
+    strands = std::max<size_t>(strands, 1);
+    strands_.reserve(strands);
+    for (size_t i = 0; i < strands; i++)
+    {
+        strands_.emplace_back(new Strand(pool));
+    }
+}
+
+size_t StrandGroup::pending() const
+{
+    size_t sum = 0;
+    for (auto &strand : strands_)
+    {
+        sum += strand->pending();
+    }
+    return sum;
+}
@@ -0,0 +1,146 @@
+#include "taskallocator.h"
+#include <mutex>
+#include <vector>
+
+// 空闲块通过第一个字链接起来
+struct FreeBlock
+{
+    FreeBlock *next;
+};
+
+// 一串空闲块
+struct FreeList
+{
+    FreeBlock *head = nullptr;
+    size_t count = 0;
+
+    void push(FreeBlock *block)
+    {
+        block->next = head;
+        head = block;
+        count++;
+    }
+    FreeBlock *pop()
+    {
+        FreeBlock *block = head;
+        head = block->next;
+        count--;
+        return block;
+    }
+    // 从头部拆下n个块
+    FreeList split(size_t n)
+    {
+        FreeList list;
+        while (n-- > 0 && head != nullptr)
+        {
+            list.push(pop());
+        }
+        return list;
+    }
+};
+
+// 全局仓库：各级一把锁，整批存取
+class SlabDepot
+{
+public:
+    static SlabDepot &instance()
+    {
+        // 故意不析构：线程退出时归还的块可能晚于静态对象析构
+        static SlabDepot *depot = new SlabDepot();
+        return *depot;
+    }
+
+    // 取一批空闲块，仓库为空时向系统申请
+    FreeList take(size_t cls)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mtx_[cls]);
+            if (!batches_[cls].empty())
+            {
+                FreeList list = batches_[cls].back();
+                batches_[cls].pop_back();
+                return list;
+            }
+        }
+        size_t size = SLAB_MIN_SIZE << cls;
+        char *chunk = static_cast<char *>(::operator new(size * SLAB_BATCH));
+        FreeList list;
+        for (size_t i = 0; i < SLAB_BATCH; i++)
+        {
+            list.push(reinterpret_cast<FreeBlock *>(chunk + i * size));
+        }
+        return list;
+    }
+
+    void give(size_t cls, FreeList list)
+    {
+        if (list.count == 0)
+            return;
+        std::lock_guard<std::mutex> lock(mtx_[cls]);
+        batches_[cls].push_back(list);
+    }
+
+private:
+    std::mutex mtx_[SLAB_CLASSES];
+    std::vector<FreeList> batches_[SLAB_CLASSES];
+};
+
+// 线程缓存：线程退出时把剩余的块还给仓库
+struct SlabCache
+{
+    FreeList lists[SLAB_CLASSES];
+    ~SlabCache()
+    {
+        for (size_t i = 0; i < SLAB_CLASSES; i++)
+        {
+            SlabDepot::instance().give(i, lists[i]);
+            lists[i] = FreeList(); // 之后还有释放时不会重复归还
+        }
+    }
+};
+static thread_local SlabCache tlsSlabCache;
+
+// 请求大小对应的级别，超出最大块时返回SLAB_CLASSES
+static size_t sizeClass(size_t bytes)
+{
+    size_t cls = 0;
+    size_t size = SLAB_MIN_SIZE;
+    while (size < bytes && cls < SLAB_CLASSES)
+    {
+        size <<= 1;
+        cls++;
+    }
+    return cls;
+}
+
+void *SlabPool::allocate(size_t bytes)
+{
+    size_t cls = sizeClass(bytes);
+    if (cls == SLAB_CLASSES)
+    {
+        return ::operator new(bytes);
+    }
+    FreeList &list = tlsSlabCache.lists[cls];
+    if (list.head == nullptr)
+    {
+        list = SlabDepot::instance().take(cls);
+    }
+    return list.pop();
+}
+
+void SlabPool::deallocate(void *p, size_t bytes)
+{
+    size_t cls = sizeClass(bytes);
+    if (cls == SLAB_CLASSES)
+    {
+        ::operator delete(p);
+        return;
+    }
+    // 任务通常在工作线程释放，缓存过多时整批还给仓库，提交线程再整批取回
+    FreeList &list = tlsSlabCache.lists[cls];
+    list.push(static_cast<FreeBlock *>(p));
+    if (list.count >= 2 * SLAB_BATCH)
+    {
+        SlabDepot::instance().give(cls, list.split(SLAB_BATCH));
+    }
+}
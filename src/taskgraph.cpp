@@ -0,0 +1,191 @@
+#include "taskgraph.h"
+
+// 一次执行的完成状态：所有节点都完成（执行或者跳过）时完成，有节点失败时得到第一个异常
+class TaskGraph::GraphState : public TypedState<void>
+{
+public:
+    GraphState(size_t count, ThreadPool *pool) : remaining_(count)
+    {
+        setPool(pool);
+    }
+    // 记录第一个异常
+    void fail(std::exception_ptr error)
+    {
+        std::lock_guard<std::mutex> lock(errorMtx_);
+        if (!error_)
+            error_ = error;
+    }
+    // 一个节点完成
+    void arrive()
+    {
+        if (remaining_.fetch_sub(1, std::memory_order_acq_rel) != 1)
+            return;
+        std::exception_ptr error;
+        {
+            std::lock_guard<std::mutex> lock(errorMtx_);
+            error = error_;
+        }
+        if (error)
+            setError(error);
+        else
+            setReady();
+    }
+    Any run()
+    {
+        return Any();
+    }
+
+private:
+    std::atomic_size_t remaining_;
+    std::mutex errorMtx_;
+    std::exception_ptr error_;
+};
+
+// 执行一个节点的任务，持有完成状态，保证最后一个节点完成时状态还存在
+class TaskGraph::NodeTask : public Task
+{
+public:
+    NodeTask(TaskGraph *graph, Node node, std::shared_ptr<GraphState> state)
+        : graph_(graph), node_(node), state_(std::move(state)) {}
+    Any run()
+    {
+        graph_->runNode(node_, state_, false);
+        return Any();
+    }
+
+protected:
+    // 线程池关闭时被取消：按照失败处理，后继节点跳过，执行仍然能够完成
+    void onDiscard()
+    {
+        graph_->runNode(node_, state_, true);
+    }
+
+private:
+    TaskGraph *graph_;
+    Node node_;
+    std::shared_ptr<GraphState> state_;
+};
+
+TaskGraph::TaskGraph(ThreadPool &pool)
+    : pool_(pool)
+{
+}
+
+TaskGraph::~TaskGraph()
+{
+    if (state_ != nullptr)
+    {
+        state_->wait();
+    }
+}
+
+void TaskGraph::precede(Node before, Node after)
+{
+    nodes_[before]->successors.push_back(after);
+    nodes_[after]->dependencies++;
+}
+
+TypedResult<void> TaskGraph::run()
+{
+    if (state_ != nullptr)
+    {
+        state_->wait();
+    }
+    if (hasCycle())
+    {
+        throw std::logic_error("task graph has a cycle.");
+    }
+    // 多计一次，所有起始节点提交之后再减掉，空图也能完成
+    state_ = makeTask<GraphState>(nodes_.size() + 1, &pool_);
+    for (auto &node : nodes_)
+    {
+        node->pending.store(node->dependencies, std::memory_order_relaxed);
+        node->skip.store(false, std::memory_order_relaxed);
+    }
+    for (Node i = 0; i < nodes_.size(); i++)
+    {
+        if (nodes_[i]->dependencies == 0)
+        {
+            ThreadPool::scheduleContinuation(&pool_, makeTask<NodeTask>(this, i, state_));
+        }
+    }
+    std::shared_ptr<GraphState> state = state_;
+    state->arrive();
+    return TypedResult<void>(state);
+}
+
+void TaskGraph::wait()
+{
+    if (state_ != nullptr)
+    {
+        state_->take();
+    }
+}
+
+void TaskGraph::runNode(Node node, const std::shared_ptr<GraphState> &state, bool discarded)
+{
+    NodeState &current = *nodes_[node];
+    bool failed = current.skip.load(std::memory_order_acquire);
+    if (discarded && !failed)
+    {
+        state->fail(std::make_exception_ptr(std::runtime_error("task was discarded before running.")));
+        failed = true;
+    }
+    if (!failed)
+    {
+        try
+        {
+            current.func();
+        }
+        catch (...)
+        {
+            state->fail(std::current_exception());
+            failed = true;
+        }
+    }
+    for (Node next : current.successors)
+    {
+        release(next, failed, state);
+    }
+    // 最后一个节点完成后图可能被析构，之后不能再访问成员
+    state->arrive();
+}
+
+void TaskGraph::release(Node node, bool skip, const std::shared_ptr<GraphState> &state)
+{
+    NodeState &next = *nodes_[node];
+    if (skip)
+    {
+        next.skip.store(true, std::memory_order_relaxed); // 随后的fetch_sub发布这个写入
+    }
+    if (next.pending.fetch_sub(1, std::memory_order_acq_rel) == 1)
+    {
+        ThreadPool::scheduleContinuation(&pool_, makeTask<NodeTask>(this, node, state));
+    }
+}
+
+// Kahn算法：能按拓扑序访问到所有节点时没有环
+bool TaskGraph::hasCycle() const
+{
+    std::vector<size_t> pending(nodes_.size());
+    std::vector<Node> ready;
+    for (Node i = 0; i < nodes_.size(); i++)
+    {
+        pending[i] = nodes_[i]->dependencies;
+        if (pending[i] == 0)
+            ready.push_back(i);
+    }
+    size_t visited = 0;
+    while (!ready.empty())
+    {
+        Node node = ready.back();
+        ready.pop_back();
+        visited++;
+        for (Node next : nodes_[node]->successors)
+        {
+            if (--pending[next] == 0)
+                ready.push_back(next);
+        }
+    }
+    return visited != nodes_.size();
+}
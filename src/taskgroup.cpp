@@ -0,0 +1,57 @@
+#include "taskgroup.h"
+
+TaskGroup::TaskGroup(ThreadPool &pool) : pool_(pool), pending_(1)
+{
+}
+
+TaskGroup::~TaskGroup()
+{
+    waitChildren();
+}
+
+void TaskGroup::sync()
+{
+    waitChildren();
+    std::exception_ptr error;
+    {
+        std::lock_guard<std::mutex> lock(errorMtx_);
+        error.swap(error_);
+    }
+    if (error)
+    {
+        std::rethrow_exception(error);
+    }
+}
+
+void TaskGroup::schedule(std::shared_ptr<Task> task)
+{
+    pool_.enqueueTask(std::move(task), SubmitPolicy::POLICY_CALLER_RUNS);
+}
+
+void TaskGroup::fail(std::exception_ptr error)
+{
+    std::lock_guard<std::mutex> lock(errorMtx_);
+    if (!error_)
+        error_ = error;
+}
+
+void TaskGroup::childDone()
+{
+    // 计数包含等待者的一个引用：减到0时等待者一定在等done_，set()之后不再访问任务组
+    if (pending_.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        done_.set();
+}
+
+void TaskGroup::waitChildren()
+{
+    /*
+    先放弃等待者自己的引用：不是最后一个时，最后完成的子任务一定会set()，
+    只有看到done_完成才返回，子任务的set()结束之前任务组不会被析构
+    */
+    if (pending_.fetch_sub(1, std::memory_order_acq_rel) != 1)
+    {
+        waitCompletion(done_); // 工作线程中先执行本地队列底部还没有被窃取的子任务
+        done_.reset();
+    }
+    pending_.store(1, std::memory_order_relaxed); // 下一轮spawn重新计数
+}
@@ -1,23 +1,61 @@
 #include "threadpool.h"
 
+// 当前线程所属的线程池（任务中等待时用来执行排队的任务）及其在workerQues_中的下标（工作窃取模式下用于识别池内提交）
+static thread_local ThreadPool *tlsPool = nullptr;
+static thread_local size_t tlsWorkerIndex = 0;
+// 当前工作线程所在的NUMA节点
+static thread_local size_t tlsWorkerNode = 0;
+// 当前工作线程的统计计数器，非工作线程为空
+static thread_local WorkerCounters *tlsWorkerCounters = nullptr;
+// 当前线程正在执行的任务
+static thread_local Task *tlsCurrentTask = nullptr;
+// 当前线程正在执行的post的可调用对象的嵌套层数（可调用对象没有Task，不设置tlsCurrentTask）
+static thread_local uint32_t tlsPostedDepth = 0;
+
+// 当前线程是否在执行线程池的任务（包括post的可调用对象），在任务中等待结果时帮忙执行排队的任务
+static bool inPoolTask()
+{
+    return tlsCurrentTask != nullptr || tlsPostedDepth > 0;
+}
+
+// 工作窃取队列中的元素：从内存池分配的槽位
+static QueuedTask *newTaskBox(QueuedTask slot)
+{
+    void *p = SlabPool::allocate(sizeof(QueuedTask));
+    return new (p) QueuedTask(std::move(slot));
+}
+
+// 取出元素中的槽位，并释放元素
+static void openTaskBox(QueuedTask *box, QueuedTask &slot)
+{
+    slot = std::move(*box);
+    box->~QueuedTask();
+    SlabPool::deallocate(box, sizeof(QueuedTask));
+}
+
 ////////////////////////////////////// 线程池方法实现
 
 // 线程池的构造
 ThreadPool::ThreadPool()
-    : initThreadSize_(0), taskSize_(0), taskQueMaxThreshHold_(TASK_MAX_THRESHOLD), threadSizeThreshHold_(THREAD_MAX_THRESHHOLD), curThreadSize_(0), poolMode_(PoolMode::MODE_FIXED), isPoolRunning_(false), threadIdelSize_(0)
+    : poolMode_(PoolMode::MODE_FIXED), taskQueMode_(TaskQueMode::MODE_LOCKED), submitPolicy_(SubmitPolicy::POLICY_BLOCK), submitTimeout_(SUBMIT_TIMEOUT),
+      initThreadSize_(0), threadSizeThreshHold_(THREAD_MAX_THRESHHOLD), taskQueMaxThreshHold_(TASK_MAX_THRESHOLD), capsEnabled_(false), agingTime_(TASK_AGING_TIME),
+      affinityMode_(AffinityMode::AFFINITY_NONE), idleStrategy_(IdleStrategy::IDLE_ADAPTIVE), threadIdleTimeout_(std::chrono::seconds(THREAD_IDLE_TIME)), elasticInterval_(ELASTIC_INTERVAL),
+      isPoolRunning_(false), isShutdown_(false), workersExited_(false), taskSize_(0), producerWaitSize_(0), nodeTaskSize_(0), threadWaitSize_(0),
+      curThreadSize_(0), nextWorkerSlot_(0), spawnRequested_(false), keepThreads_(0), threadsCreated_(0), threadsReaped_(0), cancelledCount_(0),
+      timers_(std::bind(&ThreadPool::fireTimers, this, std::placeholders::_1))
 {
+    for (size_t i = 0; i < PRIORITY_LEVELS; i++)
+    {
+        levelSize_[i] = 0;
+        levelRunning_[i] = 0;
+        levelCap_[i] = SIZE_MAX;
+    }
 }
 
-// 线程池的析构
+// 线程池的析构：执行完所有排队的任务，等待并回收所有线程
 ThreadPool::~ThreadPool()
 {
-    isPoolRunning_ = false;
-
-    // 等待线程池中所有的线程返回（系统线程：阻塞&正在运行中）
-    std::unique_lock<std::mutex> lock(taskQueMtx_);
-    notEmpty_.notify_all(); // 唤醒所有阻塞的线程
-    exitCond_.wait(lock, [&]() -> bool
-                   { return threads_.size() == 0; }); // 主线程阻塞
+    shutdown(ShutdownMode::SHUTDOWN_DRAIN);
 }
 
 // 设置线程池的工作模式
@@ -47,22 +85,154 @@ void ThreadPool::setThreadMaxThreshHold(size_t threshhold)
     }
 }
 
+// 设置cached模式下的线程空闲超时
+void ThreadPool::setThreadIdleTimeout(std::chrono::milliseconds timeout)
+{
+    if (checkRunningState())
+        return;
+    threadIdleTimeout_ = std::max(timeout, std::chrono::milliseconds(1));
+}
+
+// 设置cached模式下监督线程的采样周期
+void ThreadPool::setElasticInterval(std::chrono::milliseconds interval)
+{
+    if (checkRunningState())
+        return;
+    elasticInterval_ = std::max(interval, std::chrono::milliseconds(1));
+}
+
+// 设置任务队列的实现方式
+void ThreadPool::setTaskQueMode(TaskQueMode mode)
+{
+    if (checkRunningState())
+        return;
+    taskQueMode_ = mode;
+}
+
+// 设置任务队列满时默认的提交策略
+void ThreadPool::setSubmitPolicy(SubmitPolicy policy)
+{
+    if (checkRunningState())
+        return;
+    submitPolicy_ = policy;
+}
+
+// 设置POLICY_BLOCK策略下提交任务的最长等待时间
+void ThreadPool::setSubmitTimeout(std::chrono::milliseconds timeout)
+{
+    if (checkRunningState())
+        return;
+    submitTimeout_ = timeout;
+}
+
+// 设置优先级老化时间
+void ThreadPool::setPriorityAging(std::chrono::milliseconds aging)
+{
+    if (checkRunningState())
+        return;
+    agingTime_ = aging;
+}
+
+// 设置某个优先级同时执行的任务数量上限
+void ThreadPool::setPriorityConcurrency(Priority priority, size_t maxRunning)
+{
+    if (checkRunningState())
+        return;
+    levelCap_[static_cast<size_t>(priority)] = std::max<size_t>(maxRunning, 1);
+    capsEnabled_ = true;
+}
+
+// 设置工作线程的CPU绑定方式
+void ThreadPool::setAffinityMode(AffinityMode mode)
+{
+    if (checkRunningState())
+        return;
+    affinityMode_ = mode;
+}
+
+// 设置空闲线程等待新任务的方式
+void ThreadPool::setIdleStrategy(IdleStrategy strategy)
+{
+    if (checkRunningState())
+        return;
+    idleStrategy_ = strategy;
+}
+
+// 使用自定义的CPU拓扑
+void ThreadPool::setCpuTopology(const CpuTopology &topology)
+{
+    if (checkRunningState())
+        return;
+    topology_ = topology;
+}
+
+// 线程池使用的NUMA节点数量
+size_t ThreadPool::nodeCount() const
+{
+    return nodeShards_.empty() ? 1 : nodeShards_.size();
+}
 
 // 开启线程池，创建线程，为每个线程分配线程函数。
 void ThreadPool::start(size_t initThreadSize)
 {
+    if (isShutdown_)
+    {
+        FLEXIPOOL_LOG_ERROR("thread pool has been shut down, start failed.");
+        return;
+    }
     // 设置线程池的运行状态
     isPoolRunning_ = true;
     // 记录初始线程个数
     initThreadSize_ = initThreadSize;
     curThreadSize_ = initThreadSize;
+    // 环形缓冲区模式：容量由任务队列上限阈值决定（向上取整为2的幂）
+    if (taskQueMode_ == TaskQueMode::MODE_RING_BUFFER)
+    {
+        size_t capacity = taskQueMaxThreshHold_ == TASK_MAX_THRESHOLD ? TASK_RING_DEFAULT_SIZE : taskQueMaxThreshHold_;
+        ringQue_.reset(new MpmcQueue<QueuedTask>(capacity));
+    }
+    // 设置了CPU绑定：检测拓扑，每个节点一个任务队列分片
+    if (affinityMode_ != AffinityMode::AFFINITY_NONE)
+    {
+        if (topology_.nodeCount() == 0)
+        {
+            topology_ = CpuTopology::detect();
+        }
+        for (size_t i = 0; i < topology_.nodeCount(); i++)
+        {
+            nodeShards_.emplace_back(new NodeShard());
+        }
+    }
+    /*
+    工作窃取模式：线程数量固定，先确定每个线程所在的节点；
+    本地双端队列由线程绑定CPU之后自己创建（首次访问的内存分配在本节点），start等待全部创建完成
+    */
+    CountDownLatch ready(poolMode_ == PoolMode::MODE_WORK_STEALING ? initThreadSize_ : 0);
+    if (poolMode_ == PoolMode::MODE_WORK_STEALING)
+    {
+        workerQues_.resize(initThreadSize_);
+        nodeWorkers_.assign(nodeCount(), std::vector<size_t>());
+        for (size_t i = 0; i < initThreadSize_; i++)
+        {
+            workerNode_.push_back(slotNode(i));
+            nodeWorkers_[slotNode(i)].push_back(i);
+        }
+    }
     // 创建线程对象的时候，把线程函数给到thread线程对象
-    for (int i = 0; i < initThreadSize_; i++)
+    for (size_t i = 0; i < initThreadSize_; i++)
     {
         // 创建新线程
         // auto ptr = std::make_unique<Thread>(std::bind(&ThreadPool::threadHandler, this, std::placeholders::_1)); // C++14
 
-        std::unique_ptr<Thread> ptr(new Thread(std::bind(&ThreadPool::threadHandler, this, std::placeholders::_1))); // c++11
+        std::unique_ptr<Thread> ptr;
+        if (poolMode_ == PoolMode::MODE_WORK_STEALING)
+        {
+            ptr.reset(new Thread(std::bind(&ThreadPool::stealingHandler, this, std::placeholders::_1, i, &ready)));
+        }
+        else
+        {
+            ptr.reset(new Thread(std::bind(&ThreadPool::threadHandler, this, std::placeholders::_1))); // c++11
+        }
 
         // std::unique_ptr<Thread> ptr(new Thread(std::bind(&ThreadPool::threadHandler, this))); // C++11
         size_t threadId = ptr->getId();
@@ -70,11 +240,22 @@ void ThreadPool::start(size_t initThreadSize)
         // threads_.emplace_back(std::move(ptr)); //  emplace_back会进行拷贝，而unique_ptr不支持拷贝
     }
 
-    // 启动所有对象
-    for (int i = 0; i < initThreadSize_; i++)
+    // 启动所有对象（线程id是全局递增的，多个线程池时不一定从0开始，所以遍历容器）
+    // 先加锁：线程启动后可能立即访问threads_
+    {
+        std::unique_lock<std::mutex> lock(taskQueMtx_);
+        for (auto &item : threads_)
+        {
+            tracer_.record(TraceEvent::TRACE_THREAD_SPAWN, nullptr, static_cast<uint32_t>(item.first));
+            item.second->start(); // 真正的创建线程，并执行线程函数
+        }
+    }
+    ready.wait();
+    // cached模式：由监督线程负责增减线程
+    if (poolMode_ == PoolMode::MODE_CACHED)
     {
-        threads_[i]->start(); // 真正的创建线程，并执行线程函数
-        threadIdelSize_++;    // 记录初始空闲线程的数量
+        keepThreads_ = initThreadSize_;
+        supervisor_ = std::thread(&ThreadPool::supervisorHandler, this);
     }
 }
 
@@ -82,236 +263,1897 @@ void ThreadPool::start(size_t initThreadSize)
 // 给线程池提交任务，用户调用该接口，传入任务对象，生产任务
 Result ThreadPool::submitTask(std::shared_ptr<Task> sp)
 {
-    // 获取锁 任务提交过程可能是多线程的
-    std::unique_lock<std::mutex> lock(taskQueMtx_);
-    /*
-    满足1：线程的通信 等待任务队列有空余
-        wait 等待，直到满足条件。
-        写法1：
-        while(taskQue_.size()==taskQueMaxThreshHold_)
-        {
-            notFull_.wait(lock); // 阻塞状态
-        }
-        写法2：
-        notFull_.wait(lock,[&]()->bool{return taskQue_.size() <taskQueMaxThreshHold_;});
-    满足2：用户提交任务，最长不能阻塞超过1s，否则判断任务提交失败，返回
-        wait_for 最多等待一段时间 wait_until等待到一个时间点，且都有返回值。
-    */
-    if (!notFull_.wait_for(lock, std::chrono::seconds(1), [&]() -> bool
-                           { return taskQue_.size() < taskQueMaxThreshHold_; }))
-    {
-        // false，表示not_Full_等待1s钟，条件依然没有满足
-        std::cerr << "task queue is full, sumbit task failed." << std::endl;
-        // return task->getResult(); // 不允许的操作，因为线程函数执行完任务，任务就被析构了
-
-        /* 
-        返回值优化 (RVO)：编译器可以构造返回值直接在接收对象的内存位置，而不是在函数内部构造然后移动或拷贝到外部。由于 C++17 的保证拷贝省略，编译器直接在调用者期望的位置构造这个对象，而不是先在函数内构造然后通过移动构造函数移动到调用者那里。这意味着即使你定义了移动构造函数，它也可能不会被调用。 
-        C++11，需要禁用拷贝构造，重写移动构造。
-        */
-        return Result(sp, false);
-    }
+    return submitTask(std::move(sp), submitPolicy_);
+}
 
-    // 如果有空余，把任务放入任务队列中
-    taskQue_.emplace(sp);
-    taskSize_++;
+// 尝试提交任务，任务队列满时立即失败
+Result ThreadPool::trySubmitTask(std::shared_ptr<Task> sp)
+{
+    return submitTask(std::move(sp), SubmitPolicy::POLICY_FAIL_FAST);
+}
 
-    // 因为放了新任务，任务队列不为空，在notEmpty_上通知，赶快分配执行任务。
-    notEmpty_.notify_all();
+// 按照优先级提交任务
+Result ThreadPool::submitTask(std::shared_ptr<Task> sp, Priority priority)
+{
+    Result result(sp);
+    if (!enqueueTask(sp, submitPolicy_, priority))
+    {
+        result.isValid_ = false;
+    }
+    return result;
+}
 
-    /* 需要根据任务数量和空闲线程的数量，判断是否需要创建新的线程出来
-        cached模式 任务处理比较紧急 场景：小而快的任务*/
-    if (poolMode_ == PoolMode::MODE_CACHED && taskSize_ > threadIdelSize_ && curThreadSize_ < threadSizeThreshHold_)
+// 提交到指定的NUMA节点
+Result ThreadPool::submitTaskToNode(std::shared_ptr<Task> sp, size_t node)
+{
+    Result result(sp);
+    if (!enqueueNodeTask(sp, node))
     {
-        std::cout << ">>> create new thread..." << std::endl;
-        // 创建新的线程对象
-        // auto ptr = std::make_unique<Thread>(std::bind(&ThreadPool::threadHandler, this, std::placeholders::_1)); // C++14
-        std::unique_ptr<Thread> ptr(new Thread(std::bind(&ThreadPool::threadHandler, this, std::placeholders::_1)));
+        result.isValid_ = false;
+    }
+    return result;
+}
 
+// 给线程池提交任务，指定本次提交在任务队列满时的策略
+Result ThreadPool::submitTask(std::shared_ptr<Task> sp, SubmitPolicy policy)
+{
+    /*
+    先绑定Result再入队，避免任务被线程取走执行时Result还未绑定。
+    只有一个具名返回对象，编译器可以直接在调用者处构造（NRVO），不会调用移动构造。
+    */
+    Result result(sp);
+    if (!enqueueTask(sp, policy))
+    {
+        result.isValid_ = false; // 提交失败，get()不会阻塞
+    }
+    // 返回任务的Result对象
+    return result;
+}
 
+// 把任务放入任务队列，按照policy处理队列已满的情况，提交失败返回false
+bool ThreadPool::enqueueTask(std::shared_ptr<Task> sp, SubmitPolicy policy, Priority priority)
+{
+    // 入队之前记录，工作线程取出任务时一定能看到
+    int64_t now = steadyNowNs();
+    stampTask(*sp, priority, now);
+    return enqueueSlot(QueuedTask(std::move(sp), now, priority), policy);
+}
 
+// post的可调用对象直接放入槽位，没有任务对象
+bool ThreadPool::enqueueFunc(UniqueFunction<void()> func)
+{
+    int64_t now = steadyNowNs();
+    QueuedTask slot(std::move(func), now);
+    tracer_.record(TraceEvent::TRACE_SUBMIT, slot.traceId(), 0, now);
+    return enqueueSlot(std::move(slot), submitPolicy_);
+}
 
-        size_t threadId = ptr->getId();
-        threads_.emplace(threadId, std::move(ptr));
-        // 启动新增的线程
-        threads_[threadId]->start();
-        // 修改线程个数相关的变量
-        curThreadSize_++;
-        threadIdelSize_++;
+// 放入任务队列并统计
+bool ThreadPool::enqueueSlot(QueuedTask slot, SubmitPolicy policy)
+{
+    if (isShutdown_ ? pushAfterShutdown(slot, policy) : pushTask(std::move(slot), policy))
+    {
+        submittedCount_.add();
+        checkStranded();
+        return true;
     }
-
-    // 返回任务的Result对象
-    std::cout << "succseeful submition !" << std::endl;
-    return Result(sp); // 调用右值拷贝
+    rejectedCount_.add();
+    return false;
 }
 
-// 定义线程函数
-void ThreadPool::threadHandler(size_t threadid)
+// enqueueSlot的实现
+bool ThreadPool::pushTask(QueuedTask slot, SubmitPolicy policy)
 {
-    auto lastTime = std::chrono::high_resolution_clock().now();
-    // 所有任务必须执行完成，线程池才可以回收所有线程资源
-    for (;;)
+    size_t level = static_cast<size_t>(slot.priority);
+    bool normal = slot.priority == Priority::PRIORITY_NORMAL;
+    // 工作窃取模式：池内线程提交的普通任务直接放入自己的本地队列，无需加锁
+    if (poolMode_ == PoolMode::MODE_WORK_STEALING && tlsPool == this && normal)
     {
-        std::shared_ptr<Task> task; // 延长task的生命周期
-        {
-
-            /*先获取锁（线程会发生死锁，和析构的主线程争夺同一把锁）
-            线程池析构时：
-            1.如主线程先获得锁，进入wait状态，释放锁；由于线程没有任务，也会进入wait状态，此时就没有线程进行notify
-            2.线程池线程先获得锁
-             */
-            std::unique_lock<std::mutex> lock(taskQueMtx_);
+        pushLocalTask(std::move(slot));
+        return true;
+    }
+    // 环形缓冲区模式：普通任务的生产者快速路径不加锁，高/低优先级的任务放入多级队列
+    if (ringQue_ != nullptr && normal)
+    {
+        return enqueueRingTask(slot, policy);
+    }
 
-            std::cout << "tid: " << std::this_thread::get_id() << " try to get the task ..." << std::endl;
-            // cached模式下，有可能已经创建了很多的线程，但是空闲时间超过60s，应该回收多余的线程。
-            // 当前时间-上次线程执行时间
-            // 任务队列为空
-            while (taskQue_.size() == 0)
+    // 获取锁 任务提交过程可能是多线程的
+    std::unique_lock<std::mutex> lock(taskQueMtx_);
+    std::vector<QueuedTask> dropped; // POLICY_DROP_OLDEST丢弃的任务，释放锁后再通知其结果（可调用对象的析构也在锁外）
+    if (taskQue_.size() >= taskQueMaxThreshHold_)
+    {
+        switch (policy)
+        {
+        case SubmitPolicy::POLICY_FAIL_FAST:
+            return false;
+        case SubmitPolicy::POLICY_CALLER_RUNS:
+            // 在提交者线程中直接执行，执行期间不持有锁
+            lock.unlock();
+            runInline(slot);
+            return true;
+        case SubmitPolicy::POLICY_DROP_OLDEST:
+            // 先丢弃优先级最低的任务
+            while (taskQue_.size() >= taskQueMaxThreshHold_ && !taskQue_.empty())
             {
-                // 线程池结束
-                if (!isPoolRunning_)
-                {
-                    threads_.erase(threadid); // 自己生成的线程id
-                    std::cout << "threadid: " << std::this_thread::get_id() << " exit!" << std::endl;
-                    exitCond_.notify_all(); // 通知主线程
-                    return;
-                }
-                // MODE_CACHED模式：开始回收空闲线程
-                if (poolMode_ == PoolMode::MODE_CACHED)
-                {
-                   
-                    /*
-                    等待任务，超时返回，
-                    这种等待策略允许线程在等待新任务到来时不会永久阻塞，
-                    特别是对于需要定期检查某些条件（比如是否需要结束线程或回收空闲线程）的场景非常有用。
-                    */ 
-                    if (std::cv_status::timeout == notEmpty_.wait_for(lock, std::chrono::seconds(1)))
-                    {
-                        auto now = std::chrono::high_resolution_clock().now();
-                        auto dur = std::chrono::duration_cast<std::chrono::seconds>(now - lastTime);
-                        if (dur.count() >= THREAD_IDLE_TIME && curThreadSize_ > initThreadSize_) // 
-                        {
-                            // 把线程对象从线程列表容器中删除
-                            threads_.erase(threadid); // 自己生成的线程id
-                            // 记录线程数量的相关变量的值修改
-                            curThreadSize_--;
-                            threadIdelSize_--;
-                            std::cout << "空闲线程："
-                                      << "threadid: " << std::this_thread::get_id() << " exit!" << std::endl;
-                            return;
-                        }
-                    }
-                }
-                else
+                QueuedTask oldest;
+                levelSize_[taskQue_.popLowest(oldest)]--;
+                dropped.emplace_back(std::move(oldest));
+                taskSize_--;
+            }
+            droppedCount_.add(dropped.size());
+            break;
+        default:
+            /*
+            满足1：线程的通信 等待任务队列有空余
+                wait 等待，直到满足条件。
+                写法1：
+                while(taskQue_.size()==taskQueMaxThreshHold_)
                 {
-                    notEmpty_.wait(lock); // 最终问题点
+                    notFull_.wait(lock); // 阻塞状态
                 }
-                //  // 线程池关闭，回收线程资源
-                // if (!isPoolRunning_)
-                // {
-                //     std::cout<<"剩余线程："<<threads_.size()<<std::endl;
-                //     // 把线程对象从线程列表容器中删除
-                //     threads_.erase(threadid); // 自己生成的线程id
-                //     // 记录线程数量的相关变量的值修改
-                //     // curThreadSize_--;
-                //     // threadIdelSize_--;
-                //     std::cout << "threadid: " << std::this_thread::get_id() << " exit!" << std::endl;
-                //     exitCond_.notify_all(); // 通知主线程
-                //     return; // 结束线程函数，就是结束当前线程。
-                // }
-            }
-            // 任务队列不为空，执行任务
-            threadIdelSize_--;
-            std::cout << "tid: " << std::this_thread::get_id() << " got the task.." << std::endl;
-            // 从任务队列中取一个任务
-            task = taskQue_.front();
-            taskQue_.pop();
-            taskSize_--;
-
-            // 如果依然有剩余任务，继续通知其他线程执行任务
-            if (taskQue_.size() > 0)
+                写法2：
+                notFull_.wait(lock,[&]()->bool{return taskQue_.size() <taskQueMaxThreshHold_;});
+            满足2：用户提交任务，最长不能阻塞超过submitTimeout_，否则判断任务提交失败，返回
+                wait_for 最多等待一段时间 wait_until等待到一个时间点，且都有返回值。
+            */
+            producerWaitSize_++; // 出队的线程只在有提交者等待时才通知notFull_
+            tracer_.record(TraceEvent::TRACE_SUBMIT_BLOCKED, slot.traceId());
+            bool hasSpace = notFull_.wait_for(lock, submitTimeout_, [&]() -> bool
+                                              { return taskQue_.size() < taskQueMaxThreshHold_; });
+            tracer_.record(TraceEvent::TRACE_SUBMIT_RESUMED, slot.traceId());
+            producerWaitSize_--;
+            if (!hasSpace)
             {
-                notEmpty_.notify_all();
+                // false，表示not_Full_等待submitTimeout_，条件依然没有满足
+                lock.unlock();
+                FLEXIPOOL_LOG_WARN("task queue is full, submit task failed.");
+                // return task->getResult(); // 不允许的操作，因为线程函数执行完任务，任务就被析构了
+                return false;
             }
-            // 取出一个任务，进行通知，任务队列不为满，可以继续提交生产任务
-            notFull_.notify_all();
-        } // 让锁释放
+            break;
+        }
+    }
 
-        // 当前线程负责执行这个任务，不能等任务执行完才释放锁
-        if (task != nullptr)
-        {
-            // task->run();
-            //  执行任务，并把任务的返回值给setVal
+    // 如果有空余，把任务放入对应优先级的队列中
+    int64_t submitTime = slot.submitTime;
+    taskQue_.push(std::move(slot), level, submitTime);
+    levelSize_[level]++;
+    taskSize_++;
 
-            task->exec();
-        }
-        // 任务执行完毕
-        threadIdelSize_++;
-        lastTime = std::chrono::high_resolution_clock().now(); // 更新线程执行完任务的时间
+    /* 需要根据任务数量和空闲线程的数量，判断是否需要创建新的线程出来
+        cached模式 任务处理比较紧急 场景：小而快的任务*/
+    lock.unlock();
+    requestThreads(); // 线程在监督线程中创建，不在提交者的临界区中
+    FLEXIPOOL_LOG_TRACE("task submitted.");
+
+    // 因为放了新任务，任务队列不为空，只唤醒一个最近空闲的线程，赶快分配执行任务。
+    notifyWorker();
+    for (auto &oldest : dropped)
+    {
+        discardSlot(oldest);
     }
+    return true;
 }
-bool ThreadPool::checkRunningState() const
+
+// 延迟delay之后提交任务
+Result ThreadPool::submitTaskAfter(std::chrono::steady_clock::duration delay, std::shared_ptr<Task> sp)
 {
-    return isPoolRunning_;
+    return submitTaskAt(std::chrono::steady_clock::now() + delay, std::move(sp));
 }
-////////////////////////////////////// 线程方法实现
-// 线程构造函数
-size_t Thread::generateId_ = 0;
-Thread::Thread(ThreadFunc func)
-    : func_(func), threadId_(generateId_++)
+
+// 在when时刻提交任务
+Result ThreadPool::submitTaskAt(std::chrono::steady_clock::time_point when, std::shared_ptr<Task> sp)
 {
+    Result result(sp);
+    if (!scheduleTask(sp, when))
+    {
+        result.isValid_ = false;
+    }
+    return result;
 }
 
-// 线程析构函数
-Thread::~Thread(){};
+// 周期任务：每次执行是一个新的任务对象，共享计划和取消令牌。
+// 本次的任务对象还在runTask中使用（holdsSlot_、priority_、跟踪事件），不能在执行完之前重新放入定时队列
+class ThreadPool::PeriodicTask : public Task
+{
+public:
+    struct Schedule
+    {
+        Schedule(std::chrono::steady_clock::duration period, UniqueFunction<void()> func, std::chrono::steady_clock::time_point due)
+            : period(period), func(std::move(func)), due(due) {}
+        std::chrono::steady_clock::duration period;
+        UniqueFunction<void()> func;
+        std::chrono::steady_clock::time_point due; // 下一次执行的计划时间，同一时刻只有一个任务对象访问
+        CancellationToken token;
+    };
 
-// 启动线程
-void Thread::start()
+    explicit PeriodicTask(std::shared_ptr<Schedule> schedule) : schedule_(std::move(schedule))
+    {
+        setCancellationToken(schedule_->token);
+    }
+    Any run()
+    {
+        try
+        {
+            schedule_->func();
+        }
+        catch (const std::exception &e)
+        {
+            FLEXIPOOL_LOG_ERROR("periodic task threw an exception: %s", e.what());
+        }
+        catch (...)
+        {
+            FLEXIPOOL_LOG_ERROR("periodic task threw an unknown exception.");
+        }
+        // 落后时从现在开始重新计算，不补执行错过的次数
+        schedule_->due += schedule_->period;
+        std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        if (schedule_->due < now)
+        {
+            schedule_->due = now;
+        }
+        if (!isCancelled())
+        {
+            pool()->scheduleTask(makeTask<PeriodicTask>(schedule_), schedule_->due);
+        }
+        return Any();
+    }
+
+private:
+    std::shared_ptr<Schedule> schedule_;
+};
+
+// 周期任务
+CancellationToken ThreadPool::scheduleEvery(std::chrono::steady_clock::duration period, UniqueFunction<void()> func)
 {
-    /*  创建一个线程来执行线程函数 线程池的所有线程从任务队列里面消费任务
-      线程对象t 线程函数func_(C++11)pthread_detach(Linux) */
-    std::thread t(func_, threadId_);
+    std::chrono::steady_clock::time_point first = std::chrono::steady_clock::now() + period;
+    std::shared_ptr<PeriodicTask::Schedule> schedule =
+        std::make_shared<PeriodicTask::Schedule>(std::max(period, std::chrono::steady_clock::duration(1)), std::move(func), first);
+    CancellationToken token = schedule->token;
+    if (!scheduleTask(makeTask<PeriodicTask>(std::move(schedule)), first))
+    {
+        token.cancel();
+    }
+    return token;
+}
 
-    /*  出了作用域线程对象会析构，为了保护线程线程函数，需要设置为分离线程 pthread_detach (Linux) 如果需要回收线程的pcb需要主线程执行join */
-    t.detach();
+// 把任务放入定时队列
+bool ThreadPool::scheduleTask(std::shared_ptr<Task> sp, std::chrono::steady_clock::time_point when)
+{
+    sp->pool_ = this; // 到期之前注册的then也放入这个线程池
+    int64_t due = toSteadyNs(when);
+    if (isShutdown_ || !timers_.add(due, std::move(sp)))
+    {
+        FLEXIPOOL_LOG_WARN("thread pool has been shut down, submit task failed.");
+        return false;
+    }
+    return true;
 }
 
-// 获取线程Id
-size_t Thread::getId() const
+// 定时线程：一批到期的任务只进入一次临界区
+void ThreadPool::fireTimers(std::vector<std::shared_ptr<Task>> &tasks)
 {
-    return threadId_;
+    size_t accepted = enqueueBatch(tasks);
+    for (size_t i = accepted; i < tasks.size(); i++)
+    {
+        if (!enqueueTask(tasks[i], submitPolicy_))
+        {
+            tasks[i]->discard(); // 提交者已经拿到了Result，不能让它永久阻塞
+        }
+    }
 }
-///////////////////////////////////////// Task方法的实现
-Task::Task()
-    : result_(nullptr)
+
+// 把任务放入指定节点的任务队列，提交失败返回false
+bool ThreadPool::enqueueNodeTask(std::shared_ptr<Task> sp, size_t node)
+{
+    if (nodeShards_.empty())
+    {
+        return enqueueTask(std::move(sp), submitPolicy_);
+    }
+    int64_t now = steadyNowNs();
+    sp->submitTime_ = now;
+    sp->priority_ = Priority::PRIORITY_NORMAL;
+    sp->holdsSlot_ = false;
+    sp->pool_ = this;
+    QueuedTask slot(std::move(sp), now, Priority::PRIORITY_NORMAL);
+    if (isShutdown_ ? pushAfterShutdown(slot, submitPolicy_) : pushNodeTask(std::move(slot), node % nodeShards_.size()))
+    {
+        submittedCount_.add();
+        checkStranded();
+        return true;
+    }
+    rejectedCount_.add();
+    return false;
+}
+
+// enqueueNodeTask的实现：节点队列不区分优先级，也不受并发上限限制
+bool ThreadPool::pushNodeTask(QueuedTask slot, size_t node)
 {
+    NodeShard &shard = *nodeShards_[node];
+    std::unique_lock<std::mutex> lock(shard.mtx);
+    if (shard.que.size() >= taskQueMaxThreshHold_)
+    {
+        lock.unlock();
+        if (submitPolicy_ != SubmitPolicy::POLICY_CALLER_RUNS)
+        {
+            FLEXIPOOL_LOG_WARN("node task queue is full, submit task failed.");
+            return false;
+        }
+        runInline(slot);
+        return true;
+    }
+    // 先增加计数再入队，保证出队后减计数时不会下溢
+    taskSize_++;
+    nodeTaskSize_++;
+    shard.que.push_back(std::move(slot));
+    lock.unlock();
+
+    wakeNodeWorker(node);
+    requestThreads();
+    return true;
 }
 
-void Task::exec()
+// 从指定节点的任务队列取一个任务
+bool ThreadPool::popNodeTask(size_t node, QueuedTask &slot)
 {
-    if (result_ != nullptr) // 增加安全性
+    NodeShard &shard = *nodeShards_[node];
+    std::lock_guard<std::mutex> lock(shard.mtx);
+    if (shard.que.empty())
     {
-        result_->setVal(run()); // 这里发生多态
+        return false;
     }
+    slot = std::move(shard.que.front());
+    shard.que.pop_front();
+    nodeTaskSize_--;
+    taskSize_--;
+    return true;
 }
 
-void Task::setResult(Result *res)
+// 本节点没有任务时，依次从后面的节点取（远端内存访问比线程空闲的代价小）
+bool ThreadPool::popRemoteNodeTask(size_t node, QueuedTask &slot)
 {
-    result_ = res;
+    size_t n = nodeShards_.size();
+    for (size_t i = 1; i < n; i++)
+    {
+        if (popNodeTask((node + i) % n, slot))
+        {
+            return true;
+        }
+    }
+    return false;
 }
 
-///////////////////////////////////// Result方法的实现
-Result::Result(Result &&other) : task_(std::move(other.task_)),  // 移动 shared_ptr
-                                 isValid_(other.isValid_.load()) // 复制 atomic_bool 的值
+// 普通模式的线程取任务：本节点队列、任务队列、其他节点队列
+bool ThreadPool::fetchTask(QueuedTask &slot)
 {
-    // other 对象的状态已被修改，因此可以显式地设置它的成员变量
-    // 对于 std::atomic_bool，这不是必需的，但可以显式地设置为默认值
-    other.isValid_ = false;
+    if (nodeTaskSize_ > 0 && popNodeTask(tlsWorkerNode, slot))
+    {
+        return true;
+    }
+    if (popQueTask(slot))
+    {
+        return true;
+    }
+    return nodeTaskSize_ > 0 && popRemoteNodeTask(tlsWorkerNode, slot);
 }
 
-Result::Result(std::shared_ptr<Task> task, bool isValid)
-    : task_(task), isValid_(isValid)
+// 第slot个工作线程所在的节点：线程依次分配到各个节点
+size_t ThreadPool::slotNode(size_t slot) const
 {
-    task_->setResult(this); // 构造时，把当前的Result对象绑定给task_对象
+    return slot % nodeCount();
+}
+
+// 工作线程启动时设置CPU亲和性（之后本线程首次访问的内存由操作系统分配在本节点）
+void ThreadPool::placeWorker(size_t slot)
+{
+    size_t node = slotNode(slot);
+    tlsWorkerNode = node;
+    if (affinityMode_ == AffinityMode::AFFINITY_NONE)
+    {
+        return;
+    }
+    const std::vector<int> &cpus = topology_.nodeCpus(node);
+    if (cpus.empty())
+    {
+        // sched_getaffinity失败时detect()返回一个没有CPU的节点：不绑定，也不能对0取模
+        FLEXIPOOL_LOG_WARN("no CPUs known for node %zu, worker %zu is not pinned.", node, slot);
+        return;
+    }
+    bool pinned = false;
+    if (affinityMode_ == AffinityMode::AFFINITY_CORE)
+    {
+        // 同一节点的线程依次使用节点内的CPU，线程多于CPU时循环使用
+        int cpu = cpus[(slot / nodeCount()) % cpus.size()];
+        pinned = CpuTopology::pinCurrentThread(std::vector<int>(1, cpu));
+    }
+    else
+    {
+        pinned = CpuTopology::pinCurrentThread(cpus);
+    }
+    if (!pinned)
+    {
+        FLEXIPOOL_LOG_WARN("failed to set the affinity of worker %zu on node %zu.", slot, node);
+    }
+}
+
+// 依赖已经全部完成的后续任务：放入任务队列，队列满时在当前线程执行
+void ThreadPool::scheduleContinuation(ThreadPool *pool, std::shared_ptr<Task> task)
+{
+    if (pool == nullptr)
+    {
+        task->exec();
+        return;
+    }
+    pool->enqueueTask(std::move(task), SubmitPolicy::POLICY_CALLER_RUNS);
+}
+
+// 环形缓冲区模式：无锁入队，队列已满时按照policy处理
+bool ThreadPool::enqueueRingTask(QueuedTask &slot, SubmitPolicy policy)
+{
+    if (!tryPushRing(slot))
+    {
+        switch (policy)
+        {
+        case SubmitPolicy::POLICY_FAIL_FAST:
+            return false;
+        case SubmitPolicy::POLICY_CALLER_RUNS:
+            runInline(slot);
+            return true;
+        case SubmitPolicy::POLICY_DROP_OLDEST:
+            // 出队失败（槽位已经被预留、还没有发布）时稍等重试，多次仍然放不进去就按照POLICY_BLOCK等待空位
+            for (size_t retry = 0; !tryPushRing(slot); retry++)
+            {
+                if (retry == RING_DROP_RETRIES)
+                {
+                    if (!waitRingSpace(slot))
+                    {
+                        FLEXIPOOL_LOG_WARN("task queue is full, submit task failed.");
+                        return false;
+                    }
+                    break;
+                }
+                QueuedTask oldest;
+                if (popRingTask(oldest))
+                {
+                    droppedCount_.add();
+                    discardSlot(oldest);
+                }
+                else
+                {
+                    cpuRelax();
+                }
+            }
+            break;
+        default:
+            if (!waitRingSpace(slot))
+            {
+                FLEXIPOOL_LOG_WARN("task queue is full, submit task failed.");
+                return false;
+            }
+            break;
+        }
+    }
+
+    notifyWorker();
+    requestThreads();
+    return true;
+}
+
+// 环形缓冲区模式：尝试入队一次
+bool ThreadPool::tryPushRing(QueuedTask &slot)
+{
+    // 先增加任务计数再入队，保证消费者出队后减计数时不会下溢
+    taskSize_++;
+    levelSize_[static_cast<size_t>(Priority::PRIORITY_NORMAL)]++;
+    if (ringQue_->push(std::move(slot)))
+    {
+        return true;
+    }
+    levelSize_[static_cast<size_t>(Priority::PRIORITY_NORMAL)]--;
+    taskSize_--;
+    return false;
+}
+
+// 环形缓冲区模式：阻塞等待队列有空余入队，超时返回false
+bool ThreadPool::waitRingSpace(QueuedTask &slot)
+{
+    auto deadline = std::chrono::steady_clock::now() + submitTimeout_;
+    std::unique_lock<std::mutex> lock(taskQueMtx_);
+    // 先登记等待，再检查队列是否已满，保证出队的线程能看到有提交者在等待
+    producerWaitSize_++;
+    // 入队成功之后slot已经被移动走，先取出id
+    const void *traceId = slot.traceId();
+    tracer_.record(TraceEvent::TRACE_SUBMIT_BLOCKED, traceId);
+    bool pushed = false;
+    while (!(pushed = tryPushRing(slot)))
+    {
+        if (!notFull_.wait_until(lock, deadline, [&]() -> bool
+                                 { return !ringQue_->full(); }))
+        {
+            break;
+        }
+    }
+    tracer_.record(TraceEvent::TRACE_SUBMIT_RESUMED, traceId);
+    producerWaitSize_--;
+    return pushed;
+}
+
+// 环形缓冲区模式：无锁出队
+bool ThreadPool::popRingTask(QueuedTask &slot)
+{
+    if (!ringQue_->pop(slot))
+    {
+        return false;
+    }
+    levelSize_[static_cast<size_t>(Priority::PRIORITY_NORMAL)]--;
+    taskSize_--;
+    return true;
+}
+
+// 从任务队列取一个任务，队列为空返回false
+bool ThreadPool::popQueTask(QueuedTask &slot)
+{
+    if (ringQue_ != nullptr)
+    {
+        const size_t normal = static_cast<size_t>(Priority::PRIORITY_NORMAL);
+        if (levelSize_[static_cast<size_t>(Priority::PRIORITY_HIGH)] == 0 && levelSize_[static_cast<size_t>(Priority::PRIORITY_LOW)] == 0)
+        {
+            // 只有普通任务：无锁出队
+            if (!tryAcquireSlot(normal))
+                return false;
+            if (!popRingTask(slot))
+            {
+                if (capsEnabled_)
+                    levelRunning_[normal]--;
+                return false;
+            }
+            slot.holdsSlot = capsEnabled_;
+        }
+        else
+        {
+            std::lock_guard<std::mutex> lock(taskQueMtx_);
+            if (!popLevelTask(slot))
+                return false;
+        }
+        // 取出一个任务，如果有提交者在等待队列空余，通知它
+        if (producerWaitSize_ > 0)
+        {
+            std::lock_guard<std::mutex> lock(taskQueMtx_);
+            notFull_.notify_one();
+        }
+        return true;
+    }
+    std::lock_guard<std::mutex> lock(taskQueMtx_);
+    if (!popLevelTask(slot))
+    {
+        return false;
+    }
+    // 取出一个任务，任务队列不为满，只在有提交者等待时通知一个
+    if (producerWaitSize_ > 0)
+    {
+        notFull_.notify_one();
+    }
+    return true;
+}
+
+/*
+按照有效优先级取一个任务，需要持有taskQueMtx_
+- 有效优先级 = 原优先级 - 排队时间/agingTime_，相同时取排队时间长的
+- 达到并发上限的优先级不参与选择
+- 环形缓冲区中的普通任务无法查看排队时间，按照不老化处理
+*/
+bool ThreadPool::popLevelTask(QueuedTask &slot)
+{
+    const size_t normal = static_cast<size_t>(Priority::PRIORITY_NORMAL);
+    // 常见情况：只有一个优先级有任务，不需要读取时钟
+    size_t only = taskQue_.onlyLevel();
+    if (only != PRIORITY_LEVELS && ringQue_ == nullptr && tryAcquireSlot(only))
+    {
+        taskQue_.pop(only, slot);
+        levelSize_[only]--;
+        taskSize_--;
+        slot.holdsSlot = capsEnabled_;
+        return true;
+    }
+    int64_t now = steadyNowNs();
+    int64_t agingNs = std::chrono::duration_cast<std::chrono::nanoseconds>(agingTime_).count();
+    bool allowed[PRIORITY_LEVELS];
+    for (size_t i = 0; i < PRIORITY_LEVELS; i++)
+    {
+        allowed[i] = !capsEnabled_ || levelRunning_[i] < levelCap_[i];
+    }
+    bool ringAvailable = ringQue_ != nullptr && allowed[normal] && levelSize_[normal] > 0;
+    for (;;)
+    {
+        size_t effective = 0;
+        size_t level = taskQue_.select(now, agingNs, allowed, effective);
+        if (ringAvailable && (level == PRIORITY_LEVELS || effective > normal || (effective == normal && level > normal)))
+        {
+            if (tryAcquireSlot(normal))
+            {
+                if (popRingTask(slot))
+                {
+                    slot.holdsSlot = capsEnabled_;
+                    return true;
+                }
+                if (capsEnabled_)
+                    levelRunning_[normal]--;
+            }
+            ringAvailable = false;
+            continue;
+        }
+        if (level == PRIORITY_LEVELS)
+        {
+            return false;
+        }
+        if (!tryAcquireSlot(level))
+        {
+            allowed[level] = false;
+            continue;
+        }
+        taskQue_.pop(level, slot);
+        levelSize_[level]--;
+        taskSize_--;
+        slot.holdsSlot = capsEnabled_;
+        return true;
+    }
+}
+
+// 是否有可以立即执行的任务（排除已经达到并发上限的优先级）
+bool ThreadPool::hasRunnableTask() const
+{
+    if (!capsEnabled_)
+    {
+        return taskSize_ > 0;
+    }
+    size_t queued = 0;
+    for (size_t i = 0; i < PRIORITY_LEVELS; i++)
+    {
+        size_t n = levelSize_[i];
+        queued += n;
+        if (n > 0 && levelRunning_[i] < levelCap_[i])
+            return true;
+    }
+    // 其余的任务在工作窃取模式的本地队列中，不受并发上限限制
+    return taskSize_ > queued;
+}
+
+// 占用一个优先级的并发名额，没有设置上限时总是成功
+bool ThreadPool::tryAcquireSlot(size_t level)
+{
+    if (!capsEnabled_)
+    {
+        return true;
+    }
+    size_t running = levelRunning_[level];
+    while (running < levelCap_[level])
+    {
+        if (levelRunning_[level].compare_exchange_weak(running, running + 1))
+            return true;
+    }
+    return false;
+}
+
+// 归还一个优先级的并发名额
+void ThreadPool::releaseSlot(size_t level)
+{
+    levelRunning_[level]--;
+    // 与waitForTask中先登记到空闲栈、再检查hasRunnableTask()配对：被名额挡住的任务现在可以执行了
+    if (levelSize_[level] > 0)
+    {
+        notifyWorker();
+    }
+}
+
+// cached模式：任务数量多于空闲线程时通知监督线程，已经通知过还没有处理时不再通知
+void ThreadPool::requestThreads()
+{
+    if (poolMode_ == PoolMode::MODE_CACHED && taskSize_ > idleThreadCount() && curThreadSize_ < threadSizeThreshHold_ && !spawnRequested_.exchange(true))
+    {
+        std::lock_guard<std::mutex> lock(supervisorMtx_);
+        supervisorCond_.notify_one();
+    }
+}
+
+/*
+cached模式的监督线程
+- 每个采样周期从统计中取得到达数量、排队时间和执行时间的增量，交给弹性控制器计算目标线程数
+- 线程数少于目标时提前创建；有提交者通知时立即处理积压的任务
+- 目标线程数作为空闲线程退出的下限，回收的节奏由控制器的滞回决定
+*/
+void ThreadPool::supervisorHandler()
+{
+    Tracer::setThreadName("supervisor");
+    ElasticController controller(initThreadSize_, threadSizeThreshHold_, threadIdleTimeout_);
+    PoolStats last = stats();
+    auto lastTime = std::chrono::steady_clock::now();
+    for (;;)
+    {
+        {
+            std::unique_lock<std::mutex> lock(supervisorMtx_);
+            supervisorCond_.wait_for(lock, elasticInterval_, [&]() -> bool
+                                     { return spawnRequested_ || !isPoolRunning_; });
+        }
+        if (!isPoolRunning_)
+        {
+            return;
+        }
+        joinExitedThreads(); // 回收空闲退出的线程
+        bool requested = spawnRequested_.exchange(false);
+        // 积压的任务：空闲线程处理不了的部分立即补足
+        size_t tasks = taskSize_;
+        size_t idle = idleThreadCount();
+        size_t want = tasks > idle ? curThreadSize_ + (tasks - idle) : 0;
+        auto now = std::chrono::steady_clock::now();
+        double elapsed = std::chrono::duration<double>(now - lastTime).count();
+        // 提交者的通知可能很频繁，采样仍然按照周期进行
+        if (!requested || elapsed * 1000 >= elasticInterval_.count())
+        {
+            PoolStats cur = stats();
+            ElasticSample sample;
+            sample.intervalSec = elapsed;
+            sample.arrived = cur.submitted - last.submitted;
+            sample.waitCount = cur.queueWait.count() - last.queueWait.count();
+            sample.waitSumNs = cur.queueWait.sum() - last.queueWait.sum();
+            sample.execCount = cur.execTime.count() - last.execTime.count();
+            sample.execSumNs = cur.execTime.sum() - last.execTime.sum();
+            sample.queued = cur.queueDepth;
+            sample.threads = cur.curThreads;
+            sample.idle = cur.idleThreads;
+            size_t target = controller.update(sample);
+            keepThreads_ = target;
+            want = std::max(want, target);
+            last = std::move(cur);
+            lastTime = now;
+        }
+        want = std::min(want, threadSizeThreshHold_);
+        size_t cur = curThreadSize_;
+        if (want > cur)
+        {
+            // 一次突发的积压不会立刻把线程创建到上限：新线程先分担任务，之后的采样再按照剩下的积压继续增长
+            spawnThreads(std::min(want - cur, std::max(cur, ELASTIC_GROWTH_MIN)));
+        }
+    }
+}
+
+// 创建并启动n个线程
+void ThreadPool::spawnThreads(size_t n)
+{
+    for (size_t i = 0; i < n; i++)
+    {
+        // 创建新的线程对象
+        // auto ptr = std::make_unique<Thread>(std::bind(&ThreadPool::threadHandler, this, std::placeholders::_1)); // C++14
+        std::unique_ptr<Thread> ptr(new Thread(std::bind(&ThreadPool::threadHandler, this, std::placeholders::_1)));
+        Thread *thread = ptr.get();
+        {
+            // 只有线程自己会把自己从threads_删除，启动之前对象一定存在
+            std::lock_guard<std::mutex> lock(taskQueMtx_);
+            threads_.emplace(thread->getId(), std::move(ptr));
+            // 修改线程个数相关的变量
+            curThreadSize_++;
+            threadsCreated_++;
+        }
+        // 启动新增的线程（系统调用在锁外）
+        tracer_.record(TraceEvent::TRACE_THREAD_SPAWN, nullptr, static_cast<uint32_t>(thread->getId()));
+        thread->start();
+        FLEXIPOOL_LOG_INFO(">>> create new thread...");
+    }
+}
+
+// 批量放入任务队列：一次临界区、一次唤醒，返回成功放入的任务数量（tasks的前缀）
+size_t ThreadPool::enqueueBatch(std::vector<std::shared_ptr<Task>> &tasks)
+{
+    size_t n = tasks.size();
+    if (n == 0)
+    {
+        return 0;
+    }
+    int64_t now = steadyNowNs();
+    for (auto &task : tasks)
+    {
+        stampTask(*task, Priority::PRIORITY_NORMAL, now);
+    }
+    // 关闭之后不批量放入，由调用者逐个提交
+    if (isShutdown_)
+    {
+        return 0;
+    }
+    std::vector<QueuedTask> slots;
+    slots.reserve(n);
+    for (auto &task : tasks)
+    {
+        slots.emplace_back(std::move(task), now, Priority::PRIORITY_NORMAL);
+    }
+    size_t accepted = pushBatch(slots);
+    // 没有放入的任务还给调用者逐个提交
+    for (size_t i = accepted; i < n; i++)
+    {
+        tasks[i] = std::move(slots[i].task);
+    }
+    submittedCount_.add(accepted);
+    checkStranded();
+    return accepted;
+}
+
+// enqueueBatch的实现
+size_t ThreadPool::pushBatch(std::vector<QueuedTask> &slots)
+{
+    size_t n = slots.size();
+    // 工作窃取模式：池内线程提交的任务全部放入自己的本地队列
+    if (poolMode_ == PoolMode::MODE_WORK_STEALING && tlsPool == this)
+    {
+        taskSize_ += n; // 先增加计数再入队，被窃取后减计数时不会下溢
+        for (auto &slot : slots)
+        {
+            workerQues_[tlsWorkerIndex]->push(newTaskBox(std::move(slot)));
+        }
+        wakeWorkers(n);
+        return n;
+    }
+    // 环形缓冲区模式：一次CAS预留所有能放下的槽位
+    if (ringQue_ != nullptr)
+    {
+        taskSize_ += n;
+        levelSize_[static_cast<size_t>(Priority::PRIORITY_NORMAL)] += n;
+        size_t accepted = ringQue_->pushBulk(slots.data(), n);
+        levelSize_[static_cast<size_t>(Priority::PRIORITY_NORMAL)] -= n - accepted;
+        taskSize_ -= n - accepted;
+        if (accepted == 0)
+        {
+            return 0;
+        }
+        wakeWorkers(accepted);
+        requestThreads();
+        return accepted;
+    }
+
+    // 只进入一次临界区，放入队列剩余空间能容纳的任务
+    std::unique_lock<std::mutex> lock(taskQueMtx_);
+    size_t space = taskQue_.size() < taskQueMaxThreshHold_ ? taskQueMaxThreshHold_ - taskQue_.size() : 0;
+    size_t accepted = std::min(n, space);
+    for (size_t i = 0; i < accepted; i++)
+    {
+        int64_t submitTime = slots[i].submitTime;
+        taskQue_.push(std::move(slots[i]), static_cast<size_t>(Priority::PRIORITY_NORMAL), submitTime);
+    }
+    levelSize_[static_cast<size_t>(Priority::PRIORITY_NORMAL)] += accepted;
+    taskSize_ += accepted;
+    lock.unlock();
+    wakeWorkers(accepted);
+    requestThreads(); // cached模式：监督线程按照任务数量一次性补足线程
+    return accepted;
+}
+
+// 唤醒一个最近空闲的线程（没有挂起的线程时不加锁）
+void ThreadPool::notifyWorker()
+{
+    // 与waitForTask中先登记到空闲栈、再检查hasRunnableTask()配对，保证不会丢失唤醒
+    if (threadWaitSize_ > 0)
+    {
+        wakeWorkers(1);
+    }
+}
+
+// 优先唤醒指定节点最近空闲的线程
+void ThreadPool::wakeNodeWorker(size_t node)
+{
+    if (threadWaitSize_ == 0)
+    {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(idleMtx_);
+    if (idleStack_.empty())
+    {
+        return;
+    }
+    size_t pick = idleStack_.size() - 1;
+    for (size_t i = idleStack_.size(); i-- > 0;)
+    {
+        if (idleStack_[i]->node_ == node)
+        {
+            pick = i;
+            break;
+        }
+    }
+    Parker *parker = idleStack_[pick];
+    idleStack_.erase(idleStack_.begin() + pick);
+    parker->inIdleStack_ = false;
+    threadWaitSize_--;
+    parker->unpark();
+}
+
+// 从空闲栈顶开始唤醒最多n个挂起的线程（后进先出，最近空闲的线程缓存最热）
+void ThreadPool::wakeWorkers(size_t n)
+{
+    std::lock_guard<std::mutex> lock(idleMtx_);
+    while (n > 0 && !idleStack_.empty())
+    {
+        Parker *parker = idleStack_.back();
+        idleStack_.pop_back();
+        parker->inIdleStack_ = false;
+        threadWaitSize_--;
+        // 持有idleMtx_时unpark，保证被唤醒的线程退出前unpark已经完成
+        parker->unpark();
+        n--;
+    }
+}
+
+/*
+等待新任务，timeout为0表示一直等待，返回false表示等待超时（cached模式用于回收线程）
+- IDLE_ADAPTIVE：自旋的时间是最近任务到达间隔滑动平均的两倍，间隔超过THREAD_SPIN_MAX_NS时只自旋
+  THREAD_SPIN_MIN_NS就挂起；挂起期间到达的任务同样计入间隔，间隔重新变短时会恢复自旋
+- IDLE_BLOCK：直接挂起
+- IDLE_SPIN_YIELD、IDLE_BUSY_SPIN：不挂起，不在空闲栈中，提交者不需要唤醒
+单核机器上自旋只会拖慢提交者，IDLE_ADAPTIVE直接挂起，IDLE_BUSY_SPIN每次检查后让出CPU
+*/
+bool ThreadPool::waitForTask(Parker &parker, IdleState &idle, std::chrono::milliseconds timeout)
+{
+    static const bool spinEnabled = std::thread::hardware_concurrency() > 1;
+    int64_t begin = steadyNowNs();
+    int64_t deadline = timeout.count() == 0 ? INT64_MAX : begin + std::chrono::duration_cast<std::chrono::nanoseconds>(timeout).count();
+    switch (idleStrategy_)
+    {
+    case IdleStrategy::IDLE_BLOCK:
+        return parkForTask(parker, timeout);
+    case IdleStrategy::IDLE_SPIN_YIELD:
+        return spinForTask(std::min(begin + THREAD_SPIN_YIELD_NS, deadline), !spinEnabled) || spinForTask(deadline, true);
+    case IdleStrategy::IDLE_BUSY_SPIN:
+        return spinForTask(deadline, !spinEnabled);
+    default:
+        break;
+    }
+    int64_t window = idle.gapNs > THREAD_SPIN_MAX_NS ? THREAD_SPIN_MIN_NS : std::max(2 * idle.gapNs, THREAD_SPIN_MIN_NS);
+    bool woken = (spinEnabled && spinForTask(begin + std::min(window, THREAD_SPIN_MAX_NS), false)) || parkForTask(parker, timeout);
+    if (woken)
+    {
+        // 滑动平均，最近的间隔占1/4；等待超时的线程即将退出或者继续等待，不计入
+        int64_t gap = steadyNowNs() - begin;
+        idle.gapNs = idle.gapNs == 0 ? gap : idle.gapNs + (gap - idle.gapNs) / 4;
+    }
+    return woken;
+}
+
+bool ThreadPool::spinForTask(int64_t until, bool yield)
+{
+    for (size_t i = 1;; i++)
+    {
+        if (hasRunnableTask() || !isPoolRunning_)
+        {
+            return true;
+        }
+        if (yield)
+            std::this_thread::yield();
+        else
+            cpuRelax();
+        // 每16次检查一次时间，取时间比一次pause贵得多
+        if ((i & 15) == 0 && steadyNowNs() >= until)
+        {
+            return false;
+        }
+    }
+}
+
+bool ThreadPool::parkForTask(Parker &parker, std::chrono::milliseconds timeout)
+{
+    // 1. 登记到空闲栈，再确认没有任务（提交者先增加taskSize_，再检查threadWaitSize_；归还并发名额同理）
+    {
+        std::lock_guard<std::mutex> lock(idleMtx_);
+        parker.inIdleStack_ = true;
+        idleStack_.push_back(&parker);
+        threadWaitSize_++;
+    }
+    if (hasRunnableTask() || !isPoolRunning_)
+    {
+        removeIdleWorker(parker);
+        return true;
+    }
+
+    // 2. 挂起，直到提交者unpark或者超时
+    tracer_.record(TraceEvent::TRACE_PARK, &parker);
+    if (timeout.count() == 0)
+    {
+        parker.park();
+        tracer_.record(TraceEvent::TRACE_UNPARK, &parker);
+        return true;
+    }
+    bool unparked = parker.parkFor(timeout);
+    tracer_.record(TraceEvent::TRACE_UNPARK, &parker);
+    if (unparked)
+    {
+        return true;
+    }
+    // 超时，但可能已经被提交者弹出并唤醒
+    return !removeIdleWorker(parker);
+}
+
+// 把线程从空闲栈中移除，返回false表示已经被提交者弹出，唤醒已经完成
+bool ThreadPool::removeIdleWorker(Parker &parker)
+{
+    std::lock_guard<std::mutex> lock(idleMtx_);
+    if (!parker.inIdleStack_)
+    {
+        parker.reset(); // 丢弃提交者留下的许可
+        return false;
+    }
+    idleStack_.erase(std::find(idleStack_.begin(), idleStack_.end(), &parker));
+    parker.inIdleStack_ = false;
+    threadWaitSize_--;
+    return true;
+}
+
+// 工作窃取模式：把任务放入当前线程的本地队列
+void ThreadPool::pushLocalTask(QueuedTask slot)
+{
+    taskSize_++; // 先增加计数再入队，被窃取后减计数时不会下溢
+    workerQues_[tlsWorkerIndex]->push(newTaskBox(std::move(slot)));
+    notifyWorker();
+}
+
+// 定义线程函数
+void ThreadPool::threadHandler(size_t threadid)
+{
+    tlsPool = this;
+    placeWorker(nextWorkerSlot_++); // 先绑定CPU，之后分配的计数器在本节点
+    registerWorkerStats(threadid);
+    Tracer::setThreadName("worker " + std::to_string(threadid));
+    auto lastTime = std::chrono::high_resolution_clock().now();
+    Parker parker;                       // 当前线程的停车位，线程函数返回前一定已经离开空闲栈
+    parker.node_ = tlsWorkerNode;
+    IdleState idle;                      // 最近任务到达的间隔，决定空闲时自旋多久
+    // 所有任务必须执行完成，线程池才可以回收所有线程资源
+    for (;;)
+    {
+        QueuedTask slot; // 延长任务的生命周期
+        FLEXIPOOL_LOG_TRACE("try to get the task ...");
+        // cached模式下，有可能已经创建了很多的线程，但是空闲时间超过60s，应该回收多余的线程。
+        // 当前时间-上次线程执行时间
+        // 任务队列为空
+        while (!fetchTask(slot))
+        {
+            // 环形缓冲区模式：任务刚被其他线程取走或者正在入队，重新尝试（达到并发上限的任务不算）
+            if (hasRunnableTask())
+            {
+                std::this_thread::yield(); // 让正在入队/出队的线程先完成
+                continue;
+            }
+            // 线程池结束
+            if (!isPoolRunning_)
+            {
+                /*
+                线程池析构时：主线程先把isPoolRunning_置为false再唤醒所有挂起的线程，
+                线程登记到空闲栈后会再检查一次isPoolRunning_，所以不会有线程永久挂起
+                */
+                FLEXIPOOL_LOG_INFO("thread exit!");
+                tracer_.releaseThread();
+                std::lock_guard<std::mutex> lock(taskQueMtx_);
+                retireWorkerStats();
+                retireThread(threadid); // 自己生成的线程id，通知主线程
+                return;
+            }
+            // MODE_CACHED模式：开始回收空闲线程
+            if (poolMode_ == PoolMode::MODE_CACHED)
+            {
+                /*
+                等待任务，超时返回，
+                这种等待策略允许线程在等待新任务到来时不会永久阻塞，
+                特别是对于需要定期检查某些条件（比如是否需要结束线程或回收空闲线程）的场景非常有用。
+                */
+                if (!waitForTask(parker, idle, threadIdleTimeout_))
+                {
+                    auto now = std::chrono::high_resolution_clock().now();
+                    auto dur = std::chrono::duration_cast<std::chrono::milliseconds>(now - lastTime);
+                    std::unique_lock<std::mutex> lock(taskQueMtx_);
+                    // 线程数量多于监督线程给出的下限时才退出，在锁中检查，多个线程不会同时退出到下限以下
+                    if (dur >= threadIdleTimeout_ && curThreadSize_ > keepThreads_)
+                    {
+                        // 把线程对象从线程列表容器中删除
+                        retireWorkerStats();
+                        retireThread(threadid); // 由监督线程join
+                        // 记录线程数量的相关变量的值修改
+                        curThreadSize_--;
+                        threadsReaped_++;
+                        lock.unlock();
+                        tracer_.record(TraceEvent::TRACE_THREAD_REAP, nullptr, static_cast<uint32_t>(threadid));
+                        tracer_.releaseThread();
+                        FLEXIPOOL_LOG_INFO("idle thread exit!");
+                        return;
+                    }
+                }
+            }
+            else
+            {
+                waitForTask(parker, idle, std::chrono::milliseconds(0));
+            }
+        }
+        // 任务队列不为空，执行任务
+        tracer_.record(TraceEvent::TRACE_DEQUEUE, slot.traceId());
+        busyThreads_.add();
+        FLEXIPOOL_LOG_TRACE("got the task..");
+
+        // 当前线程负责执行这个任务，取任务时持有的锁已经释放
+        // 执行任务，并把任务的返回值给setVal
+        runSlot(slot);
+        // 任务执行完毕
+        busyThreads_.sub();
+        lastTime = std::chrono::high_resolution_clock().now(); // 更新线程执行完任务的时间
+    }
+}
+
+// 工作窃取模式的线程函数
+void ThreadPool::stealingHandler(size_t threadid, size_t index, CountDownLatch *ready)
+{
+    tlsPool = this;
+    tlsWorkerIndex = index;
+    placeWorker(index);
+    workerQues_[index].reset(new TaskDeque()); // 绑定CPU之后创建，本地队列的内存在本节点
+    registerWorkerStats(threadid);
+    Tracer::setThreadName("worker " + std::to_string(threadid));
+    ready->countDown(); // 之后不能再访问ready，start可能已经返回
+    Parker parker;
+    parker.node_ = tlsWorkerNode;
+    IdleState idle;
+    for (;;)
+    {
+        QueuedTask slot;
+        if (!takeTask(index, slot))
+        {
+            // 还有任务但暂时没有取到（刚被其他线程取走，或者窃取竞争失败），重新尝试
+            if (hasRunnableTask())
+            {
+                std::this_thread::yield(); // 让正在入队/出队的线程先完成
+                continue;
+            }
+            // 线程池结束，并且所有队列中的任务都已经执行完
+            if (!isPoolRunning_)
+            {
+                tracer_.releaseThread();
+                std::lock_guard<std::mutex> lock(taskQueMtx_);
+                retireWorkerStats();
+                retireThread(threadid); // 通知主线程
+                return;
+            }
+            waitForTask(parker, idle, std::chrono::milliseconds(0));
+            continue;
+        }
+
+        tracer_.record(TraceEvent::TRACE_DEQUEUE, slot.traceId());
+        busyThreads_.add();
+        runSlot(slot);
+        busyThreads_.sub();
+    }
+}
+
+// 工作窃取模式：依次从本地队列、本节点队列、注入队列、同节点的线程、其他节点获取任务
+bool ThreadPool::takeTask(size_t index, QueuedTask &slot)
+{
+    QueuedTask *box = nullptr;
+    // 1. 本地队列的底部（最近提交的任务，缓存最热）
+    if (workerQues_[index]->pop(box))
+    {
+        openTaskBox(box, slot);
+        taskSize_--;
+        return true;
+    }
+    // 没有任何任务时不去争抢锁
+    if (taskSize_ == 0)
+    {
+        return false;
+    }
+    size_t node = workerNode_[index];
+    // 2. 提交到本节点的任务
+    if (nodeTaskSize_ > 0 && popNodeTask(node, slot))
+    {
+        return true;
+    }
+    // 3. 外部提交的注入队列
+    if (popQueTask(slot))
+    {
+        return true;
+    }
+    // 4. 窃取同节点线程的本地队列
+    if (stealFrom(nodeWorkers_[node], index, slot))
+    {
+        return true;
+    }
+    // 5. 其他节点：先取节点队列，再窃取其他节点线程的本地队列
+    size_t nodes = nodeWorkers_.size();
+    if (nodes == 1)
+    {
+        return false;
+    }
+    if (nodeTaskSize_ > 0 && popRemoteNodeTask(node, slot))
+    {
+        return true;
+    }
+    for (size_t i = 1; i < nodes; i++)
+    {
+        if (stealFrom(nodeWorkers_[(node + i) % nodes], index, slot))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+// 从victims中随机选择的线程开始，依次尝试窃取本地队列的顶部
+bool ThreadPool::stealFrom(const std::vector<size_t> &victims, size_t index, QueuedTask &slot)
+{
+    static thread_local uint32_t seed = 2463534242u + static_cast<uint32_t>(index);
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+    QueuedTask *box = nullptr;
+    size_t n = victims.size();
+    size_t start = n > 0 ? seed % n : 0;
+    for (size_t i = 0; i < n; i++)
+    {
+        size_t victim = victims[(start + i) % n];
+        if (victim == index)
+            continue;
+        if (workerQues_[victim]->steal(box))
+        {
+            openTaskBox(box, slot);
+            taskSize_--;
+            bumpCounter(tlsWorkerCounters->stolen);
+            tracer_.record(TraceEvent::TRACE_STEAL, slot.traceId(), static_cast<uint32_t>(victim));
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ThreadPool::helpOnce()
+{
+    QueuedTask slot;
+    // 工作窃取模式先取本地队列的底部：当前任务刚提交的子任务通常就是正在等待的任务
+    bool found = poolMode_ == PoolMode::MODE_WORK_STEALING ? takeTask(tlsWorkerIndex, slot) : fetchTask(slot);
+    if (!found)
+    {
+        return false;
+    }
+    tracer_.record(TraceEvent::TRACE_DEQUEUE, slot.traceId());
+    runSlot(slot); // 嵌套在外层任务中执行，忙碌/空闲时间由外层任务统计
+    return true;
+}
+
+/*
+执行一个任务，并记录排队时间、执行时间、忙碌/空闲时间（计数器只由本线程写入）
+body(start)执行任务，任务已经取消或者超过截止时间、没有执行时返回false
+*/
+template <typename Body>
+void ThreadPool::runMeasured(const void *traceId, int64_t submitTime, Priority priority, bool holdsSlot, Body body)
+{
+    // 线程池之外的线程（POLICY_CALLER_RUNS）没有自己的计数器，只统计完成数量
+    WorkerCounters *counters = tlsPool == this ? tlsWorkerCounters : nullptr;
+    int64_t start = steadyNowNs();
+    tracer_.record(TraceEvent::TRACE_START, traceId, 0, start); // TRACE_DEQUEUE由取出任务的地方记录
+    /*
+    任务中等待结果时执行的其他任务（helpOnce）或者POLICY_CALLER_RUNS在本线程执行的任务嵌套在外层任务之内：
+    空闲时间、忙碌时间和lastTransition只由最外层的任务更新，外层任务的执行时间减去嵌套执行的时间
+    */
+    uint32_t depth = 0;
+    int64_t nestedBefore = 0;
+    if (counters != nullptr)
+    {
+        depth = counters->depth++;
+        nestedBefore = counters->nestedNs;
+        counters->nestedNs = 0;
+        if (depth == 0)
+        {
+            bumpCounter(counters->idleNs, static_cast<uint64_t>(start - counters->lastTransition));
+        }
+        counters->queueWait.record(start > submitTime ? static_cast<uint64_t>(start - submitTime) : 0);
+    }
+    bool skipped = !body(start);
+    if (holdsSlot)
+    {
+        releaseSlot(static_cast<size_t>(priority));
+    }
+    int64_t end = steadyNowNs();
+    tracer_.record(TraceEvent::TRACE_END, traceId, 0, end);
+    if (counters == nullptr)
+    {
+        if (!skipped)
+            callerRunCount_.add();
+        return;
+    }
+    int64_t elapsed = end - start;
+    if (!skipped)
+    {
+        counters->execTime.record(static_cast<uint64_t>(std::max<int64_t>(elapsed - counters->nestedNs, 0)));
+        bumpCounter(counters->completed);
+    }
+    counters->depth--;
+    counters->nestedNs = nestedBefore + elapsed; // 对外层任务来说整个区间都是嵌套执行的时间
+    if (depth == 0)
+    {
+        bumpCounter(counters->busyNs, static_cast<uint64_t>(elapsed));
+        counters->lastTransition = end;
+        counters->nestedNs = 0;
+    }
+}
+
+void ThreadPool::runTask(Task &task)
+{
+    auto body = [&](int64_t start) -> bool
+    {
+        // 已经取消或者超过截止时间：不执行，直接完成结果
+        if (task.expired(start))
+        {
+            task.skip();
+            cancelledCount_++;
+            return false;
+        }
+        task.exec();
+        return true;
+    };
+    runMeasured(&task, task.submitTime_, task.priority_, task.holdsSlot_, body);
+}
+
+// post的可调用对象没有结果状态：抛出的异常被记录后忽略
+void ThreadPool::runSlot(QueuedTask &slot)
+{
+    if (slot.task != nullptr)
+    {
+        slot.task->holdsSlot_ = slot.holdsSlot;
+        runTask(*slot.task);
+        return;
+    }
+    auto body = [&](int64_t) -> bool
+    {
+        tlsPostedDepth++;
+        try
+        {
+            slot.func();
+        }
+        catch (const std::exception &e)
+        {
+            FLEXIPOOL_LOG_ERROR("posted task threw an exception: %s", e.what());
+        }
+        catch (...)
+        {
+            FLEXIPOOL_LOG_ERROR("posted task threw an unknown exception.");
+        }
+        tlsPostedDepth--;
+        return true;
+    };
+    runMeasured(slot.traceId(), slot.submitTime, slot.priority, slot.holdsSlot, body);
+}
+
+// POLICY_CALLER_RUNS：在当前线程执行，和工作线程一样检查取消和截止时间、占用优先级名额、记录统计和跟踪
+void ThreadPool::runInline(QueuedTask &slot)
+{
+    if (capsEnabled_)
+    {
+        // 不能拒绝执行：名额已经用完时暂时超过上限，执行期间同优先级排队的任务不会再占用名额
+        levelRunning_[static_cast<size_t>(slot.priority)]++;
+        slot.holdsSlot = true;
+    }
+    tracer_.record(TraceEvent::TRACE_DEQUEUE, slot.traceId()); // 没有进入队列，提交之后直接取出
+    runSlot(slot);
+}
+
+void ThreadPool::discardSlot(QueuedTask &slot)
+{
+    if (slot.task != nullptr)
+    {
+        slot.task->discard();
+    }
+    slot.func = nullptr;
+}
+
+void ThreadPool::stampTask(Task &task, Priority priority, int64_t now)
+{
+    task.submitTime_ = now;
+    task.priority_ = priority;
+    task.holdsSlot_ = false;
+    task.pool_ = this;
+    tracer_.record(TraceEvent::TRACE_SUBMIT, &task, 0, now);
+}
+
+// Strand、ExecutorGroup的任务在它们的内部任务中执行，嵌套在内部任务之内统计
+void ThreadPool::runDequeued(Task &task)
+{
+    tracer_.record(TraceEvent::TRACE_DEQUEUE, &task);
+    runTask(task);
+}
+
+// 工作线程开始时注册自己的计数器
+void ThreadPool::registerWorkerStats(size_t threadId)
+{
+    std::unique_ptr<WorkerCounters> counters(new WorkerCounters(threadId));
+    counters->lastTransition = steadyNowNs();
+    tlsWorkerCounters = counters.get();
+    std::lock_guard<std::mutex> lock(statsMtx_);
+    workerCounters_.emplace_back(std::move(counters));
+}
+
+// 工作线程退出前把自己的计数器合并到已退出线程的统计中
+void ThreadPool::retireWorkerStats()
+{
+    std::lock_guard<std::mutex> lock(statsMtx_);
+    for (auto it = workerCounters_.begin(); it != workerCounters_.end(); ++it)
+    {
+        if (it->get() == tlsWorkerCounters)
+        {
+            WorkerCounters &c = **it;
+            retiredStats_.completed += c.completed.load(std::memory_order_relaxed);
+            retiredStats_.stolen += c.stolen.load(std::memory_order_relaxed);
+            retiredStats_.queueWait.merge(c.queueWait);
+            retiredStats_.execTime.merge(c.execTime);
+            workerCounters_.erase(it);
+            break;
+        }
+    }
+    tlsWorkerCounters = nullptr;
+}
+
+// 获取线程池的运行统计快照
+PoolStats ThreadPool::stats()
+{
+    PoolStats s;
+    s.submitted = submittedCount_.load();
+    s.rejected = rejectedCount_.load();
+    s.dropped = droppedCount_.load();
+    s.cancelled = cancelledCount_;
+    s.threadsCreated = threadsCreated_;
+    s.threadsReaped = threadsReaped_;
+    s.queueDepth = taskSize_;
+    s.curThreads = curThreadSize_;
+    s.idleThreads = idleThreadCount();
+
+    std::lock_guard<std::mutex> lock(statsMtx_);
+    s.callerRuns = callerRunCount_.load();
+    s.completed = retiredStats_.completed + s.callerRuns;
+    s.stolen = retiredStats_.stolen;
+    s.queueWait.merge(retiredStats_.queueWait);
+    s.execTime.merge(retiredStats_.execTime);
+    for (auto &counters : workerCounters_)
+    {
+        WorkerStats w;
+        w.threadId = counters->threadId;
+        w.completed = counters->completed.load(std::memory_order_relaxed);
+        w.stolen = counters->stolen.load(std::memory_order_relaxed);
+        w.busyNs = counters->busyNs.load(std::memory_order_relaxed);
+        w.idleNs = counters->idleNs.load(std::memory_order_relaxed);
+        s.completed += w.completed;
+        s.stolen += w.stolen;
+        s.queueWait.merge(counters->queueWait);
+        s.execTime.merge(counters->execTime);
+        s.workers.push_back(w);
+    }
+    return s;
+}
+
+// 开启执行跟踪
+void ThreadPool::enableTracing(size_t eventsPerThread)
+{
+    tracer_.enable(eventsPerThread);
+}
+
+// 关闭执行跟踪，已经记录的事件保留
+void ThreadPool::disableTracing()
+{
+    tracer_.disable();
+}
+
+// 导出执行跟踪
+std::string ThreadPool::traceJson() const
+{
+    return tracer_.toChromeTrace();
+}
+
+bool ThreadPool::dumpTrace(const std::string &path) const
+{
+    return tracer_.dump(path);
+}
+
+// 关闭线程池
+bool ThreadPool::shutdown(ShutdownMode mode, std::chrono::milliseconds timeout)
+{
+    // 工作线程自己也在threads_中，等待所有线程退出会永远等下去
+    if (tlsPool == this)
+    {
+        throw std::logic_error("shutdown() must not be called from a worker of the same thread pool.");
+    }
+    std::lock_guard<std::mutex> guard(shutdownMtx_);
+    bool bounded = timeout != std::chrono::milliseconds::max();
+    auto deadline = std::chrono::steady_clock::now() + (bounded ? timeout : std::chrono::milliseconds(0));
+    isShutdown_ = true; // 之后的提交不再放入任务队列
+    // 停止定时线程，还没有到期的任务不再执行
+    std::vector<std::shared_ptr<Task>> timers = timers_.stop();
+    for (auto &task : timers)
+    {
+        task->discard();
+    }
+    cancelledCount_ += timers.size();
+    if (mode == ShutdownMode::SHUTDOWN_CANCEL_PENDING)
+    {
+        cancelPending();
+    }
+    isPoolRunning_ = false;
+    // 先结束监督线程，之后不会再有新线程创建
+    if (supervisor_.joinable())
+    {
+        {
+            std::lock_guard<std::mutex> lock(supervisorMtx_);
+            supervisorCond_.notify_all();
+        }
+        supervisor_.join();
+    }
+    wakeWorkers(SIZE_MAX); // 唤醒所有挂起的线程
+
+    // 等待线程池中所有的线程返回（系统线程：阻塞&正在运行中）
+    bool exited = true;
+    {
+        std::unique_lock<std::mutex> lock(taskQueMtx_);
+        auto allExited = [&]() -> bool
+        { return threads_.size() == 0; };
+        if (bounded)
+        {
+            exited = exitCond_.wait_until(lock, deadline, allExited);
+        }
+        else
+        {
+            exitCond_.wait(lock, allExited); // 主线程阻塞
+        }
+    }
+    if (!exited)
+    {
+        // 超时：剩余的排队任务不再执行，正在执行的任务结束后线程退出
+        size_t n = cancelPending();
+        FLEXIPOOL_LOG_WARN("thread pool shutdown timed out, %zu pending tasks cancelled.", n);
+    }
+    else
+    {
+        /*
+        和checkStranded配对：先标记线程已经全部退出，再检查任务数量。
+        提交者先增加任务数量再检查标记，两边至少有一方能看到对方，迟到的任务一定会被取消
+        */
+        workersExited_ = true;
+        while (taskSize_ > 0)
+        {
+            cancelPending();
+            std::this_thread::yield(); // 计数已经增加的任务可能还没有入队
+        }
+    }
+    joinExitedThreads();
+    return exited;
+}
+
+// 线程池关闭之后的提交
+bool ThreadPool::pushAfterShutdown(QueuedTask &slot, SubmitPolicy policy)
+{
+    if (policy == SubmitPolicy::POLICY_CALLER_RUNS)
+    {
+        runInline(slot);
+        return true;
+    }
+    FLEXIPOOL_LOG_WARN("thread pool has been shut down, submit task failed.");
+    return false;
+}
+
+// 任务放入队列之后检查：所有线程都已经退出时，迟到的任务不会再被执行
+void ThreadPool::checkStranded()
+{
+    if (workersExited_)
+    {
+        cancelPending();
+    }
+}
+
+// 取消所有排队的任务
+size_t ThreadPool::cancelPending()
+{
+    std::vector<QueuedTask> cancelled;
+    QueuedTask slot;
+    {
+        std::lock_guard<std::mutex> lock(taskQueMtx_);
+        while (taskQue_.popLowest(slot) != PRIORITY_LEVELS)
+        {
+            levelSize_[static_cast<size_t>(slot.priority)]--;
+            taskSize_--;
+            cancelled.emplace_back(std::move(slot));
+        }
+        notFull_.notify_all(); // 阻塞等待队列空余的提交者
+    }
+    if (ringQue_ != nullptr)
+    {
+        while (popRingTask(slot))
+        {
+            cancelled.emplace_back(std::move(slot));
+        }
+    }
+    for (size_t i = 0; i < nodeShards_.size(); i++)
+    {
+        while (popNodeTask(i, slot))
+        {
+            cancelled.emplace_back(std::move(slot));
+        }
+    }
+    // 工作窃取模式的本地队列：任何线程都可以从顶部窃取
+    for (auto &que : workerQues_)
+    {
+        QueuedTask *box = nullptr;
+        while (que != nullptr && que->steal(box))
+        {
+            openTaskBox(box, slot);
+            taskSize_--;
+            cancelled.emplace_back(std::move(slot));
+        }
+    }
+    // 在锁外完成结果：回调中可能继续提交任务
+    for (auto &t : cancelled)
+    {
+        discardSlot(t);
+    }
+    cancelledCount_ += cancelled.size();
+    return cancelled.size();
+}
+
+// 工作线程退出前把自己移到exitedThreads_
+void ThreadPool::retireThread(size_t threadId)
+{
+    auto it = threads_.find(threadId);
+    if (it != threads_.end())
+    {
+        exitedThreads_.emplace_back(std::move(it->second));
+        threads_.erase(it);
+    }
+    exitCond_.notify_all();
+}
+
+// join已经退出的线程
+void ThreadPool::joinExitedThreads()
+{
+    std::vector<std::unique_ptr<Thread>> exited;
+    {
+        std::lock_guard<std::mutex> lock(taskQueMtx_);
+        exited.swap(exitedThreads_);
+    }
+    for (auto &thread : exited)
+    {
+        thread->join();
+    }
+}
+
+// 当前的线程数量
+size_t ThreadPool::threadCount() const
+{
+    return curThreadSize_;
+}
+
+// 当前没有在执行任务的线程数量
+size_t ThreadPool::idleThreadCount() const
+{
+    // 各个槽位分别读取，和线程数量不是同一时刻的值
+    size_t threads = curThreadSize_;
+    size_t busy = static_cast<size_t>(busyThreads_.load());
+    return threads > busy ? threads - busy : 0;
+}
+
+bool ThreadPool::checkRunningState() const
+{
+    return isPoolRunning_;
+}
+////////////////////////////////////// 线程方法实现
+// 线程构造函数
+std::atomic_size_t Thread::generateId_(0);
+Thread::Thread(ThreadFunc func)
+    : func_(func), threadId_(generateId_++)
+{
+}
+
+// 线程析构函数：还没有join的线程在这里等待结束
+Thread::~Thread()
+{
+    join();
+}
+
+// 启动线程
+void Thread::start()
+{
+    /*  创建一个线程来执行线程函数 线程池的所有线程从任务队列里面消费任务
+      线程对象由线程池持有，线程退出后由线程池join回收，关闭线程池的时间可以预期 */
+    thread_ = std::thread(func_, threadId_);
+}
+
+// 等待线程函数返回
+void Thread::join()
+{
+    if (!thread_.joinable())
+    {
+        return;
+    }
+    if (thread_.get_id() == std::this_thread::get_id())
+    {
+        thread_.detach(); // 不能join自己
+        return;
+    }
+    thread_.join();
+}
+
+// 获取线程Id
+size_t Thread::getId() const
+{
+    return threadId_;
+}
+///////////////////////////////////////// Task方法的实现
+Task::Task()
+    : result_(nullptr), observerIndex_(0), submitTime_(0), priority_(Priority::PRIORITY_NORMAL), holdsSlot_(false), pool_(nullptr), deadline_(0)
+{
+}
+
+void Task::exec()
+{
+    Task *outer = tlsCurrentTask; // 在任务中直接执行另一个任务时（POLICY_CALLER_RUNS）恢复外层任务
+    tlsCurrentTask = this;
+    Any any = run();            // 这里发生多态（带类型的任务在run中直接写入共享状态）
+    tlsCurrentTask = outer;
+    Result *res = takeResult(); // 用户可能已经丢弃了Result
+    if (res != nullptr)
+    {
+        res->setVal(std::move(any));
+    }
+    if (observer_ != nullptr)
+    {
+        observer_->taskDone(observerIndex_);
+    }
+}
+
+// 任务没有执行就被丢弃
+void Task::discard()
+{
+    onDiscard();
+    if (observer_ != nullptr)
+    {
+        observer_->taskDone(observerIndex_);
+    }
+}
+
+// 跳过已经取消的任务
+void Task::skip()
+{
+    onCancel();
+    if (observer_ != nullptr)
+    {
+        observer_->taskDone(observerIndex_);
+    }
+}
+
+// 默认和丢弃相同：用空的Any完成Result
+void Task::onCancel()
+{
+    onDiscard();
+}
+
+void Task::setCancellationToken(const CancellationToken &token)
+{
+    cancelState_ = token.state_;
+}
+
+void Task::setDeadline(std::chrono::steady_clock::time_point deadline)
+{
+    deadline_ = toSteadyNs(deadline);
+}
+
+bool Task::isCancelled() const
+{
+    return (cancelState_ != nullptr && cancelState_->cancelled.load(std::memory_order_acquire)) || (deadline_ != 0 && steadyNowNs() >= deadline_);
+}
+
+bool Task::expired(int64_t now) const
+{
+    return (cancelState_ != nullptr && cancelState_->cancelled.load(std::memory_order_acquire)) || (deadline_ != 0 && now >= deadline_);
+}
+
+// 挂起前的自旋次数：只有多核机器上正在执行任务的线程才自旋，单核机器上自旋只会推迟完成任务的线程
+static size_t completionSpin()
+{
+    static const size_t spin = std::thread::hardware_concurrency() > 1 ? RESULT_WAIT_SPIN : 0;
+    return inPoolTask() ? spin : 0;
+}
+
+void waitCompletion(Completion &completion)
+{
+    ThreadPool *pool = tlsPool;
+    if (pool != nullptr && inPoolTask())
+    {
+        while (!completion.isSet())
+        {
+            if (pool->helpOnce())
+                continue;
+            // 任务刚被其他线程取走或者正在入队，重新尝试
+            if (pool->hasRunnableTask())
+            {
+                std::this_thread::yield();
+                continue;
+            }
+            break;
+        }
+    }
+    completion.wait(completionSpin());
+}
+
+Task *Task::current()
+{
+    return tlsCurrentTask;
+}
+
+// 默认用空的Any完成Result
+void Task::onDiscard()
+{
+    Result *res = takeResult();
+    if (res != nullptr)
+    {
+        res->setVal(Any());
+    }
+}
+
+void Task::setResult(Result *res)
+{
+    result_.store(res, std::memory_order_release);
+}
+
+Result *Task::takeResult()
+{
+    return result_.exchange(nullptr, std::memory_order_acq_rel);
+}
+
+void Task::setLatch(std::shared_ptr<CountDownLatch> latch)
+{
+    setObserver(std::move(latch), 0);
+}
+
+void Task::setObserver(std::shared_ptr<TaskObserver> observer, size_t index)
+{
+    observer_ = std::move(observer);
+    observerIndex_ = index;
+}
+
+///////////////////////////////////// Result方法的实现
+Result::Result(Result &&other) : task_(std::move(other.task_)),   // 移动 shared_ptr
+                                 isValid_(other.isValid_.load()), // 复制 atomic_bool 的值
+                                 done_(false)
+{
+    // other 对象的状态已被修改，因此可以显式地设置它的成员变量
+    // 对于 std::atomic_bool，这不是必需的，但可以显式地设置为默认值
+    other.isValid_ = false;
+    if (task_ == nullptr)
+        return;
+    // 把任务重新绑定到当前对象；任务线程已经取走了other时，等它写完再把返回值搬过来
+    Result *expected = &other;
+    if (!task_->result_.compare_exchange_strong(expected, this, std::memory_order_acq_rel))
+    {
+        while (!other.done_.load(std::memory_order_acquire))
+        {
+            std::this_thread::yield();
+        }
+        any_ = std::move(other.any_);
+        completion_.set();
+        done_.store(true, std::memory_order_release);
+    }
+}
+
+Result::Result(std::shared_ptr<Task> task, bool isValid)
+    : task_(task), isValid_(isValid), done_(false)
+{
+    task_->setResult(this); // 构造时，把当前的Result对象绑定给task_对象
+}
+
+Result::~Result()
+{
+    if (task_ == nullptr)
+        return;
+    Result *expected = this;
+    if (task_->result_.compare_exchange_strong(expected, nullptr, std::memory_order_acq_rel))
+        return; // 任务还没有完成，之后不会再访问这个Result
+    // 任务线程已经取走了当前对象，写入返回值只需要很短的时间
+    while (!done_.load(std::memory_order_acquire))
+    {
+        std::this_thread::yield();
+    }
 }
 
 // setVal方法，获取任务执行完的返回值
@@ -319,7 +2161,8 @@ void Result::setVal(Any any)
 {
     // 存储task的返回值
     this->any_ = std::move(any);
-    sem_.post(); // 已经获取的任务的返回值，增加信号量资源
+    completion_.set(); // 没有等待者时只是一次原子交换
+    done_.store(true, std::memory_order_release);
 }
 
 // get方法，用户调用这个方法获取task的返回值
@@ -329,6 +2172,6 @@ Any Result::get()
     {
         return "";
     }
-    sem_.wait();            // task任务如果没有执行完，这里会阻塞用户的线程
+    waitCompletion(completion_); // task任务如果没有执行完，这里会阻塞用户的线程（工作线程中则执行其他任务）
     return std::move(any_); // Any不允许拷贝构造
 }
\ No newline at end of file
@@ -0,0 +1,91 @@
+#include "timerqueue.h"
+#include <chrono>
+
+TimerQueue::TimerQueue(FireFunc fire)
+    : fire_(std::move(fire)), nextSeq_(0), stopped_(false)
+{
+}
+
+TimerQueue::~TimerQueue()
+{
+    stop();
+}
+
+bool TimerQueue::add(int64_t due, std::shared_ptr<Task> task)
+{
+    std::lock_guard<std::mutex> lock(mtx_);
+    if (stopped_)
+    {
+        return false;
+    }
+    if (!thread_.joinable())
+    {
+        thread_ = std::thread(&TimerQueue::loop, this);
+    }
+    // 新任务比堆顶更早到期时才需要唤醒定时线程重新计算等待时间
+    bool earliest = heap_.empty() || due < heap_.top().due;
+    heap_.push(Entry{due, nextSeq_++, std::move(task)});
+    if (earliest)
+    {
+        cond_.notify_one();
+    }
+    return true;
+}
+
+std::vector<std::shared_ptr<Task>> TimerQueue::stop()
+{
+    std::vector<std::shared_ptr<Task>> pending;
+    std::thread thread;
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        stopped_ = true;
+        while (!heap_.empty())
+        {
+            pending.emplace_back(heap_.top().task);
+            heap_.pop();
+        }
+        thread.swap(thread_);
+        cond_.notify_one();
+    }
+    if (thread.joinable())
+    {
+        thread.join();
+    }
+    return pending;
+}
+
+size_t TimerQueue::size()
+{
+    std::lock_guard<std::mutex> lock(mtx_);
+    return heap_.size();
+}
+
+void TimerQueue::loop()
+{
+    std::vector<std::shared_ptr<Task>> due;
+    std::unique_lock<std::mutex> lock(mtx_);
+    while (!stopped_)
+    {
+        if (heap_.empty())
+        {
+            cond_.wait(lock);
+            continue;
+        }
+        int64_t now = steadyNowNs();
+        if (heap_.top().due > now)
+        {
+            cond_.wait_for(lock, std::chrono::nanoseconds(heap_.top().due - now));
+            continue;
+        }
+        // 取出所有已经到期的任务，在锁外整批交出去
+        while (!heap_.empty() && heap_.top().due <= now)
+        {
+            due.emplace_back(heap_.top().task);
+            heap_.pop();
+        }
+        lock.unlock();
+        fire_(due);
+        due.clear();
+        lock.lock();
+    }
+}
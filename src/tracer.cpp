@@ -0,0 +1,326 @@
+#include "tracer.h"
+#include <algorithm>
+#include <fstream>
+#include <cstdio>
+
+// 缓冲区中的一个事件，seq为2*序号+2表示写入完成，奇数表示正在写入
+struct TraceSlot
+{
+    std::atomic<uint64_t> seq;
+    std::atomic<int64_t> ts;
+    std::atomic<uint64_t> id;
+    std::atomic<uint64_t> meta; // 低8位事件类型，8~31位arg，高32位线程编号
+};
+
+// 导出时复制出来的事件
+struct TraceRecord
+{
+    int64_t ts;
+    uint64_t id;
+    uint64_t meta;
+};
+
+// 一个线程的环形缓冲区：只有绑定它的线程写入，导出线程按照序号校验读取
+class Tracer::Buffer
+{
+public:
+    explicit Buffer(size_t capacity) : slots_(new TraceSlot[capacity]), mask_(capacity - 1), head_(0), tid_(0)
+    {
+        for (size_t i = 0; i < capacity; i++)
+        {
+            slots_[i].seq.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    // 写入线程：覆盖最旧的槽位
+    void push(uint64_t id, uint64_t meta, int64_t ts)
+    {
+        uint64_t h = head_.load(std::memory_order_relaxed);
+        TraceSlot &slot = slots_[h & mask_];
+        slot.seq.store(2 * h + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        slot.ts.store(ts, std::memory_order_relaxed);
+        slot.id.store(id, std::memory_order_relaxed);
+        slot.meta.store(meta, std::memory_order_relaxed);
+        slot.seq.store(2 * h + 2, std::memory_order_release);
+        head_.store(h + 1, std::memory_order_release);
+    }
+
+    // 导出线程：复制还没有被覆盖的事件，读取期间被改写的槽位跳过
+    void snapshot(std::vector<TraceRecord> &out) const
+    {
+        uint64_t h = head_.load(std::memory_order_acquire);
+        uint64_t first = h > mask_ + 1 ? h - (mask_ + 1) : 0;
+        for (uint64_t i = first; i < h; i++)
+        {
+            const TraceSlot &slot = slots_[i & mask_];
+            uint64_t seq = slot.seq.load(std::memory_order_acquire);
+            if (seq != 2 * i + 2)
+                continue;
+            TraceRecord record;
+            record.ts = slot.ts.load(std::memory_order_relaxed);
+            record.id = slot.id.load(std::memory_order_relaxed);
+            record.meta = slot.meta.load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (slot.seq.load(std::memory_order_relaxed) != seq)
+                continue;
+            out.push_back(record);
+        }
+    }
+
+    uint32_t tid() const
+    {
+        return tid_;
+    }
+    // 绑定到一个新的线程，在Tracer的锁中调用
+    void rebind(uint32_t tid)
+    {
+        tid_ = tid;
+    }
+
+private:
+    std::unique_ptr<TraceSlot[]> slots_;
+    const uint64_t mask_;
+    std::atomic<uint64_t> head_; // 下一个写入的序号
+    uint32_t tid_;               // 当前绑定的线程在导出结果中的编号
+};
+
+// 当前线程在各个Tracer中的缓冲区：按照serial查找，都不一致时重新查找并轮流替换一项
+struct TraceBinding
+{
+    uint64_t serial;
+    void *buffer;
+};
+struct TraceBindings
+{
+    TraceBinding slots[TRACE_THREAD_BINDINGS];
+    size_t next; // 下一个被替换的位置
+};
+static thread_local TraceBindings tlsTraceBindings = {};
+static thread_local std::string tlsTraceName;
+static std::atomic<uint64_t> nextTracerSerial(1);
+
+Tracer::Tracer()
+    : enabled_(false), serial_(nextTracerSerial.fetch_add(1, std::memory_order_relaxed)), originNs_(0), capacity_(TRACE_BUFFER_EVENTS)
+{
+}
+
+Tracer::~Tracer() = default;
+
+void Tracer::enable(size_t eventsPerThread)
+{
+    std::lock_guard<std::mutex> lock(mtx_);
+    size_t capacity = 2;
+    while (capacity < eventsPerThread)
+        capacity <<= 1;
+    capacity_ = capacity;
+    if (originNs_ == 0)
+        originNs_ = steadyNowNs();
+    enabled_.store(true, std::memory_order_relaxed);
+}
+
+void Tracer::disable()
+{
+    enabled_.store(false, std::memory_order_relaxed);
+}
+
+void Tracer::setThreadName(const std::string &name)
+{
+    tlsTraceName = name;
+}
+
+void Tracer::append(TraceEvent event, const void *id, uint32_t arg, int64_t tsNs)
+{
+    Buffer *buffer = nullptr;
+    for (const TraceBinding &binding : tlsTraceBindings.slots)
+    {
+        if (binding.serial == serial_)
+        {
+            buffer = static_cast<Buffer *>(binding.buffer);
+            break;
+        }
+    }
+    if (buffer == nullptr)
+    {
+        buffer = bind();
+    }
+    uint64_t meta = static_cast<uint64_t>(event) | (static_cast<uint64_t>(arg & 0xFFFFFF) << 8) | (static_cast<uint64_t>(buffer->tid()) << 32);
+    buffer->push(reinterpret_cast<uintptr_t>(id), meta, tsNs);
+}
+
+Tracer::Buffer *Tracer::bind()
+{
+    std::lock_guard<std::mutex> lock(mtx_);
+    Buffer *buffer;
+    auto it = bound_.find(std::this_thread::get_id());
+    if (it != bound_.end())
+    {
+        buffer = it->second;
+    }
+    else
+    {
+        if (!free_.empty())
+        {
+            buffer = free_.back();
+            free_.pop_back();
+        }
+        else
+        {
+            buffers_.emplace_back(new Buffer(capacity_));
+            buffer = buffers_.back().get();
+        }
+        // 缓冲区换了线程就换一个编号，之前线程的事件仍然显示在之前的线程上
+        buffer->rebind(static_cast<uint32_t>(names_.size()));
+        names_.push_back(tlsTraceName.empty() ? "thread " + std::to_string(names_.size()) : tlsTraceName);
+        bound_.emplace(std::this_thread::get_id(), buffer);
+    }
+    TraceBinding &binding = tlsTraceBindings.slots[tlsTraceBindings.next++ % TRACE_THREAD_BINDINGS];
+    binding.serial = serial_;
+    binding.buffer = buffer;
+    return buffer;
+}
+
+void Tracer::releaseThread()
+{
+    std::lock_guard<std::mutex> lock(mtx_);
+    auto it = bound_.find(std::this_thread::get_id());
+    if (it != bound_.end())
+    {
+        free_.push_back(it->second);
+        bound_.erase(it);
+    }
+    for (TraceBinding &binding : tlsTraceBindings.slots)
+    {
+        if (binding.serial == serial_)
+        {
+            binding.serial = 0;
+            binding.buffer = nullptr;
+        }
+    }
+}
+
+// 追加JSON字符串（带引号），转义引号、反斜杠和控制字符
+static void appendJsonString(std::string &out, const std::string &s)
+{
+    out += '"';
+    for (char c : s)
+    {
+        if (c == '"' || c == '\\')
+        {
+            out += '\\';
+            out += c;
+        }
+        else if (static_cast<unsigned char>(c) < 0x20)
+        {
+            char buf[8];
+            snprintf(buf, sizeof(buf), "\\u%04x", static_cast<unsigned>(c));
+            out += buf;
+        }
+        else
+        {
+            out += c;
+        }
+    }
+    out += '"';
+}
+
+std::string Tracer::toChromeTrace() const
+{
+    std::vector<TraceRecord> records;
+    std::vector<std::string> names;
+    int64_t origin;
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        for (auto &buffer : buffers_)
+        {
+            buffer->snapshot(records);
+        }
+        names = names_;
+        origin = originNs_;
+    }
+    // 不同线程的缓冲区合并后按时间排序，提交和取出的事件在不同的线程上
+    std::stable_sort(records.begin(), records.end(), [](const TraceRecord &a, const TraceRecord &b)
+                     { return a.ts < b.ts; });
+
+    std::string out;
+    out.reserve(128 * (records.size() + names.size()) + 128);
+    out += "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+    out += "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"FlexiThreadPool\"}}";
+    for (size_t tid = 0; tid < names.size(); tid++)
+    {
+        char buf[96];
+        snprintf(buf, sizeof(buf), ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%zu,\"args\":{\"name\":", tid);
+        out += buf;
+        appendJsonString(out, names[tid]);
+        out += "}}";
+    }
+
+    std::vector<size_t> depth(names.size(), 0); // 每个线程打开的B事件层数，缓冲区开头被覆盖了B的E事件丢弃
+    for (const TraceRecord &record : records)
+    {
+        TraceEvent event = static_cast<TraceEvent>(record.meta & 0xFF);
+        unsigned arg = static_cast<unsigned>((record.meta >> 8) & 0xFFFFFF);
+        size_t tid = static_cast<size_t>(record.meta >> 32);
+        if (tid >= depth.size())
+            continue;
+        double ts = record.ts > origin ? (record.ts - origin) / 1000.0 : 0.0; // 微秒
+        unsigned long long id = static_cast<unsigned long long>(record.id);
+        char buf[512];
+        buf[0] = '\0';
+        switch (event)
+        {
+        case TraceEvent::TRACE_SUBMIT:
+            snprintf(buf, sizeof(buf),
+                     ",\n{\"name\":\"submit\",\"cat\":\"task\",\"ph\":\"i\",\"s\":\"t\",\"pid\":1,\"tid\":%zu,\"ts\":%.3f,\"args\":{\"task\":\"0x%llx\"}}"
+                     ",\n{\"name\":\"queued\",\"cat\":\"task\",\"ph\":\"b\",\"id\":\"0x%llx\",\"pid\":1,\"tid\":%zu,\"ts\":%.3f}",
+                     tid, ts, id, id, tid, ts);
+            break;
+        case TraceEvent::TRACE_DEQUEUE:
+            snprintf(buf, sizeof(buf), ",\n{\"name\":\"queued\",\"cat\":\"task\",\"ph\":\"e\",\"id\":\"0x%llx\",\"pid\":1,\"tid\":%zu,\"ts\":%.3f}", id, tid, ts);
+            break;
+        case TraceEvent::TRACE_START:
+            depth[tid]++;
+            snprintf(buf, sizeof(buf), ",\n{\"name\":\"task\",\"cat\":\"task\",\"ph\":\"B\",\"pid\":1,\"tid\":%zu,\"ts\":%.3f,\"args\":{\"task\":\"0x%llx\"}}", tid, ts, id);
+            break;
+        case TraceEvent::TRACE_SUBMIT_BLOCKED:
+            depth[tid]++;
+            snprintf(buf, sizeof(buf), ",\n{\"name\":\"submit blocked\",\"cat\":\"queue\",\"ph\":\"B\",\"pid\":1,\"tid\":%zu,\"ts\":%.3f,\"args\":{\"task\":\"0x%llx\"}}", tid, ts, id);
+            break;
+        case TraceEvent::TRACE_PARK:
+            depth[tid]++;
+            snprintf(buf, sizeof(buf), ",\n{\"name\":\"parked\",\"cat\":\"idle\",\"ph\":\"B\",\"pid\":1,\"tid\":%zu,\"ts\":%.3f}", tid, ts);
+            break;
+        case TraceEvent::TRACE_END:
+        case TraceEvent::TRACE_SUBMIT_RESUMED:
+        case TraceEvent::TRACE_UNPARK:
+            if (depth[tid] == 0)
+                break;
+            depth[tid]--;
+            snprintf(buf, sizeof(buf), ",\n{\"ph\":\"E\",\"pid\":1,\"tid\":%zu,\"ts\":%.3f}", tid, ts);
+            break;
+        case TraceEvent::TRACE_STEAL:
+            snprintf(buf, sizeof(buf), ",\n{\"name\":\"steal\",\"cat\":\"task\",\"ph\":\"i\",\"s\":\"t\",\"pid\":1,\"tid\":%zu,\"ts\":%.3f,\"args\":{\"task\":\"0x%llx\",\"victim\":%u}}", tid, ts, id, arg);
+            break;
+        case TraceEvent::TRACE_THREAD_SPAWN:
+            snprintf(buf, sizeof(buf), ",\n{\"name\":\"thread spawn\",\"cat\":\"thread\",\"ph\":\"i\",\"s\":\"p\",\"pid\":1,\"tid\":%zu,\"ts\":%.3f,\"args\":{\"thread\":%u}}", tid, ts, arg);
+            break;
+        case TraceEvent::TRACE_THREAD_REAP:
+            snprintf(buf, sizeof(buf), ",\n{\"name\":\"thread reap\",\"cat\":\"thread\",\"ph\":\"i\",\"s\":\"p\",\"pid\":1,\"tid\":%zu,\"ts\":%.3f,\"args\":{\"thread\":%u}}", tid, ts, arg);
+            break;
+        }
+        out += buf;
+    }
+    out += "\n]}\n";
+    return out;
+}
+
+bool Tracer::dump(const std::string &path) const
+{
+    std::ofstream file(path, std::ios::out | std::ios::trunc);
+    if (!file)
+    {
+        return false;
+    }
+    file << toChromeTrace();
+    return static_cast<bool>(file);
+}
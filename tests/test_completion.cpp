@@ -0,0 +1,92 @@
+/*
+Completion（一次性完成事件）：
+- 已经完成时wait立即返回，reset之后可以再次使用
+- set唤醒所有挂起的等待者
+- 压力测试：两个线程用两个Completion来回交接，每一轮都重置后再用，不会丢失唤醒
+*/
+#include "testing.h"
+#include "completion.h"
+#include <atomic>
+#include <thread>
+#include <vector>
+
+static void testSetWaitReset()
+{
+    testContext() = "set/wait/reset";
+    Completion c;
+    CHECK(!c.isSet());
+    c.set();
+    CHECK(c.isSet());
+    c.wait(); // 已经完成，立即返回
+    c.set();  // 重复set没有作用
+    CHECK(c.isSet());
+    c.reset();
+    CHECK(!c.isSet());
+    std::thread setter([&]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        c.set();
+    });
+    c.wait(16);
+    CHECK(c.isSet());
+    setter.join();
+}
+
+static void testManyWaiters()
+{
+    testContext() = "many waiters";
+    Completion c;
+    std::atomic<int> woken(0);
+    std::vector<std::thread> waiters;
+    for (int i = 0; i < 8; i++)
+    {
+        waiters.emplace_back([&]() {
+            c.wait();
+            woken++;
+        });
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    CHECK(woken.load() == 0);
+    c.set();
+    for (auto &t : waiters)
+    {
+        t.join();
+    }
+    CHECK(woken.load() == 8);
+}
+
+static void testPingPong()
+{
+    testContext() = "ping-pong";
+    const int ROUNDS = 20000;
+    Completion ping, pong;
+    int value = 0; // 由交接保护，不是原子变量
+    std::thread peer([&]() {
+        for (int i = 0; i < ROUNDS; i++)
+        {
+            ping.wait(i % 2 == 0 ? 0 : 64); // 交替测试直接挂起和先自旋
+            ping.reset();
+            value++;
+            pong.set();
+        }
+    });
+    bool inStep = true;
+    for (int i = 0; i < ROUNDS; i++)
+    {
+        value++;
+        ping.set();
+        pong.wait();
+        pong.reset();
+        inStep = inStep && value == 2 * (i + 1);
+    }
+    peer.join();
+    CHECK(inStep);
+    CHECK(value == 2 * ROUNDS);
+}
+
+int main()
+{
+    testSetWaitReset();
+    testManyWaiters();
+    testPingPong();
+    return testResult();
+}
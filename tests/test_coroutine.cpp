@@ -0,0 +1,76 @@
+/*
+C++20协程（只在FLEXIPOOL_COROUTINES=ON时编译）：
+- co_await pool.schedule()之后在工作线程中执行
+- co_await TypedResult：任务可能在等待前、等待中完成；已经完成时不在onReady中恢复协程，连续等待很多次栈不会增长
+- 嵌套的CoTask按照顺序返回结果，异常传递给等待者，syncWait重新抛出
+- 线程池关闭后schedule()在当前线程继续执行
+*/
+#include "testing.h"
+#include "coroutine.h"
+#include <atomic>
+#include <stdexcept>
+#include <thread>
+
+static CoTask<bool> onWorker(ThreadPool &pool)
+{
+    std::thread::id caller = std::this_thread::get_id();
+    co_await pool.schedule();
+    co_return std::this_thread::get_id() != caller;
+}
+
+// 反复等待很快完成的任务：完成和等待交替竞争
+static CoTask<long> awaitMany(ThreadPool &pool, int n)
+{
+    long sum = 0;
+    for (int i = 0; i < n; i++)
+    {
+        sum += co_await pool.submit([i]() { return i; });
+    }
+    co_return sum;
+}
+
+static CoTask<int> leaf(int v)
+{
+    if (v < 0)
+        throw std::domain_error("negative");
+    co_return v * 2;
+}
+
+static CoTask<int> nested(ThreadPool &pool)
+{
+    co_await pool.schedule();
+    int a = co_await leaf(1);
+    int b = co_await leaf(2);
+    co_return a + b;
+}
+
+static CoTask<int> failing(ThreadPool &pool)
+{
+    co_await pool.schedule();
+    co_return co_await leaf(-1);
+}
+
+static void testCoroutines(const PoolConfig &config)
+{
+    ThreadPool pool;
+    configurePool(pool, config);
+    pool.start(2);
+    CHECK(syncWait(onWorker(pool)));
+    const int N = 20000;
+    CHECK(syncWait(awaitMany(pool, N)) == static_cast<long>(N) * (N - 1) / 2);
+    CHECK(syncWait(nested(pool)) == 6);
+    CHECK_THROWS(syncWait(failing(pool)), std::domain_error);
+    // 在工作线程中等待：完成任务的线程可能就是等待的线程
+    TypedResult<long> inPool = pool.submit([&]() { return syncWait(awaitMany(pool, 100)); });
+    CHECK(inPool.get() == 100L * 99 / 2);
+    CHECK(syncWait(pool.submit([]() { return 5; })) == 5);
+
+    pool.shutdown();
+    CHECK(!syncWait(onWorker(pool))); // 放入队列失败，在当前线程继续
+}
+
+int main()
+{
+    forEachPoolConfig(testCoroutines);
+    return testResult();
+}
@@ -0,0 +1,144 @@
+/*
+ExecutorGroup（一个工作线程，执行顺序确定）：
+- 同一优先级内按照权重分配执行次数（步长调度），权重2的执行器得到两倍的执行次数
+- 空闲过的执行器重新变为非空时不会积累额度，不会连续占用线程
+- 高优先级的执行器先于低优先级执行
+- 执行器的排队上限只限制自己，超过时提交失败
+*/
+#include "testing.h"
+#include "executorgroup.h"
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+// 占住组里唯一的工作线程，之后提交的任务都在排队
+struct Gate
+{
+    std::atomic<bool> entered{false};
+    std::atomic<bool> open{false};
+    void block()
+    {
+        entered = true;
+        while (!open.load())
+            std::this_thread::yield();
+    }
+    void waitEntered()
+    {
+        while (!entered.load())
+            std::this_thread::yield();
+    }
+};
+
+// 只在工作线程中写入，get()返回之后读取
+static std::vector<char> runLog;
+
+static std::vector<TypedResult<void>> submitMany(Executor &executor, char tag, int n)
+{
+    std::vector<TypedResult<void>> results;
+    for (int i = 0; i < n; i++)
+    {
+        results.push_back(executor.submit([tag]() { runLog.push_back(tag); }));
+    }
+    return results;
+}
+
+static size_t countIn(size_t first, size_t n, char tag)
+{
+    size_t count = 0;
+    for (size_t i = first; i < first + n && i < runLog.size(); i++)
+    {
+        count += runLog[i] == tag;
+    }
+    return count;
+}
+
+static void waitAll(std::vector<TypedResult<void>> &results)
+{
+    for (auto &r : results)
+    {
+        r.get();
+    }
+}
+
+static void testWeights()
+{
+    ExecutorGroup group(1);
+    Executor &gateExec = group.createExecutor("gate");
+    Executor &a = group.createExecutor("a", 2);
+    Executor &b = group.createExecutor("b", 1);
+    runLog.clear();
+    Gate gate;
+    TypedResult<void> blocker = gateExec.submit([&]() { gate.block(); });
+    gate.waitEntered();
+    std::vector<TypedResult<void>> ra = submitMany(a, 'a', 300);
+    std::vector<TypedResult<void>> rb = submitMany(b, 'b', 300);
+    gate.open = true;
+    blocker.get();
+    waitAll(ra);
+    waitAll(rb);
+    CHECK(runLog.size() == 600);
+    // 两者都有积压时按照2:1执行
+    size_t aCount = countIn(0, 150, 'a');
+    CHECK(aCount >= 97 && aCount <= 103);
+    // completed()在结果完成之后才增加：关闭线程池等最后一个任务结束
+    CHECK(group.shutdown());
+    CHECK(a.completed() == 300 && b.completed() == 300);
+}
+
+static void testNoBankedCredit()
+{
+    ExecutorGroup group(1);
+    Executor &gateExec = group.createExecutor("gate");
+    Executor &a = group.createExecutor("a");
+    Executor &b = group.createExecutor("b");
+    runLog.clear();
+    // 只有a在执行，b一直空闲
+    std::vector<TypedResult<void>> warm = submitMany(a, 'a', 200);
+    waitAll(warm);
+    runLog.clear();
+    Gate gate;
+    TypedResult<void> blocker = gateExec.submit([&]() { gate.block(); });
+    gate.waitEntered();
+    std::vector<TypedResult<void>> ra = submitMany(a, 'a', 60);
+    std::vector<TypedResult<void>> rb = submitMany(b, 'b', 60);
+    gate.open = true;
+    blocker.get();
+    waitAll(ra);
+    waitAll(rb);
+    // 权重相同：b不会因为之前空闲而连续执行
+    size_t bCount = countIn(0, 40, 'b');
+    CHECK(bCount >= 17 && bCount <= 23);
+}
+
+static void testPriorityAndBound()
+{
+    ExecutorGroup group(1);
+    Executor &gateExec = group.createExecutor("gate", 1, Priority::PRIORITY_HIGH);
+    Executor &high = group.createExecutor("high", 1, Priority::PRIORITY_HIGH);
+    Executor &low = group.createExecutor("low", 8, Priority::PRIORITY_LOW);
+    low.setTaskQueMaxThreshHold(20);
+    runLog.clear();
+    Gate gate;
+    TypedResult<void> blocker = gateExec.submit([&]() { gate.block(); });
+    gate.waitEntered();
+    std::vector<TypedResult<void>> rl = submitMany(low, 'l', 20);
+    TypedResult<void> rejected = low.submit([]() {});
+    std::vector<TypedResult<void>> rh = submitMany(high, 'h', 20);
+    CHECK(low.pending() == 20);
+    gate.open = true;
+    blocker.get();
+    waitAll(rl);
+    waitAll(rh);
+    CHECK_THROWS(rejected.get(), std::runtime_error); // 超过low的排队上限
+    CHECK(countIn(0, 20, 'h') == 20);                  // 高优先级先执行，和权重无关
+    CHECK(countIn(20, 20, 'l') == 20);
+}
+
+int main()
+{
+    testWeights();
+    testNoBankedCredit();
+    testPriorityAndBound();
+    return testResult();
+}
@@ -0,0 +1,99 @@
+/*
+异步日志：
+- 多个线程写的日志都交给输出函数，每个线程内保持顺序
+- 线程局部的缓冲区析构之后写的日志（后析构的线程局部变量中）直接输出，不写入已经退役的缓冲区
+*/
+#include "testing.h"
+#include "logger.h"
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+static std::mutex sinkMtx;
+static std::vector<std::string> sunk;
+
+static void captureSink(const LogRecord &record)
+{
+    std::lock_guard<std::mutex> lock(sinkMtx);
+    sunk.push_back(record.msg);
+}
+
+static size_t countPrefix(const char *prefix)
+{
+    std::lock_guard<std::mutex> lock(sinkMtx);
+    size_t n = 0;
+    for (const std::string &msg : sunk)
+    {
+        n += msg.compare(0, std::strlen(prefix), prefix) == 0;
+    }
+    return n;
+}
+
+static void testThreads()
+{
+    const int THREADS = 4;
+    const int PER_THREAD = 500;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < THREADS; t++)
+    {
+        threads.emplace_back([t]() {
+            for (int i = 0; i < PER_THREAD; i++)
+            {
+                Logger::instance().log(LogLevel::LEVEL_ERROR, "order %d %d", t, i);
+            }
+        });
+    }
+    for (auto &t : threads)
+    {
+        t.join();
+    }
+    Logger::instance().flush();
+    std::lock_guard<std::mutex> lock(sinkMtx);
+    std::vector<int> last(THREADS, -1);
+    size_t seen = 0;
+    bool ordered = true;
+    for (const std::string &msg : sunk)
+    {
+        int t = 0, i = 0;
+        if (std::sscanf(msg.c_str(), "order %d %d", &t, &i) == 2)
+        {
+            ordered = ordered && i == last[static_cast<size_t>(t)] + 1;
+            last[static_cast<size_t>(t)] = i;
+            seen++;
+        }
+    }
+    CHECK(ordered);
+    CHECK(seen + Logger::instance().dropped() == static_cast<size_t>(THREADS * PER_THREAD));
+}
+
+// 先于日志缓冲区构造，所以后于它析构
+struct LateLogger
+{
+    ~LateLogger()
+    {
+        Logger::instance().log(LogLevel::LEVEL_ERROR, "late %d", 1);
+    }
+};
+
+static void testAfterBufferDestroyed()
+{
+    std::thread worker([]() {
+        static thread_local LateLogger late;
+        (void)late;
+        Logger::instance().log(LogLevel::LEVEL_ERROR, "late %d", 0); // 注册本线程的缓冲区
+    });
+    worker.join();
+    Logger::instance().flush();
+    CHECK(countPrefix("late ") == 2);
+}
+
+int main()
+{
+    Logger::instance().setSink(captureSink);
+    testThreads();
+    testAfterBufferDestroyed();
+    Logger::instance().setSink(nullptr);
+    return testResult();
+}
@@ -0,0 +1,155 @@
+/*
+Vyukov有界MPMC队列（环形缓冲区模式的任务队列）：
+- 容量向上取整为2的幂，满时push失败且元素不变，批量入队只放入能放下的前缀
+- 可以存放只能移动的类型，析构时销毁剩余的元素
+- 压力测试：多个生产者和消费者，每个元素恰好出队一次，同一个生产者的元素按照入队顺序出队
+*/
+#include "testing.h"
+#include "mpmcqueue.h"
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+static void testSingleThread()
+{
+    testContext() = "single thread";
+    MpmcQueue<int> q(5);
+    CHECK(q.capacity() == 8);
+    CHECK(q.size() == 0);
+    for (int i = 0; i < 8; i++)
+    {
+        int v = i;
+        CHECK(q.push(std::move(v)));
+    }
+    CHECK(q.full());
+    int extra = 100;
+    CHECK(!q.push(std::move(extra)));
+    CHECK(extra == 100);
+    int v = -1;
+    bool ordered = true;
+    for (int i = 0; i < 8; i++)
+    {
+        ordered = ordered && q.pop(v) && v == i;
+    }
+    CHECK(ordered);
+    CHECK(!q.pop(v));
+
+    // 批量入队：只剩4个空位时放入前4个
+    for (int i = 0; i < 4; i++)
+    {
+        int x = i;
+        q.push(std::move(x));
+    }
+    int batch[6] = {10, 11, 12, 13, 14, 15};
+    CHECK(q.pushBulk(batch, 6) == 4);
+    for (int i = 0; i < 4; i++)
+    {
+        q.pop(v);
+    }
+    CHECK(q.pop(v) && v == 10);
+}
+
+static void testMoveOnly()
+{
+    testContext() = "move-only";
+    std::shared_ptr<int> counter = std::make_shared<int>(0);
+    {
+        MpmcQueue<std::unique_ptr<std::shared_ptr<int>>> q(4);
+        for (int i = 0; i < 3; i++)
+        {
+            std::unique_ptr<std::shared_ptr<int>> p(new std::shared_ptr<int>(counter));
+            CHECK(q.push(std::move(p)));
+            CHECK(p == nullptr);
+        }
+        std::unique_ptr<std::shared_ptr<int>> out;
+        CHECK(q.pop(out) && out != nullptr);
+        CHECK(counter.use_count() == 4);
+    }
+    CHECK(counter.use_count() == 1); // 析构时销毁了剩下的两个元素
+}
+
+static void testConcurrent()
+{
+    testContext() = "concurrent";
+    const size_t PRODUCERS = 3;
+    const size_t CONSUMERS = 3;
+    const uint64_t PER_PRODUCER = 100000;
+    MpmcQueue<uint64_t> q(64);
+    std::atomic<size_t> producing(PRODUCERS);
+    std::vector<std::vector<uint64_t>> received(CONSUMERS);
+    std::vector<std::thread> threads;
+    for (size_t p = 0; p < PRODUCERS; p++)
+    {
+        threads.emplace_back([&, p]() {
+            for (uint64_t i = 0; i < PER_PRODUCER; i++)
+            {
+                uint64_t item = (static_cast<uint64_t>(p) << 32) | i;
+                while (!q.push(std::move(item)))
+                {
+                    std::this_thread::yield();
+                }
+            }
+            producing.fetch_sub(1);
+        });
+    }
+    for (size_t c = 0; c < CONSUMERS; c++)
+    {
+        threads.emplace_back([&, c]() {
+            uint64_t item = 0;
+            for (;;)
+            {
+                if (q.pop(item))
+                {
+                    received[c].push_back(item);
+                }
+                else if (producing.load() == 0)
+                {
+                    if (!q.pop(item))
+                        return;
+                    received[c].push_back(item);
+                }
+                else
+                {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    for (auto &t : threads)
+    {
+        t.join();
+    }
+    std::vector<std::vector<uint8_t>> seen(PRODUCERS, std::vector<uint8_t>(PER_PRODUCER, 0));
+    bool fifo = true;
+    for (auto &items : received)
+    {
+        std::vector<int64_t> last(PRODUCERS, -1);
+        for (uint64_t item : items)
+        {
+            size_t p = static_cast<size_t>(item >> 32);
+            int64_t i = static_cast<int64_t>(item & 0xffffffffu);
+            fifo = fifo && i > last[p];
+            last[p] = i;
+            seen[p][static_cast<size_t>(i)]++;
+        }
+    }
+    CHECK(fifo);
+    size_t once = 0;
+    for (auto &s : seen)
+    {
+        for (uint8_t n : s)
+        {
+            once += n == 1;
+        }
+    }
+    CHECK(once == PRODUCERS * PER_PRODUCER);
+}
+
+int main()
+{
+    testSingleThread();
+    testMoveOnly();
+    testConcurrent();
+    return testResult();
+}
@@ -0,0 +1,120 @@
+/*
+Pipeline：
+- 串行阶段按照读取输入的顺序处理，并行阶段可以乱序
+- 在途的条目数量不超过令牌数量
+- 阶段抛出异常后停止读取输入，run()重新抛出第一个异常；同一个流水线可以再次执行
+- 线程池关闭之后run()不再读取输入并抛出异常
+*/
+#include "testing.h"
+#include "pipeline.h"
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+static void testOrderAndTokens(const PoolConfig &config)
+{
+    const size_t TOKENS = 6;
+    const int N = 3000;
+    ThreadPool pool;
+    configurePool(pool, config);
+    pool.start(4);
+    int next = 0;
+    std::atomic<int> live(0), maxLive(0);
+    std::vector<int> out;
+    Pipeline pipe(pool, TOKENS);
+    pipe.source<std::unique_ptr<int>>([&](std::unique_ptr<int> &p) {
+            if (next == N)
+                return false;
+            p.reset(new int(next++));
+            int l = ++live;
+            int m = maxLive.load();
+            while (l > m && !maxLive.compare_exchange_weak(m, l))
+            {
+            }
+            return true;
+        })
+        .then(StageMode::STAGE_PARALLEL, [](std::unique_ptr<int> &&p) {
+            if (*p % 5 == 0)
+                std::this_thread::yield(); // 打乱并行阶段的完成顺序
+            return std::to_string(*p);
+        })
+        .then(StageMode::STAGE_SERIAL_IN_ORDER, [&](std::string &&s) {
+            out.push_back(std::stoi(s));
+            return s.size();
+        })
+        .then(StageMode::STAGE_PARALLEL, [&](size_t) { live--; });
+    for (int round = 0; round < 2; round++)
+    {
+        next = 0;
+        out.clear();
+        pipe.run();
+        bool ordered = out.size() == static_cast<size_t>(N);
+        for (int i = 0; ordered && i < N; i++)
+        {
+            ordered = out[static_cast<size_t>(i)] == i;
+        }
+        CHECK(ordered);
+        CHECK(live.load() == 0);
+    }
+    CHECK(maxLive.load() >= 1);
+    CHECK(maxLive.load() <= static_cast<int>(TOKENS));
+
+    // 在工作线程中执行
+    next = 0;
+    out.clear();
+    pool.submit([&]() { pipe.run(); }).get();
+    CHECK(out.size() == static_cast<size_t>(N));
+}
+
+static void testErrors(const PoolConfig &config)
+{
+    ThreadPool pool;
+    configurePool(pool, config);
+    pool.start(3);
+    int read = 0;
+    std::atomic<int> reached(0);
+    Pipeline bad(pool, 4);
+    bad.source<int>([&](int &v) {
+           v = read++;
+           return true; // 无限输入，只能因为异常停止
+       })
+        .then(StageMode::STAGE_PARALLEL, [](int v) {
+            if (v == 50)
+                throw std::invalid_argument("bad item");
+            return v;
+        })
+        .then(StageMode::STAGE_SERIAL_IN_ORDER, [&](int) { reached++; });
+    CHECK_THROWS(bad.run(), std::invalid_argument);
+    CHECK(reached.load() <= 50); // 出错的条目之后的条目不再进入串行阶段
+    CHECK(read < 50 + 2 * 4);    // 出错的条目占着令牌，之后最多再读取令牌数量的条目
+
+    int count = 0;
+    Pipeline sourceOnly(pool);
+    sourceOnly.source<int>([&](int &v) {
+        v = count;
+        return ++count <= 10;
+    });
+    sourceOnly.run();
+    CHECK(count == 11);
+
+    Pipeline empty(pool);
+    CHECK_THROWS(empty.run(), std::logic_error);
+
+    pool.shutdown();
+    int after = 0;
+    Pipeline closed(pool);
+    closed.source<int>([&](int &v) {
+              v = after++;
+              return after <= 100;
+          })
+        .then(StageMode::STAGE_SERIAL_IN_ORDER, [](int) {});
+    CHECK_THROWS(closed.run(), std::runtime_error);
+}
+
+int main()
+{
+    forEachPoolConfig(testOrderAndTokens);
+    forEachPoolConfig(testErrors);
+    return testResult();
+}
@@ -0,0 +1,242 @@
+/*
+post提交的可调用对象（直接存放在任务队列的槽位中）：
+- 只能移动的可调用对象和超过内部缓冲区的可调用对象都能执行，每个只执行一次
+- 工作线程中post的任务（工作窃取模式放入本地队列）同样执行
+- 抛出的异常被记录后忽略，不影响之后的任务
+- 可调用对象中等待其他任务的结果时帮忙执行排队的任务，只有一个线程也不会死锁
+- 开启优先级并发上限时每次执行都归还名额
+- POLICY_DROP_OLDEST丢弃、关闭时取消的可调用对象不执行，并且被销毁
+*/
+#include "testing.h"
+#include "logger.h"
+#include <atomic>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+
+// 占住一个工作线程，之后提交的任务都在排队
+struct Gate
+{
+    std::atomic<bool> entered{false};
+    std::atomic<bool> open{false};
+    void block()
+    {
+        entered = true;
+        while (!open.load())
+            std::this_thread::yield();
+    }
+    void waitEntered()
+    {
+        while (!entered.load())
+            std::this_thread::yield();
+    }
+};
+
+// 析构时计数：被丢弃的可调用对象也一定被销毁
+struct Counted
+{
+    explicit Counted(std::atomic<int> *destroyed) : destroyed_(destroyed) {}
+    ~Counted()
+    {
+        (*destroyed_)++;
+    }
+    std::atomic<int> *destroyed_;
+};
+
+// 只能移动的可调用对象（C++11没有初始化捕获）
+struct AddValue
+{
+    AddValue(std::unique_ptr<int> value, std::atomic<int> *sum) : value_(std::move(value)), sum_(sum) {}
+    void operator()()
+    {
+        *sum_ += *value_;
+    }
+    std::unique_ptr<int> value_;
+    std::atomic<int> *sum_;
+};
+
+// 可调用对象抛出的异常记录的日志
+static std::atomic<int> thrownLogs(0);
+
+static void captureSink(const LogRecord &record)
+{
+    thrownLogs += std::strncmp(record.msg, "posted task threw", 17) == 0;
+}
+
+static void waitFor(std::atomic<int> &value, int expected)
+{
+    while (value.load() < expected)
+        std::this_thread::yield();
+}
+
+static void testMoveOnly(const PoolConfig &config)
+{
+    const int N = 2000;
+    ThreadPool pool;
+    configurePool(pool, config);
+    pool.start(4);
+    std::atomic<int> sum(0), large(0);
+    for (int i = 0; i < N; i++)
+    {
+        std::unique_ptr<int> value(new int(i));
+        CHECK(pool.post(AddValue(std::move(value), &sum)));
+    }
+    // 放不进内部缓冲区的可调用对象存放在堆上
+    char padding[FUNCTION_INLINE_SIZE * 2] = {1};
+    for (int i = 0; i < 100; i++)
+    {
+        CHECK(pool.post([padding, &large]() { large += padding[0]; }));
+    }
+    waitFor(large, 100);
+    while (pool.stats().completed < static_cast<uint64_t>(N + 100))
+        std::this_thread::yield();
+    CHECK(sum.load() == N * (N - 1) / 2);
+    CHECK(large.load() == 100);
+}
+
+static void testPostFromWorker(const PoolConfig &config)
+{
+    ThreadPool pool;
+    configurePool(pool, config);
+    pool.start(3);
+    std::atomic<int> ran(0);
+    for (int i = 0; i < 50; i++)
+    {
+        pool.post([&]() {
+            for (int j = 0; j < 20; j++)
+            {
+                pool.post([&]() { ran++; });
+            }
+        });
+    }
+    waitFor(ran, 1000);
+    CHECK(ran.load() == 1000);
+}
+
+static void testThrowing(const PoolConfig &config)
+{
+    ThreadPool pool;
+    configurePool(pool, config);
+    pool.start(1);
+    thrownLogs = 0;
+    std::atomic<int> ran(0);
+    pool.post([]() { throw std::runtime_error("posted"); });
+    pool.post([]() { throw 1; });
+    pool.post([&]() { ran++; });
+    waitFor(ran, 1);
+    TypedResult<int> after = pool.submit([]() { return 5; });
+    CHECK(after.get() == 5);
+    Logger::instance().flush();
+    CHECK(thrownLogs.load() == 2);
+}
+
+static void testWaitInside(const PoolConfig &config)
+{
+    ThreadPool pool;
+    configurePool(pool, config);
+    pool.setThreadMaxThreshHold(1); // cached模式下不再创建线程
+    pool.start(1);
+    std::atomic<int> sum(0);
+    pool.post([&]() {
+        TypedResult<int> inner = pool.submit([]() { return 21; });
+        sum += inner.get() * 2;
+    });
+    waitFor(sum, 42);
+    CHECK(sum.load() == 42);
+}
+
+static void testConcurrencyCap(const PoolConfig &config)
+{
+    ThreadPool pool;
+    configurePool(pool, config);
+    // 重复释放或者泄漏名额都会让后面的任务无法执行
+    pool.setPriorityConcurrency(Priority::PRIORITY_NORMAL, 1);
+    pool.start(3);
+    std::atomic<int> ran(0), running(0);
+    std::atomic<bool> overlapped(false);
+    for (int i = 0; i < 300; i++)
+    {
+        pool.post([&]() {
+            if (running.fetch_add(1) != 0)
+                overlapped = true;
+            ran++;
+            running.fetch_sub(1);
+        });
+    }
+    waitFor(ran, 300);
+    TypedResult<int> normal = pool.submit([]() { return 3; });
+    CHECK(normal.get() == 3);
+    CHECK(!overlapped);
+}
+
+static void testDropOldest(const PoolConfig &config)
+{
+    const int QUEUE = 8;
+    std::atomic<int> ran(0), destroyed(0);
+    {
+        ThreadPool pool;
+        configurePool(pool, config);
+        pool.setTaskQueMaxThreshHold(QUEUE);
+        pool.setSubmitPolicy(SubmitPolicy::POLICY_DROP_OLDEST);
+        pool.setThreadMaxThreshHold(1); // cached模式下不再创建线程，排队的任务一直排队
+        pool.start(1);
+        Gate gate;
+        TypedResult<void> blocker = pool.submit([&]() { gate.block(); });
+        gate.waitEntered();
+        for (int i = 0; i < QUEUE * 3; i++)
+        {
+            std::shared_ptr<Counted> counted = std::make_shared<Counted>(&destroyed);
+            CHECK(pool.post([counted, &ran]() { ran++; }));
+        }
+        CHECK(destroyed.load() == QUEUE * 2); // 最老的可调用对象被丢弃并立即销毁
+        gate.open = true;
+        blocker.get();
+        waitFor(ran, QUEUE);
+        CHECK(pool.stats().dropped == static_cast<uint64_t>(QUEUE * 2));
+    }
+    CHECK(ran.load() == QUEUE);
+    CHECK(destroyed.load() == QUEUE * 3);
+}
+
+static void testCancelPending(const PoolConfig &config)
+{
+    std::atomic<int> ran(0), destroyed(0);
+    {
+        ThreadPool pool;
+        configurePool(pool, config);
+        pool.setThreadMaxThreshHold(1);
+        pool.start(1);
+        Gate gate;
+        TypedResult<void> blocker = pool.submit([&]() { gate.block(); });
+        gate.waitEntered();
+        for (int i = 0; i < 20; i++)
+        {
+            std::shared_ptr<Counted> counted = std::make_shared<Counted>(&destroyed);
+            pool.post([counted, &ran]() { ran++; });
+        }
+        std::thread opener([&]() {
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            gate.open = true;
+        });
+        CHECK(pool.shutdown(ShutdownMode::SHUTDOWN_CANCEL_PENDING));
+        opener.join();
+        CHECK(destroyed.load() == 20);
+        CHECK(pool.stats().cancelled >= 20);
+    }
+    CHECK(ran.load() == 0);
+}
+
+int main()
+{
+    forEachPoolConfig(testMoveOnly);
+    forEachPoolConfig(testPostFromWorker);
+    Logger::instance().setSink(captureSink);
+    forEachPoolConfig(testThrowing);
+    Logger::instance().setSink(nullptr);
+    forEachPoolConfig(testWaitInside);
+    forEachPoolConfig(testConcurrencyCap);
+    forEachPoolConfig(testDropOldest);
+    forEachPoolConfig(testCancelPending);
+    return testResult();
+}
@@ -0,0 +1,118 @@
+/*
+ResultSet：
+- next()和范围for按照完成的顺序返回编号，每个编号只返回一次
+- waitAny()返回最先完成的任务，waitAll()在所有任务完成后返回
+- 提交失败的任务立即算作完成；没有任务时waitAny()和next()返回npos
+*/
+#include "testing.h"
+#include "resultset.h"
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+// 等到released变为true才完成的任务，返回自己的编号
+class GatedTask : public Task
+{
+public:
+    GatedTask(int id, std::atomic<bool> *released) : id_(id), released_(released) {}
+    Any run()
+    {
+        while (!released_->load())
+            std::this_thread::yield();
+        return id_;
+    }
+
+private:
+    int id_;
+    std::atomic<bool> *released_;
+};
+
+static void testCompletionOrder(const PoolConfig &config)
+{
+    const size_t N = 4;
+    ThreadPool pool;
+    configurePool(pool, config);
+    pool.start(N);
+    std::unique_ptr<std::atomic<bool>[]> released(new std::atomic<bool>[N]);
+    for (size_t i = 0; i < N; i++)
+    {
+        released[i] = false;
+    }
+    ResultSet set(pool);
+    for (size_t i = 0; i < N; i++)
+    {
+        CHECK(set.submitTask(std::make_shared<GatedTask>(static_cast<int>(i), &released[i])) == i);
+    }
+    CHECK(set.completed() == 0);
+    // 按照2、0、3、1的顺序放行，next()依次返回同样的顺序
+    const size_t order[N] = {2, 0, 3, 1};
+    released[order[0]] = true;
+    CHECK(set.waitAny() == order[0]);
+    for (size_t k = 0; k < N; k++)
+    {
+        released[order[k]] = true;
+        size_t i = set.next();
+        CHECK(i == order[k]);
+        CHECK(set.get(i).cast_<int>() == static_cast<int>(i));
+    }
+    CHECK(set.next() == ResultSet::npos);
+    CHECK(set.completed() == N);
+}
+
+static void testManyTasks(const PoolConfig &config)
+{
+    const size_t N = 2000;
+    ThreadPool pool;
+    configurePool(pool, config);
+    pool.start(3);
+    std::atomic<bool> open(true);
+    ResultSet set(pool);
+    for (size_t i = 0; i < N; i++)
+    {
+        set.submitTask(std::make_shared<GatedTask>(static_cast<int>(i), &open));
+    }
+    set.waitAll();
+    CHECK(set.completed() == N);
+    std::vector<int> seen(N, 0);
+    long sum = 0;
+    for (size_t i : set)
+    {
+        seen[i]++;
+        sum += set.get(i).cast_<int>();
+    }
+    bool once = true;
+    for (int n : seen)
+    {
+        once = once && n == 1;
+    }
+    CHECK(once);
+    CHECK(sum == static_cast<long>(N) * (N - 1) / 2);
+}
+
+static void testEmptyAndFailed(const PoolConfig &config)
+{
+    ThreadPool pool;
+    configurePool(pool, config);
+    pool.start(2);
+    ResultSet empty(pool);
+    CHECK(empty.waitAny() == ResultSet::npos);
+    CHECK(empty.next() == ResultSet::npos);
+    empty.waitAll();
+
+    pool.shutdown();
+    std::atomic<bool> open(true);
+    ResultSet failed(pool);
+    failed.submitTask(std::make_shared<GatedTask>(1, &open));
+    failed.waitAll(); // 提交失败的任务不会让等待永远阻塞
+    CHECK(failed.completed() == 1);
+    CHECK(failed.next() == 0);
+}
+
+int main()
+{
+    forEachPoolConfig(testCompletionOrder);
+    forEachPoolConfig(testManyTasks);
+    forEachPoolConfig(testEmptyAndFailed);
+    return testResult();
+}
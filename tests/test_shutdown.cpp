@@ -0,0 +1,174 @@
+/*
+线程池关闭：
+- SHUTDOWN_DRAIN执行完所有排队的任务
+- SHUTDOWN_CANCEL_PENDING等待正在执行的任务，排队的任务以“任务被丢弃”完成，统计计入cancelled
+- 超时返回false并取消剩余的排队任务，正在执行的任务在析构时等待
+- 关闭之后：POLICY_CALLER_RUNS在提交者线程中执行，其余策略提交失败；可以重复调用shutdown
+- 在工作线程中调用shutdown抛出异常，不会永远等待自己退出
+*/
+#include "testing.h"
+#include <atomic>
+#include <thread>
+#include <vector>
+
+// 让一个任务占住唯一的工作线程，之后提交的任务都在排队
+struct Gate
+{
+    std::atomic<bool> entered{false};
+    std::atomic<bool> open{false};
+    void block()
+    {
+        entered = true;
+        while (!open.load())
+            std::this_thread::yield();
+    }
+    void waitEntered()
+    {
+        while (!entered.load())
+            std::this_thread::yield();
+    }
+};
+
+static void testDrain(const PoolConfig &config)
+{
+    ThreadPool pool;
+    configurePool(pool, config);
+    pool.start(2);
+    std::atomic<int> ran(0);
+    std::vector<TypedResult<int>> results;
+    for (int i = 0; i < 500; i++)
+    {
+        results.push_back(pool.submit([&, i]() {
+            ran++;
+            return i;
+        }));
+    }
+    CHECK(pool.shutdown(ShutdownMode::SHUTDOWN_DRAIN));
+    CHECK(ran.load() == 500);
+    long sum = 0;
+    for (auto &r : results)
+    {
+        sum += r.get();
+    }
+    CHECK(sum == 500L * 499 / 2);
+    CHECK(pool.shutdown()); // 重复调用
+}
+
+static void testCancelPending(const PoolConfig &config)
+{
+    ThreadPool pool;
+    configurePool(pool, config);
+    pool.setThreadMaxThreshHold(1); // cached模式下不再创建线程，排队的任务一直排队
+    pool.start(1);
+    Gate gate;
+    TypedResult<int> running = pool.submit([&]() {
+        gate.block();
+        return 7;
+    });
+    gate.waitEntered();
+    std::atomic<int> ran(0);
+    std::vector<TypedResult<int>> queued;
+    for (int i = 0; i < 50; i++)
+    {
+        queued.push_back(pool.submit([&]() {
+            ran++;
+            return 1;
+        }));
+    }
+    std::thread opener([&]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        gate.open = true;
+    });
+    CHECK(pool.shutdown(ShutdownMode::SHUTDOWN_CANCEL_PENDING));
+    opener.join();
+    CHECK(running.get() == 7); // 正在执行的任务正常完成
+    CHECK(ran.load() == 0);
+    int discarded = 0;
+    for (auto &r : queued)
+    {
+        try
+        {
+            r.get();
+        }
+        catch (const std::runtime_error &)
+        {
+            discarded++;
+        }
+    }
+    CHECK(discarded == 50);
+    CHECK(pool.stats().cancelled == 50);
+}
+
+static void testTimeout(const PoolConfig &config)
+{
+    Gate gate;
+    std::atomic<int> ran(0);
+    {
+        ThreadPool pool;
+        configurePool(pool, config);
+        pool.setThreadMaxThreshHold(1);
+        pool.start(1);
+        pool.submit([&]() {
+            gate.block();
+            return 0;
+        });
+        gate.waitEntered();
+        std::vector<TypedResult<int>> queued;
+        for (int i = 0; i < 10; i++)
+        {
+            queued.push_back(pool.submit([&]() {
+                ran++;
+                return 1;
+            }));
+        }
+        CHECK(!pool.shutdown(ShutdownMode::SHUTDOWN_DRAIN, std::chrono::milliseconds(30)));
+        for (auto &r : queued)
+        {
+            CHECK_THROWS(r.get(), std::runtime_error); // 超时后剩余的排队任务被取消
+        }
+        gate.open = true; // 析构时等待正在执行的任务
+    }
+    CHECK(ran.load() == 0);
+}
+
+static void testSubmitAfterShutdown(const PoolConfig &config)
+{
+    ThreadPool pool;
+    configurePool(pool, config);
+    pool.start(2);
+    pool.shutdown();
+    TypedResult<int> failed = pool.submit([]() { return 1; });
+    CHECK_THROWS(failed.get(), std::runtime_error);
+    CHECK(!pool.post([]() {}));
+
+    pool.setSubmitPolicy(SubmitPolicy::POLICY_CALLER_RUNS);
+    std::thread::id runner;
+    TypedResult<int> inline_ = pool.submit([&]() {
+        runner = std::this_thread::get_id();
+        return 2;
+    });
+    CHECK(inline_.get() == 2);
+    CHECK(runner == std::this_thread::get_id());
+}
+
+static void testShutdownFromWorker(const PoolConfig &config)
+{
+    ThreadPool pool;
+    configurePool(pool, config);
+    pool.start(2);
+    TypedResult<bool> inTask = pool.submit([&]() { return pool.shutdown(); });
+    CHECK_THROWS(inTask.get(), std::logic_error);
+    TypedResult<int> next = pool.submit([]() { return 4; }); // 线程池没有关闭
+    CHECK(next.get() == 4);
+    CHECK(pool.shutdown());
+}
+
+int main()
+{
+    forEachPoolConfig(testDrain);
+    forEachPoolConfig(testCancelPending);
+    forEachPoolConfig(testTimeout);
+    forEachPoolConfig(testSubmitAfterShutdown);
+    forEachPoolConfig(testShutdownFromWorker);
+    return testResult();
+}
@@ -0,0 +1,128 @@
+/*
+Strand（串行执行器）：
+- 同一个strand的任务按照提交顺序执行，不会同时执行；多个提交者并发提交时保持各自的顺序
+- 超过STRAND_BATCH的积压也能全部执行完
+- 线程池关闭之后提交失败，get()抛出异常
+*/
+#include "testing.h"
+#include "strand.h"
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+// 一个strand的执行记录：只在strand的任务中写入
+struct StrandLog
+{
+    std::atomic<int> running{0};
+    std::atomic<bool> overlapped{false};
+    std::vector<uint64_t> order;
+};
+
+static void testOrdering(const PoolConfig &config)
+{
+    const size_t STRANDS = 4;
+    const size_t PRODUCERS = 3;
+    const uint64_t PER_PRODUCER = 2000;
+    ThreadPool pool;
+    configurePool(pool, config);
+    pool.start(4);
+    std::vector<std::unique_ptr<Strand>> strands;
+    std::vector<std::unique_ptr<StrandLog>> logs;
+    for (size_t i = 0; i < STRANDS; i++)
+    {
+        strands.emplace_back(new Strand(pool));
+        logs.emplace_back(new StrandLog());
+    }
+    std::vector<std::thread> producers;
+    for (size_t p = 0; p < PRODUCERS; p++)
+    {
+        producers.emplace_back([&, p]() {
+            for (uint64_t i = 0; i < PER_PRODUCER; i++)
+            {
+                size_t s = static_cast<size_t>(i % STRANDS);
+                StrandLog *log = logs[s].get();
+                uint64_t tag = (static_cast<uint64_t>(p) << 32) | i;
+                strands[s]->submit([log, tag]() {
+                    if (log->running.fetch_add(1) != 0)
+                        log->overlapped = true;
+                    log->order.push_back(tag);
+                    log->running.fetch_sub(1);
+                });
+            }
+        });
+    }
+    for (auto &t : producers)
+    {
+        t.join();
+    }
+    for (size_t s = 0; s < STRANDS; s++)
+    {
+        strands[s]->submit([]() {}).get(); // 之前提交的任务都已经执行完
+    }
+    for (size_t s = 0; s < STRANDS; s++)
+    {
+        StrandLog &log = *logs[s];
+        CHECK(!log.overlapped);
+        CHECK(log.order.size() == PRODUCERS * PER_PRODUCER / STRANDS);
+        std::vector<int64_t> last(PRODUCERS, -1);
+        bool ordered = true;
+        for (uint64_t tag : log.order)
+        {
+            size_t p = static_cast<size_t>(tag >> 32);
+            int64_t i = static_cast<int64_t>(tag & 0xffffffffu);
+            ordered = ordered && i > last[p];
+            last[p] = i;
+        }
+        CHECK(ordered);
+        // 任务执行完之后才减少pending，get()返回时可能还没有减少
+        for (int spin = 0; spin < 100000 && strands[s]->pending() != 0; spin++)
+            std::this_thread::yield();
+        CHECK(strands[s]->pending() == 0);
+    }
+}
+
+static void testBacklogAndShutdown(const PoolConfig &config)
+{
+    ThreadPool pool;
+    configurePool(pool, config);
+    pool.start(2);
+    Strand strand(pool);
+    // 积压多批任务：排空任务会重新排队，最终全部按顺序执行
+    std::atomic<bool> go(false);
+    strand.submit([&]() {
+        while (!go.load())
+            std::this_thread::yield();
+    });
+    int next = 0;
+    bool ordered = true;
+    std::vector<TypedResult<int>> results;
+    for (int i = 0; i < static_cast<int>(STRAND_BATCH) * 5; i++)
+    {
+        results.push_back(strand.submit([&, i]() {
+            ordered = ordered && next == i;
+            next++;
+            return i;
+        }));
+    }
+    go = true;
+    int sum = 0;
+    for (auto &r : results)
+    {
+        sum += r.get();
+    }
+    CHECK(ordered);
+    CHECK(next == static_cast<int>(STRAND_BATCH) * 5);
+    CHECK(sum == next * (next - 1) / 2);
+
+    pool.shutdown();
+    TypedResult<int> late = strand.submit([]() { return 1; });
+    CHECK_THROWS(late.get(), std::runtime_error);
+}
+
+int main()
+{
+    forEachPoolConfig(testOrdering);
+    forEachPoolConfig(testBacklogAndShutdown);
+    return testResult();
+}
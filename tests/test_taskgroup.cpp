@@ -0,0 +1,91 @@
+/*
+TaskGroup（spawn/sync）：
+- 递归拆分的任务在任意线程池模式下都能完成（工作线程中sync时执行排队的任务，不会死锁）
+- 子任务的第一个异常在sync中重新抛出，之后任务组可以继续使用
+- 压力测试：反复创建、派生、等待、销毁任务组，最后一个子任务结束之前sync不会返回
+*/
+#include "testing.h"
+#include "taskgroup.h"
+#include <atomic>
+#include <numeric>
+#include <vector>
+
+static long parallelSum(ThreadPool &pool, const int *p, size_t n)
+{
+    if (n <= 256)
+    {
+        return std::accumulate(p, p + n, 0L);
+    }
+    long left = 0;
+    TaskGroup group(pool);
+    group.spawn([&]() { left = parallelSum(pool, p, n / 2); });
+    long right = parallelSum(pool, p + n / 2, n - n / 2);
+    group.sync();
+    return left + right;
+}
+
+static void testRecursive(const PoolConfig &config)
+{
+    ThreadPool pool;
+    configurePool(pool, config);
+    pool.start(3);
+    std::vector<int> data(100000);
+    std::iota(data.begin(), data.end(), 0);
+    long expected = std::accumulate(data.begin(), data.end(), 0L);
+    // 在池外和工作线程中各执行一次
+    CHECK(parallelSum(pool, data.data(), data.size()) == expected);
+    TypedResult<long> inPool = pool.submit([&]() { return parallelSum(pool, data.data(), data.size()); });
+    CHECK(inPool.get() == expected);
+}
+
+static void testExceptions(const PoolConfig &config)
+{
+    ThreadPool pool;
+    configurePool(pool, config);
+    pool.start(2);
+    TaskGroup group(pool);
+    std::atomic<int> ran(0);
+    for (int i = 0; i < 20; i++)
+    {
+        group.spawn([&, i]() {
+            ran++;
+            if (i == 7)
+                throw std::logic_error("child failed");
+        });
+    }
+    CHECK_THROWS(group.sync(), std::logic_error);
+    CHECK(ran.load() == 20);
+    CHECK(group.pending() == 0);
+    // 异常已经交给sync，之后正常使用
+    group.spawn([&]() { ran++; });
+    group.sync();
+    CHECK(ran.load() == 21);
+}
+
+static void testLifetime(const PoolConfig &config)
+{
+    ThreadPool pool;
+    configurePool(pool, config);
+    pool.start(3);
+    std::atomic<int> total(0);
+    for (int round = 0; round < 2000; round++)
+    {
+        // sync返回后立即销毁任务组：子任务在这之后不能再访问它
+        TaskGroup *group = new TaskGroup(pool);
+        for (int i = 0; i < 4; i++)
+        {
+            group->spawn([&]() { total++; });
+        }
+        group->sync();
+        delete group;
+    }
+    CHECK(total.load() == 8000);
+}
+
+int main()
+{
+    forEachPoolConfig(testRecursive);
+    forEachPoolConfig(testExceptions);
+    forEachPoolConfig(testLifetime);
+    return testResult();
+}
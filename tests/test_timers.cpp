@@ -0,0 +1,78 @@
+/*
+定时任务：
+- submitAfter/submitAt不会早于到期时间执行
+- scheduleEvery反复执行、不会同时执行，取消令牌之后停止
+- 周期很短并且开启优先级并发上限时，每次执行都正确归还名额
+- 线程池关闭时还没有到期的任务被取消
+*/
+#include "testing.h"
+#include <atomic>
+#include <thread>
+
+static void testDelayed(const PoolConfig &config)
+{
+    ThreadPool pool;
+    configurePool(pool, config);
+    pool.start(2);
+    std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+    TypedResult<std::chrono::steady_clock::time_point> after =
+        pool.submitAfter(std::chrono::milliseconds(20), []() { return std::chrono::steady_clock::now(); });
+    std::chrono::steady_clock::time_point when = begin + std::chrono::milliseconds(30);
+    TypedResult<std::chrono::steady_clock::time_point> at =
+        pool.submitAt(when, []() { return std::chrono::steady_clock::now(); });
+    CHECK(after.get() >= begin + std::chrono::milliseconds(20));
+    CHECK(at.get() >= when);
+}
+
+static void testPeriodic(const PoolConfig &config)
+{
+    ThreadPool pool;
+    configurePool(pool, config);
+    // 每次执行都占用一个NORMAL名额：重复释放或者泄漏名额都会让后面的任务无法执行
+    pool.setPriorityConcurrency(Priority::PRIORITY_NORMAL, 1);
+    pool.start(3);
+    std::atomic<int> runs(0), running(0);
+    std::atomic<bool> overlapped(false);
+    CancellationToken token = pool.scheduleEvery(std::chrono::nanoseconds(1), [&]() {
+        if (running.fetch_add(1) != 0)
+            overlapped = true;
+        runs++;
+        running.fetch_sub(1);
+    });
+    while (runs.load() < 200)
+    {
+        std::this_thread::yield();
+    }
+    token.cancel();
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    int stopped = runs.load();
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    CHECK(runs.load() == stopped); // 取消之后不再执行
+    CHECK(!overlapped);
+    // 周期任务结束后名额已经归还
+    TypedResult<int> normal = pool.submit([]() { return 3; });
+    CHECK(normal.get() == 3);
+}
+
+static void testShutdownCancelsTimers(const PoolConfig &config)
+{
+    std::atomic<int> ran(0);
+    TypedResult<int> late;
+    {
+        ThreadPool pool;
+        configurePool(pool, config);
+        pool.start(1);
+        late = pool.submitAfter(std::chrono::seconds(30), [&]() { return ++ran; });
+        CHECK(pool.shutdown());
+    }
+    CHECK_THROWS(late.get(), std::runtime_error);
+    CHECK(ran.load() == 0);
+}
+
+int main()
+{
+    forEachPoolConfig(testDelayed);
+    forEachPoolConfig(testPeriodic);
+    forEachPoolConfig(testShutdownCancelsTimers);
+    return testResult();
+}
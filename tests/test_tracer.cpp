@@ -0,0 +1,70 @@
+/*
+执行跟踪：
+- 一个线程交替记录到多个Tracer（嵌套线程池、ExecutorGroup和它的线程池），事件写入各自的缓冲区
+- Tracer数量超过线程缓存的绑定数量时仍然正确，每个Tracer中这个线程只出现一次
+- 线程池开启跟踪后导出任务的开始和结束事件
+*/
+#include "testing.h"
+#include "tracer.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+static size_t countOf(const std::string &text, const std::string &pattern)
+{
+    size_t n = 0;
+    for (size_t pos = text.find(pattern); pos != std::string::npos; pos = text.find(pattern, pos + pattern.size()))
+    {
+        n++;
+    }
+    return n;
+}
+
+static void testInterleaved()
+{
+    const size_t TRACERS = TRACE_THREAD_BINDINGS + 2;
+    const size_t ROUNDS = 100;
+    std::vector<std::unique_ptr<Tracer>> tracers;
+    for (size_t i = 0; i < TRACERS; i++)
+    {
+        tracers.emplace_back(new Tracer());
+        tracers.back()->enable();
+    }
+    int marker = 0;
+    for (size_t round = 0; round < ROUNDS; round++)
+    {
+        for (size_t i = 0; i < TRACERS; i++)
+        {
+            tracers[i]->record(TraceEvent::TRACE_START, &marker);
+            tracers[i]->record(TraceEvent::TRACE_END, &marker);
+        }
+    }
+    for (size_t i = 0; i < TRACERS; i++)
+    {
+        std::string json = tracers[i]->toChromeTrace();
+        CHECK(countOf(json, "\"name\":\"task\",\"cat\":\"task\",\"ph\":\"B\"") == ROUNDS);
+        CHECK(countOf(json, "\"thread_name\"") == 1);
+        tracers[i]->releaseThread();
+    }
+}
+
+static void testPool(const PoolConfig &config)
+{
+    ThreadPool pool;
+    configurePool(pool, config);
+    pool.enableTracing();
+    pool.start(2);
+    for (int i = 0; i < 50; i++)
+    {
+        pool.submit([]() {}).get();
+    }
+    std::string json = pool.traceJson();
+    CHECK(countOf(json, "\"name\":\"task\",\"cat\":\"task\",\"ph\":\"B\"") >= 50);
+}
+
+int main()
+{
+    testInterleaved();
+    forEachPoolConfig(testPool);
+    return testResult();
+}
@@ -0,0 +1,118 @@
+/*
+Chase-Lev工作窃取队列：
+- 拥有者从底部后进先出，窃取者从顶部先进先出，扩容后元素不丢失
+- 压力测试：拥有者一边压入一边弹出，多个窃取者同时窃取，每个元素恰好被取走一次
+*/
+#include "testing.h"
+#include "workstealingqueue.h"
+#include <atomic>
+#include <thread>
+#include <vector>
+
+static void testSingleThread()
+{
+    testContext() = "single thread";
+    WorkStealingQueue<size_t> q(4);
+    size_t item = 0;
+    CHECK(q.empty());
+    CHECK(!q.pop(item));
+    CHECK(!q.steal(item));
+    // 超过初始容量，触发扩容
+    for (size_t i = 0; i < 1000; i++)
+    {
+        q.push(i);
+    }
+    CHECK(q.size() == 1000);
+    CHECK(q.steal(item) && item == 0); // 顶部是最老的元素
+    CHECK(q.steal(item) && item == 1);
+    CHECK(q.pop(item) && item == 999); // 底部是最新的元素
+    CHECK(q.pop(item) && item == 998);
+    size_t expected = 997;
+    bool ordered = true;
+    while (q.pop(item))
+    {
+        ordered = ordered && item == expected;
+        expected--;
+    }
+    CHECK(ordered);
+    CHECK(expected == 1);
+    CHECK(q.empty());
+}
+
+static void testConcurrentSteal()
+{
+    testContext() = "concurrent steal";
+    const size_t N = 200000;
+    const size_t THIEVES = 3;
+    WorkStealingQueue<size_t> q(8);
+    std::vector<std::atomic<uint8_t>> taken(N);
+    for (auto &t : taken)
+    {
+        t.store(0, std::memory_order_relaxed);
+    }
+    std::atomic<bool> done(false);
+    std::atomic<size_t> stolen(0);
+    std::vector<std::thread> thieves;
+    for (size_t i = 0; i < THIEVES; i++)
+    {
+        thieves.emplace_back([&]() {
+            size_t item = 0;
+            for (;;)
+            {
+                if (q.steal(item))
+                {
+                    taken[item].fetch_add(1, std::memory_order_relaxed);
+                    stolen.fetch_add(1, std::memory_order_relaxed);
+                }
+                else if (done.load(std::memory_order_acquire))
+                {
+                    // 拥有者已经停止压入：再确认一次队列为空
+                    if (!q.steal(item))
+                        return;
+                    taken[item].fetch_add(1, std::memory_order_relaxed);
+                    stolen.fetch_add(1, std::memory_order_relaxed);
+                }
+                else
+                {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    size_t popped = 0;
+    size_t item = 0;
+    for (size_t i = 0; i < N; i++)
+    {
+        q.push(i);
+        // 每压入三个弹出一个，和窃取者竞争最后一个元素
+        if (i % 3 == 0 && q.pop(item))
+        {
+            taken[item].fetch_add(1, std::memory_order_relaxed);
+            popped++;
+        }
+    }
+    while (q.pop(item))
+    {
+        taken[item].fetch_add(1, std::memory_order_relaxed);
+        popped++;
+    }
+    done.store(true, std::memory_order_release);
+    for (auto &t : thieves)
+    {
+        t.join();
+    }
+    size_t once = 0;
+    for (auto &t : taken)
+    {
+        once += t.load() == 1;
+    }
+    CHECK(once == N);
+    CHECK(popped + stolen.load() == N);
+}
+
+int main()
+{
+    testSingleThread();
+    testConcurrentSteal();
+    return testResult();
+}
@@ -0,0 +1,99 @@
+#ifndef TESTING_H
+#define TESTING_H
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <vector>
+#include "threadpool.h"
+
+/*
+测试用的最小断言，不依赖测试框架：
+- CHECK失败时打印位置和表达式并计数，测试继续执行
+- main返回testResult()，ctest按照退出码判断是否通过
+- forEachPoolConfig对三种线程池模式（以及两种队列实现）各执行一次，失败信息带上模式名
+*/
+inline int &testFailures()
+{
+    static int failures = 0;
+    return failures;
+}
+
+inline std::string &testContext()
+{
+    static std::string context;
+    return context;
+}
+
+#define CHECK(expr)                                                                                       \
+    do                                                                                                    \
+    {                                                                                                     \
+        if (!(expr))                                                                                      \
+        {                                                                                                 \
+            std::fprintf(stderr, "%s:%d: [%s] CHECK failed: %s\n", __FILE__, __LINE__, testContext().c_str(), #expr); \
+            testFailures()++;                                                                             \
+        }                                                                                                 \
+    } while (0)
+
+// expr必须抛出Exception
+#define CHECK_THROWS(expr, Exception) \
+    do                                \
+    {                                 \
+        bool thrown = false;          \
+        try                           \
+        {                             \
+            (void)(expr);             \
+        }                             \
+        catch (const Exception &)     \
+        {                             \
+            thrown = true;            \
+        }                             \
+        CHECK(thrown && #expr);       \
+    } while (0)
+
+inline int testResult()
+{
+    if (testFailures() != 0)
+    {
+        std::fprintf(stderr, "%d check(s) failed\n", testFailures());
+        return 1;
+    }
+    return 0;
+}
+
+// 一种线程池配置：名字用于失败信息
+struct PoolConfig
+{
+    const char *name;
+    PoolMode mode;
+    TaskQueMode queMode;
+};
+
+inline const std::vector<PoolConfig> &poolConfigs()
+{
+    static const std::vector<PoolConfig> configs = {
+        {"fixed", PoolMode::MODE_FIXED, TaskQueMode::MODE_LOCKED},
+        {"fixed/ring", PoolMode::MODE_FIXED, TaskQueMode::MODE_RING_BUFFER},
+        {"cached", PoolMode::MODE_CACHED, TaskQueMode::MODE_LOCKED},
+        {"stealing", PoolMode::MODE_WORK_STEALING, TaskQueMode::MODE_LOCKED},
+    };
+    return configs;
+}
+
+// 按照config设置还没有启动的线程池
+inline void configurePool(ThreadPool &pool, const PoolConfig &config)
+{
+    pool.setPoolMode(config.mode);
+    pool.setTaskQueMode(config.queMode);
+}
+
+// 对每种线程池配置执行一次func
+inline void forEachPoolConfig(const std::function<void(const PoolConfig &)> &func)
+{
+    for (const PoolConfig &config : poolConfigs())
+    {
+        testContext() = config.name;
+        func(config);
+    }
+    testContext().clear();
+}
+#endif